@@ -1,16 +1,18 @@
 #include "ArcBall.h"
 
+#include <windows.h>
+
 ArcBall::ArcBall(void)
     : is_dragged_(false),
 	  radius_(1.0f),
-	  previous_point_(D3DXVECTOR3(0, 0, 0)),
-	  current_point_(D3DXVECTOR3(0, 0, 0)),
-	  old_point_(D3DXVECTOR3(0, 0, 0)),
-	  previous_quaternion_(D3DXQUATERNION(0, 0, 0, 1)),
-      current_quaternion_(D3DXQUATERNION(0, 0, 0, 1)),
-      rotation_increament_(D3DXQUATERNION(0, 0, 0, 1))
+	  previous_point_(Vector3(0, 0, 0)),
+	  current_point_(Vector3(0, 0, 0)),
+	  old_point_(Vector3(0, 0, 0)),
+	  previous_quaternion_(Quaternion(0, 0, 0, 1)),
+      current_quaternion_(Quaternion(0, 0, 0, 1)),
+      rotation_increament_(Quaternion(0, 0, 0, 1))
 {
-	D3DXMatrixIdentity(&rotate_matrix_);
+	MatrixIdentity(&rotate_matrix_);
 
 	RECT rc ;
 	GetClientRect(GetForegroundWindow(), &rc) ;
@@ -27,10 +29,10 @@ ArcBall::~ArcBall(void)
 
 void ArcBall::Reset()
 {
-	D3DXQuaternionIdentity(&previous_quaternion_);
-	D3DXQuaternionIdentity(&current_quaternion_);
-	D3DXQuaternionIdentity(&rotation_increament_) ;
-	D3DXMatrixIdentity(&rotate_matrix_);
+	QuaternionIdentity(&previous_quaternion_);
+	QuaternionIdentity(&current_quaternion_);
+	QuaternionIdentity(&rotation_increament_) ;
+	MatrixIdentity(&rotate_matrix_);
 	is_dragged_ = false;
 	radius_ = 1.0f;
 }
@@ -64,6 +66,24 @@ void ArcBall::OnEnd()
 	is_dragged_ = false ;
 }
 
+bool ArcBall::IsDragged() const
+{
+	return is_dragged_ ;
+}
+
+Quaternion ArcBall::GetRotation() const
+{
+	return current_quaternion_ ;
+}
+
+void ArcBall::SetRotation(const Quaternion& rotation)
+{
+	previous_quaternion_ = rotation ;
+	current_quaternion_ = rotation ;
+	QuaternionIdentity(&rotation_increament_) ;
+	is_dragged_ = false ;
+}
+
 void ArcBall::SetWindow(int window_width, int window_height, float arcball_radius)
 {
 	 window_width_  = window_width; 
@@ -71,33 +91,33 @@ void ArcBall::SetWindow(int window_width, int window_height, float arcball_radiu
 	 radius_		= arcball_radius; 
 }
 
-const D3DXMATRIX* ArcBall::GetRotationMatrix()
+const Matrix* ArcBall::GetRotationMatrix()
 {
-	return D3DXMatrixRotationQuaternion(&rotate_matrix_, &current_quaternion_) ;
+	return MatrixRotationQuaternion(&rotate_matrix_, &current_quaternion_) ;
 }
 
-D3DXQUATERNION ArcBall::GetRotationQuatIncreament()
+Quaternion ArcBall::GetRotationQuatIncreament()
 {
 	return rotation_increament_ ;
 }
 
-D3DXQUATERNION ArcBall::QuatFromBallPoints(D3DXVECTOR3& start_point, D3DXVECTOR3& end_point)
+Quaternion ArcBall::QuatFromBallPoints(Vector3& start_point, Vector3& end_point)
 {
 	// Calculate rotate angle
-	float angle = D3DXVec3Dot(&start_point, &end_point);	
+	float angle = Vec3Dot(&start_point, &end_point);	
 
 	// Calculate rotate axis
-	D3DXVECTOR3 axis;
-	D3DXVec3Cross(&axis, &start_point, &end_point);		
+	Vector3 axis;
+	Vec3Cross(&axis, &start_point, &end_point);		
 
 	// Build and Normalize the Quaternion
-	D3DXQUATERNION quat(axis.x, axis.y, axis.z, angle);
-	D3DXQuaternionNormalize(&quat, &quat);
+	Quaternion quat(axis.x, axis.y, axis.z, angle);
+	QuaternionNormalize(&quat, &quat);
 
 	return quat;
 }
 
-D3DXVECTOR3 ArcBall::ScreenToVector(int screen_x, int screen_y)
+Vector3 ArcBall::ScreenToVector(int screen_x, int screen_y)
 {
 	// Scale to screen
 	float x = -(screen_x - window_width_ / 2) / (radius_ * window_width_ / 2);
@@ -115,5 +135,5 @@ D3DXVECTOR3 ArcBall::ScreenToVector(int screen_x, int screen_y)
 	else
 		z = sqrtf(1.0f - mag);
 
-	return D3DXVECTOR3(x, y, z);
+	return Vector3(x, y, z);
 }
@@ -1,7 +1,7 @@
 #ifndef __ARCBALL_H__
 #define __ARCBALL_H__
 
-#include "d3dx9.h"
+#include "VectorMath.h"
 
 class ArcBall
 {
@@ -14,10 +14,13 @@ public:
 	void OnBegin(int mouse_x, int mouse_y) ;
 	void OnMove(int mouse_x, int mouse_y) ;
 	void OnEnd() ;
+	bool IsDragged() const ;
+	Quaternion GetRotation() const ;
+	void SetRotation(const Quaternion& rotation) ;	// Ends the drag
 
-	D3DXQUATERNION QuatFromBallPoints(D3DXVECTOR3& start_point, D3DXVECTOR3& end_point);
-	const D3DXMATRIX* GetRotationMatrix() ;
-	D3DXQUATERNION GetRotationQuatIncreament() ;
+	Quaternion QuatFromBallPoints(Vector3& start_point, Vector3& end_point);
+	const Matrix* GetRotationMatrix() ;
+	Quaternion GetRotationQuatIncreament() ;
 	void SetWindow(int window_width, int window_height, float arcball_radius = 1.0f) ;
 
 private:
@@ -26,16 +29,16 @@ private:
 	float	radius_ ;	     // arc ball's radius in screen coordinates
 	bool	is_dragged_ ;	 // whether the arc ball is dragged
 
-	D3DXQUATERNION	previous_quaternion_ ;	// quaternion before mouse down
-	D3DXQUATERNION	current_quaternion_ ;	// current quaternion
-	D3DXQUATERNION	rotation_increament_ ;	// rotation increment 
-	D3DXVECTOR3		previous_point_ ;		// starting point of arc ball rotate
-	D3DXVECTOR3		current_point_ ;		// current point of arc ball rotate
-	D3DXVECTOR3		old_point_ ;			// old point 
-	D3DXMATRIXA16	rotate_matrix_;			// rotation matrix
+	Quaternion	previous_quaternion_ ;	// quaternion before mouse down
+	Quaternion	current_quaternion_ ;	// current quaternion
+	Quaternion	rotation_increament_ ;	// rotation increment 
+	Vector3		previous_point_ ;		// starting point of arc ball rotate
+	Vector3		current_point_ ;		// current point of arc ball rotate
+	Vector3		old_point_ ;			// old point 
+	MatrixA16	rotate_matrix_;			// rotation matrix
 
 	// Convert scree point to arcball point(vector)
-	D3DXVECTOR3	ScreenToVector(int screen_x, int screen_y) ;
+	Vector3	ScreenToVector(int screen_x, int screen_y) ;
 
 };
 
@@ -0,0 +1,92 @@
+#include "Arena.h"
+
+Arena::Arena(void)
+	: block_(NULL),
+	  capacity_(0),
+	  used_(0),
+	  peak_used_(0)
+{
+}
+
+Arena::~Arena(void)
+{
+	Release();
+}
+
+void Arena::Init(size_t capacity)
+{
+	Release();
+
+	block_     = new char[capacity];
+	capacity_  = capacity;
+	used_      = 0;
+	peak_used_ = 0;
+}
+
+void Arena::Release()
+{
+	delete []block_;
+	block_     = NULL;
+	capacity_  = 0;
+	used_      = 0;
+	peak_used_ = 0;
+}
+
+// The padding is counted from the address, not from the start of the block, so the block itself needs no alignment
+void* Arena::Allocate(size_t size, size_t alignment)
+{
+	size_t address = (size_t)(block_ + used_);
+	size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+	if (block_ == NULL || used_ + padding + size > capacity_)
+		return NULL;
+
+	void* memory = block_ + used_ + padding;
+	used_ += padding + size;
+	if (used_ > peak_used_)
+		peak_used_ = used_;
+
+	return memory;
+}
+
+size_t Arena::GetMarker() const
+{
+	return used_;
+}
+
+void Arena::Rewind(size_t marker)
+{
+	if (marker < used_)
+		used_ = marker;
+}
+
+void Arena::Reset()
+{
+	used_ = 0;
+}
+
+size_t Arena::GetUsed() const
+{
+	return used_;
+}
+
+size_t Arena::GetPeakUsed() const
+{
+	return peak_used_;
+}
+
+size_t Arena::GetCapacity() const
+{
+	return capacity_;
+}
+
+ArenaScope::ArenaScope(Arena* arena)
+	: arena_(arena),
+	  marker_(arena->GetMarker())
+{
+}
+
+ArenaScope::~ArenaScope(void)
+{
+	arena_->Rewind(marker_);
+}
@@ -0,0 +1,87 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+#include <new>
+
+// A bump allocator over one block of memory. Allocate only moves a pointer forward, nothing is
+// freed one by one: a puzzle-lifetime arena is released as a whole with its owner, a scratch arena
+// is rewound to a marker(ArenaScope) when a move or a search is done with its temporaries.
+// The destructors of the objects in the arena are never called, so only objects which own no
+// other memory may be allocated from it.
+class Arena
+{
+public:
+	static const size_t kDefaultAlignment = 16;		// Enough for any type and for SSE loads
+
+	Arena(void);
+	~Arena(void);
+
+	// Allocate the block of capacity bytes, the previous block is released
+	void Init(size_t capacity);
+	void Release();
+
+	// size bytes at a multiple of alignment(a power of 2), NULL if the arena is full
+	void* Allocate(size_t size, size_t alignment = kDefaultAlignment);
+
+	// count default constructed objects, NULL if the arena is full
+	template <typename T>
+	T* NewArray(int count);
+
+	// Bytes an array of count T takes in the arena at most, including the alignment padding,
+	// the capacity for a set of arrays is the sum of their sizes
+	template <typename T>
+	static size_t GetArraySize(int count);
+
+	// Scratch use, everything allocated after the marker is dropped by Rewind
+	size_t GetMarker() const;
+	void Rewind(size_t marker);
+	void Reset();
+
+	size_t GetUsed() const;
+	size_t GetPeakUsed() const;		// Highest GetUsed since Init, to size a scratch arena
+	size_t GetCapacity() const;
+
+private:
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+
+private:
+	char* block_;
+	size_t capacity_;
+	size_t used_;
+	size_t peak_used_;
+};
+
+// Rewinds a scratch arena to where it was when the scope began
+class ArenaScope
+{
+public:
+	explicit ArenaScope(Arena* arena);
+	~ArenaScope(void);
+
+private:
+	Arena* arena_;
+	size_t marker_;
+};
+
+template <typename T>
+T* Arena::NewArray(int count)
+{
+	T* objects = (T*)Allocate(count * sizeof(T));
+	if (objects == NULL)
+		return NULL;
+
+	for (int i = 0; i < count; ++i)
+		new (&objects[i]) T();
+
+	return objects;
+}
+
+template <typename T>
+size_t Arena::GetArraySize(int count)
+{
+	return count * sizeof(T) + kDefaultAlignment - 1;
+}
+
+#endif // end __ARENA_H__
@@ -5,10 +5,14 @@ Camera::Camera(void)
 	  min_radius_(50),
 	  max_radius_(300),
 	  mouse_wheel_delta_(0),
-	  frame_need_update_(false)
+	  mouse_moved_(false),
+	  mouse_x_(0),
+	  mouse_y_(0),
+	  frame_need_update_(false),
+	  version_(0)
 {
-	D3DXMatrixIdentity(&world_matrix_);
-	D3DXMatrixIdentity(&view_matrix_);
+	MatrixIdentity(&world_matrix_);
+	MatrixIdentity(&view_matrix_);
 }
 
 Camera::~Camera(void)
@@ -18,8 +22,9 @@ Camera::~Camera(void)
 void Camera::Reset()
 {
 	frame_need_update_ = false ;
-	D3DXMatrixIdentity(&world_matrix_) ;
+	MatrixIdentity(&world_matrix_) ;
 	view_arcball_.Reset();
+	++version_ ;
 }
 
 // Update the scene for every frame
@@ -30,6 +35,13 @@ void Camera::OnFrameMove()
 		return ;
 	frame_need_update_ = false ;
 
+	// Only the last mouse position since the previous frame turns the arc ball
+	if(mouse_moved_)
+	{
+		view_arcball_.OnMove(mouse_x_, mouse_y_) ;
+		mouse_moved_ = false ;
+	}
+
 	if(mouse_wheel_delta_)
 	{
 		radius_ -= mouse_wheel_delta_ * radius_ * 0.1f / 360.0f;
@@ -44,23 +56,24 @@ void Camera::OnFrameMove()
 	mouse_wheel_delta_ = 0 ;
 
 	// Get the inverse of the view Arcball's rotation matrix
-	D3DXMATRIX rotate_matrix ;
-	D3DXMatrixInverse(&rotate_matrix, NULL, view_arcball_.GetRotationMatrix());
+	Matrix rotate_matrix ;
+	MatrixInverse(&rotate_matrix, NULL, view_arcball_.GetRotationMatrix());
 
 	// Transform vectors based on camera's rotation matrix
-	D3DXVECTOR3 world_up_vector;
-	D3DXVECTOR3 loacal_up_vector = D3DXVECTOR3(0, 1, 0);
-	D3DXVec3TransformCoord(&world_up_vector, &loacal_up_vector, &rotate_matrix);
+	Vector3 world_up_vector;
+	Vector3 loacal_up_vector = Vector3(0, 1, 0);
+	Vec3TransformCoord(&world_up_vector, &loacal_up_vector, &rotate_matrix);
 
-	D3DXVECTOR3 world_ahead_vector;
-	D3DXVECTOR3 local_ahead_vector = D3DXVECTOR3(0, 0, 1);
-	D3DXVec3TransformCoord(&world_ahead_vector, &local_ahead_vector, &rotate_matrix);
+	Vector3 world_ahead_vector;
+	Vector3 local_ahead_vector = Vector3(0, 0, 1);
+	Vec3TransformCoord(&world_ahead_vector, &local_ahead_vector, &rotate_matrix);
 
 	// Update the eye point based on a radius away from the lookAt position
 	eye_point_ = lookat_point_ - world_ahead_vector * radius_;
 
 	// Update the view matrix
-	D3DXMatrixLookAtLH(&view_matrix_, &eye_point_, &lookat_point_, &world_up_vector);
+	MatrixLookAtLH(&view_matrix_, &eye_point_, &lookat_point_, &world_up_vector);
+	++version_ ;
 }
 
 // This function is used to handling the mouse message for the view arc ball
@@ -73,24 +86,33 @@ LRESULT Camera::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 		SetCapture(hWnd) ;
 
 		frame_need_update_ = true ;
+		mouse_moved_ = false ;
 		int mouse_x = (short)LOWORD(lParam) ;
 		int mouse_y = (short)HIWORD(lParam) ;
 		view_arcball_.OnBegin(mouse_x, mouse_y) ;
 	}
 
-	// mouse move
-	if(uMsg == WM_MOUSEMOVE)
+	// mouse move, only recorded here, OnFrameMove turns the arc ball once per frame
+	if(uMsg == WM_MOUSEMOVE && view_arcball_.IsDragged())
 	{
 		frame_need_update_ = true ;
-		int mouse_x = (short)LOWORD(lParam);
-		int mouse_y = (short)HIWORD(lParam);
-		view_arcball_.OnMove(mouse_x, mouse_y) ;
+		mouse_moved_ = true ;
+		mouse_x_ = (short)LOWORD(lParam);
+		mouse_y_ = (short)HIWORD(lParam);
 	}
 
 	// right button up, terminate view arc ball rotation
 	if(uMsg == WM_RBUTTONUP)
 	{
 		frame_need_update_ = true ;
+
+		// The last move must reach the arc ball before the drag ends
+		if(mouse_moved_)
+		{
+			view_arcball_.OnMove(mouse_x_, mouse_y_) ;
+			mouse_moved_ = false ;
+		}
+
 		view_arcball_.OnEnd();
 		ReleaseCapture() ;
 	}
@@ -105,20 +127,22 @@ LRESULT Camera::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPara
 	return TRUE ;
 }
 
-void Camera::SetViewParams(const D3DXVECTOR3& eye_point, const D3DXVECTOR3& lookat_point, const D3DXVECTOR3& up_vector)
+void Camera::SetViewParams(const Vector3& eye_point, const Vector3& lookat_point, const Vector3& up_vector)
 {
 	eye_point_	  = eye_point ;
 	lookat_point_ = lookat_point ;
 	up_vector_	  = up_vector ;
 
-	D3DXMatrixLookAtLH(&view_matrix_, &eye_point, &lookat_point, &up_vector) ;
+	MatrixLookAtLH(&view_matrix_, &eye_point, &lookat_point, &up_vector) ;
 	frame_need_update_ = true ;
+	++version_ ;
 }
 
 void Camera::SetProjParams(float field_of_view, float aspect_ratio, float near_plane, float far_plane)
 {
-	D3DXMatrixPerspectiveFovLH(&proj_matrix, field_of_view, aspect_ratio, near_plane, far_plane) ;
+	MatrixPerspectiveFovLH(&proj_matrix, field_of_view, aspect_ratio, near_plane, far_plane) ;
 	frame_need_update_ = true ;
+	++version_ ;
 }
 
 void Camera::SetWindow(int window_width, int window_height, float arcball_radius)
@@ -126,22 +150,55 @@ void Camera::SetWindow(int window_width, int window_height, float arcball_radius
 	view_arcball_.SetWindow(window_width, window_height, arcball_radius) ;
 }
 
-const D3DXMATRIX Camera::GetWorldMatrix() const
+const Matrix Camera::GetWorldMatrix() const
 {
 	return world_matrix_ ;
 }
 
-const D3DXMATRIX Camera::GetViewMatrix() const
+const Matrix Camera::GetViewMatrix() const
 {
 	return view_matrix_ ;
 }
 
-const D3DXMATRIX Camera::GetProjMatrix() const
+const Matrix Camera::GetProjMatrix() const
 {
 	return proj_matrix ;
 }
 
-const D3DXVECTOR3 Camera::GetEyePoint() const
+const Vector3 Camera::GetEyePoint() const
 {
 	return eye_point_ ;
+}
+
+float Camera::GetRadius() const
+{
+	return radius_ ;
+}
+
+void Camera::SetRadius(float radius)
+{
+	radius_ = max(radius, min_radius_) ;
+	radius_ = min(radius_, max_radius_) ;
+	frame_need_update_ = true ;
+}
+
+Quaternion Camera::GetViewRotation() const
+{
+	return view_arcball_.GetRotation() ;
+}
+
+void Camera::SetViewRotation(const Quaternion& rotation)
+{
+	view_arcball_.SetRotation(rotation) ;
+	frame_need_update_ = true ;
+}
+
+bool Camera::NeedFrameMove() const
+{
+	return frame_need_update_ ;
+}
+
+unsigned int Camera::GetVersion() const
+{
+	return version_ ;
 }
\ No newline at end of file
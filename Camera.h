@@ -1,6 +1,8 @@
 #ifndef __CAMERA_H__
 #define __CAMERA_H__
 
+#include <windows.h>
+
 #include "ArcBall.h"
 
 class Camera
@@ -12,29 +14,39 @@ public:
 public:
 	void Reset() ;
 	void OnFrameMove() ;
+	bool NeedFrameMove() const ;	// Input arrived since the last OnFrameMove, the view changed
 	LRESULT HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam) ;
-	void SetViewParams(const D3DXVECTOR3& eye_point, const D3DXVECTOR3& lookat_point, const D3DXVECTOR3& up_vector);
+	void SetViewParams(const Vector3& eye_point, const Vector3& lookat_point, const Vector3& up_vector);
 	void SetProjParams(float field_of_view, float aspect_ratio, float near_plane, float far_plane) ;
 	void SetWindow(int window_width, int window_height, float arcball_radius = 1.0f) ;
-	const D3DXMATRIX GetWorldMatrix() const ;
-	const D3DXMATRIX GetViewMatrix() const ;
-	const D3DXMATRIX GetProjMatrix() const ;
-	const D3DXVECTOR3 GetEyePoint() const ;
+	const Matrix GetWorldMatrix() const ;
+	const Matrix GetViewMatrix() const ;
+	const Matrix GetProjMatrix() const ;
+	const Vector3 GetEyePoint() const ;
+	float GetRadius() const ;
+	void SetRadius(float radius) ;		// Clamped to the zoom range
+	Quaternion GetViewRotation() const ;
+	void SetViewRotation(const Quaternion& rotation) ;
+	unsigned int GetVersion() const ;	// Changes whenever the world, view or projection matrix changes
 
 private:
 	bool	frame_need_update_ ;
+	unsigned int version_ ;			// Incremented when a matrix changes
 	float	radius_;				// Distance from the camera to model 
 	float	max_radius_ ;			// The Maximum distance from the camera to the model
 	float	min_radius_ ;			// The Minimum distance from the camera to the model
 	int		mouse_wheel_delta_;		// Amount of middle wheel scroll (+/-)
+	bool	mouse_moved_ ;			// The mouse moved during a drag since the last OnFrameMove
+	int		mouse_x_ ;				// Last mouse position of the drag
+	int		mouse_y_ ;
 	
-	D3DXVECTOR3 eye_point_ ;			// Eye position
-	D3DXVECTOR3 lookat_point_ ;		// Look at position
-	D3DXVECTOR3 up_vector_ ;				// Up vector
+	Vector3 eye_point_ ;			// Eye position
+	Vector3 lookat_point_ ;		// Look at position
+	Vector3 up_vector_ ;				// Up vector
 
-	D3DXMATRIX world_matrix_ ;			// World matrix of model
-	D3DXMATRIX view_matrix_ ;			// Camera View matrix
-	D3DXMATRIX proj_matrix ;			// Camera Projection matrix
+	Matrix world_matrix_ ;			// World matrix of model
+	Matrix view_matrix_ ;			// Camera View matrix
+	Matrix proj_matrix ;			// Camera Projection matrix
 
 	ArcBall view_arcball_ ;			// View arc ball
 };
@@ -1,373 +1,324 @@
 #include "Cube.h"
 
-LPDIRECT3DTEXTURE9 Cube::inner_texture_ = NULL;
-LPDIRECT3DTEXTURE9 Cube::pTextures[kNumFaces_] = { NULL };
+#include <algorithm>
+#include <string.h>
+
+bool Cube::has_mesh_ = false;
+TextureHandle Cube::sticker_texture_ = kInvalidHandle;
+float Cube::sticker_rect_[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+float Cube::inner_rect_[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+unsigned int Cube::face_colors_[kNumFaces_] = { 0 };
+unsigned int Cube::inner_color_ = 0xff000000;
 
 Cube::Cube(void)
-	 : kNumCornerPoints_(8),
-	   length_(10.0f),
-	   layer_id_x_(-1),
-	   layer_id_y_(-1),
-	   layer_id_z_(-1),
-	   vertex_buffer_(NULL)
+	 : length_(10.0f)
 {
 	for (int i = 0; i < kNumFaces_; ++i)
 	{
-		pIB[i] = NULL;
 		textureId[i] = -1;
 	}
-
-	corner_points_ = new D3DXVECTOR3[kNumCornerPoints_];
-	D3DXMatrixIdentity(&world_matrix_);
 }
 
 Cube::~Cube(void)
 {
-	// Delete corner points
-	delete corner_points_;
-	corner_points_ = NULL;
-
-	// Release vertex buffer
-	if(vertex_buffer_ != NULL)
-	{
-		vertex_buffer_->Release();
-		vertex_buffer_ = NULL;
-	}
-
-	// Release index buffer
-	for(int i = 0; i < kNumFaces_; ++i)
-	{
-		if(pIB[i] != NULL)
-		{
-			pIB[i]->Release();
-			pIB[i] = NULL;
-		}
-	}
 }
 
-void Cube::Init(D3DXVECTOR3& top_left_front_point)
+// The mesh is only created once, Restore did not touch it.
+void Cube::InitMesh(RenderDevice* pDevice)
 {
-	InitVertexBuffer(top_left_front_point);
-	InitIndexBuffer();
-	InitCornerPoints(top_left_front_point);
-	UpdateCenter();
+	if (!has_mesh_)
+		has_mesh_ = GeometryPool::Acquire(pDevice);
 }
 
-void Cube::InitVertexBuffer(D3DXVECTOR3& front_bottom_left)
+void Cube::ReleaseMesh()
 {
-	float x = front_bottom_left.x;
-	float y = front_bottom_left.y;
-	float z = front_bottom_left.z;
-
-	/* Example of front face
-   1               2
-	---------------
-	|             |
-	|             |
-	|             |
-	|             |
-	|             |
-	---------------
-   0               3
-	*/
-
-	// Vertex buffer data
-	Vertex vertices[] =
-	{
-		// Front face
-		{          x,           y,           z,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f}, // 0
-		{          x, y + length_,           z,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f}, // 1
-		{x + length_, y + length_,           z,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f}, // 2
-		{x + length_,           y,           z,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f}, // 3
-
-		// Back face
-		{x + length_,           y, z + length_,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f}, // 4
-		{x + length_, y + length_, z + length_,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f}, // 5
-		{          x, y + length_, z + length_,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f}, // 6
-		{          x,           y, z + length_,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f}, // 7
-
-		// Left face
-		{          x,           y, z + length_, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f}, // 8
-		{          x, y + length_, z + length_, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f}, // 9
-		{          x, y + length_,           z, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f}, // 10
-		{          x,           y,           z, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f}, // 11
-
-		// Right face 
-		{x + length_,           y,           z,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f}, // 12
-		{x + length_, y + length_,           z,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f}, // 13
-		{x + length_, y + length_, z + length_,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f}, // 14
-		{x + length_,           y, z + length_,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f}, // 15
-
-		// Top face
-		{          x, y + length_,           z,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f}, // 16
-		{          x, y + length_, z + length_,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f}, // 17
-		{x + length_, y + length_, z + length_,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f}, // 18
-		{x + length_, y + length_,           z,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f}, // 19
-
-		// Bottom face
-		{x + length_,           y,           z,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f}, // 20
-		{x + length_,           y, z + length_,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f}, // 21
-		{          x,           y, z + length_,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f}, // 22
-		{          x,           y,           z,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f}, // 23
-	};
-	
-	// This function will also used to restore the Rubik Cube, but the CreateVertexBuffer function will cost and hold the memory if vertex_buffer_ not released
-	// When user press the 'R' frequently, memory usage increase time and time. so it's better to add a if branch to determine whether the buffer was created, if
-	// that's true, we didn't create it again, we only lock it and copy the data, so the buffer will  only created once the app starts.
-	if (vertex_buffer_ == NULL)
-	{
-		// Create vertex buffer
-		if (FAILED(d3d_device_->CreateVertexBuffer(sizeof(vertices) * sizeof(Vertex),
-			D3DUSAGE_WRITEONLY, 
-			VERTEX_FVF,
-			D3DPOOL_MANAGED, 
-			&vertex_buffer_, 
-			NULL)))
-		{
-			MessageBox(NULL, L"Create vertex buffer failed", L"Error", 0);
-		}
-	}
+	if (!has_mesh_)
+		return;
 
-	// Copy vertex data
-	VOID* pVertices;
-	if (FAILED(vertex_buffer_->Lock(0, sizeof(vertices), (void**)&pVertices, 0)))
-		MessageBox(NULL, L"Copy vertex buffer failed", L"Error", 0);
-	memcpy(pVertices, vertices, sizeof(vertices));
-	vertex_buffer_->Unlock();
+	GeometryPool::Release();
+	has_mesh_ = false;
 }
 
-void Cube::InitIndexBuffer()
-{
-	// Indices for triangle strips
-	WORD indicesFront[]  = { 0,  1,  3,  2};
-	WORD indicesBack[]   = { 4,  5,  7,  6};
-	WORD indicesLeft[]   = { 8,  9, 11, 10};
-	WORD indicesRight[]  = {12, 13, 15, 14};
-	WORD indicesTop[]    = {16, 17, 19, 18};
-	WORD indicesBottom[] = {20, 21, 23, 22};
-
-	WORD* indices[kNumFaces_] = {indicesFront, indicesBack, indicesLeft, indicesRight, indicesTop, indicesBottom};
-
-	for(int i = 0; i < kNumFaces_; ++i)
-	{
-		// Only create index buffer once, prevent high memory usage when user press 'R' frequently, see comments in InitVertexBuffer.
-		if (pIB[i] == NULL)
-		{
-			if (FAILED(d3d_device_->CreateIndexBuffer(sizeof(indicesFront) * sizeof(WORD), 
-				D3DUSAGE_WRITEONLY, 
-				D3DFMT_INDEX16, 
-				D3DPOOL_MANAGED, 
-				&pIB[i], 
-				0)))
-			{
-				MessageBox(NULL, L"Create index buffer failed", L"Error", 0);
-			}
-		}
-
-		// Copy index data
-		VOID *pIndices;
-		if (FAILED(pIB[i]->Lock(0, sizeof(indicesFront), (void **)&pIndices, 0)))
-			MessageBox(NULL, L"Copy index buffer data failed", L"Error", 0);
-		memcpy(pIndices, indices[i], sizeof(indicesFront));
-		pIB[i]->Unlock() ;
-	}
-}
-
-void Cube::InitCornerPoints(D3DXVECTOR3& front_bottom_left)
+void Cube::SetTextureId(int faceId, int texId)
 {
-	// Calculate the min/max pint of the cube
-	// min point is the front bottom left corner of the cube
-	D3DXVECTOR3 min_point(front_bottom_left.x, front_bottom_left.y, front_bottom_left.z);
-
-	// max point is the back top right corner of the cube
-	D3DXVECTOR3 max_point(front_bottom_left.x + length_, front_bottom_left.y + length_, front_bottom_left.z + length_);
-
-	/* The 8 points were count first on the front side from the bottom-left corner in clock-wise order
-	 Then on the back side, with the same order
-
-	 // Front face
-		1-----------2
-		|  front    |
-		|  side     |
-		|           |
-		|           |
-		0-----------3
-	*/
-	corner_points_[0] = D3DXVECTOR3(min_point.x, min_point.y, min_point.z);
-	corner_points_[1] = D3DXVECTOR3(min_point.x, max_point.y, min_point.z);
-	corner_points_[2] = D3DXVECTOR3(max_point.x, max_point.y, min_point.z);
-	corner_points_[3] = D3DXVECTOR3(max_point.x, min_point.y, min_point.z);
-
-	/* Back face
-	    5-----------6
-		|  front    |
-		|  side     |
-		|           |
-		|           |
-		4-----------7
-	*/
-	corner_points_[4] = D3DXVECTOR3(max_point.x, min_point.y, max_point.z);
-	corner_points_[5] = D3DXVECTOR3(max_point.x, max_point.y, max_point.z);
-	corner_points_[6] = D3DXVECTOR3(min_point.x, max_point.y, max_point.z);
-	corner_points_[7] = D3DXVECTOR3(min_point.x, min_point.y, max_point.z);
-
-	// Initilize min_point and max_point
-	min_point_ = min_point;
-	max_point_ = max_point;
+	textureId[faceId] = texId;
 }
 
-D3DXVECTOR3 Cube::CalculateCenter(D3DXVECTOR3& min_point, D3DXVECTOR3& max_point)
+void Cube::SetStickerTexture(TextureHandle stickerTexture, const float* stickerRect, const float* innerRect)
 {
-	return (min_point + max_point) / 2;
+	sticker_texture_ = stickerTexture;
+	memcpy(sticker_rect_, stickerRect, sizeof(sticker_rect_));
+	memcpy(inner_rect_, innerRect, sizeof(inner_rect_));
 }
 
-void Cube::SetTextureId(int faceId, int texId)
+// The rectangles are baked into the instances by the simulation thread, so they are not touched here
+void Cube::SetStickerTexture(TextureHandle stickerTexture)
 {
-	textureId[faceId] = texId;
+	sticker_texture_ = stickerTexture;
 }
 
-void Cube::SetFaceTexture(LPDIRECT3DTEXTURE9* faceTextures, int numTextures)
+void Cube::SetFaceColors(const unsigned int* faceColors, int numColors)
 {
-	for(int i = 0; i < numTextures; ++i)
+	for(int i = 0; i < numColors; ++i)
 	{
-		pTextures[i] = faceTextures[i];
+		face_colors_[i] = faceColors[i];
 	}
 }
 
-void Cube::SetInnerTexture(LPDIRECT3DTEXTURE9 innerTexture)
+void Cube::SetInnerColor(unsigned int innerColor)
 {
-	inner_texture_ = innerTexture;
+	inner_color_ = innerColor;
 }
 
-void Cube::SetDevice(LPDIRECT3DDEVICE9 pDevice)
+void Cube::GetInstanceData(const Matrix& world_matrix, InstanceData* instance) const
 {
-	d3d_device_ = pDevice;
-}
+	memcpy(instance->world, (const float*)world_matrix, sizeof(instance->world));
 
-void Cube::UpdateMinMaxPoints(D3DXVECTOR3& rotate_axis, int num_half_PI)
-{
-	// Build up the rotation matrix with the overall angle
-	// This angle is times of D3DX_PI / 2.
-	D3DXMATRIX rotate_matrix;
-	D3DXMatrixIdentity(&rotate_matrix);
-	
-	if (num_half_PI == 0)
-	{
-		D3DXMatrixRotationAxis(&rotate_matrix, &rotate_axis, 0);
-	}
-	else if (num_half_PI == 1)
-	{
-		D3DXMatrixRotationAxis(&rotate_matrix, &rotate_axis, D3DX_PI / 2);
-	}
-	else if (num_half_PI == 2)
-	{
-		D3DXMatrixRotationAxis(&rotate_matrix, &rotate_axis, D3DX_PI);
-	}
-	else // (num_half_PI == 3)
+	for(int i = 0; i < kNumFaces_; ++i)
 	{
-		D3DXMatrixRotationAxis(&rotate_matrix, &rotate_axis, 1.5f * D3DX_PI);
+		const float* uv_rect = textureId[i] >= 0 ? sticker_rect_ : inner_rect_;
+		memcpy(instance->uv_rects[i], uv_rect, sizeof(instance->uv_rects[i]));
+
+		instance->colors[i] = textureId[i] >= 0 ? face_colors_[textureId[i]] : inner_color_;
 	}
 
-	// Translate the min_point_ and max_point_ of the cube, after rotation, the two points 
-	// was changed, need to recalculate them with the rotation matrix.
-	D3DXVECTOR3 min_point;
-	D3DXVECTOR3 max_point;
-	D3DXVec3TransformCoord(&min_point, &min_point_, &rotate_matrix);
-	D3DXVec3TransformCoord(&max_point, &max_point_, &rotate_matrix);
-
-	// After translate by the world matrix, the min/max point need recalculate
-	min_point_.x = min(min_point.x, max_point.x);
-	min_point_.y = min(min_point.y, max_point.y);
-	min_point_.z = min(min_point.z, max_point.z);
-
-	max_point_.x = max(min_point.x, max_point.x);
-	max_point_.y = max(min_point.y, max_point.y);
-	max_point_.z = max(min_point.z, max_point.z);
+	instance->face_mask = kAllQuads;
 }
 
-void Cube::UpdateCenter()
+// The inner box of one turning layer, in the frame of the layer
+struct LayerBox
 {
-	center_ = (min_point_ + max_point_) / 2;
-}
-
-void Cube::Rotate(D3DXVECTOR3& axis, float angle)
+	bool valid;
+	Vector3 axes[3];		// Frame of the layer, axes[axis] is the rotate axis, the others turn with the layer
+	float min_point[3];		// Extent of the cube centers in the frame
+	float max_point[3];
+};
+
+// Unit normal axis and sign of each face of the unit cube mesh: front, back, left, right, top, bottom
+static const int kFaceAxis[6] = { 2, 2, 0, 0, 1, 1 };
+static const float kFaceSign[6] = { -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f };
+
+/*
+Only the visible faces are drawn. At rest these are the stickers, the dark inner faces between the
+unit cubes are replaced by one inner colored box inside the outer layer, which is what can be seen
+through the gaps between the cubes. During a rotation the cut planes between the rotating layers and
+their neighbours are open, so the cubes next to a cut plane also draw their face lying on it, which
+is n x n quads for each side of a cut plane. The static layers on each side get an axis aligned box,
+and each layer from the first to the last rotating layer gets a box turned with it, which fill the
+gaps between the cubes. A layer is a square slab, so its frame needs the turn angle modulo 90 degrees
+only, which is the direction of a cube axis lying in the layer plane.
+*/
+void Cube::GetInstances(const Cube* cubes, const CubeTransforms& transforms, int numLayers, int firstRotatingLayer, int lastRotatingLayer, std::vector<InstanceData>* instances)
 {
-	// Calculate the rotation matrix
-	D3DXMATRIX rotate_matrix;
-	D3DXMatrixRotationAxis(&rotate_matrix, &axis, angle);
+	instances->clear();
 
-	// This may cause the matrix multiplication accumulate errors, how to fix it?
-	world_matrix_ *= rotate_matrix;
-}
+	int axis = firstRotatingLayer >= 0 ? firstRotatingLayer / numLayers : -1;
+	int num_turning_layers = axis >= 0 ? lastRotatingLayer - firstRotatingLayer + 1 : 0;
 
-void Cube::Draw()
-{
-	// Setup world matrix for current cube
-	d3d_device_->SetTransform(D3DTS_WORLD, &world_matrix_) ;
+	// The layers next to a cut plane, along the rotate axis
+	int first_axis_layer = axis * numLayers;
+	int last_axis_layer  = (axis + 1) * numLayers - 1;
 
-	// Draw cube by draw every face of the cube
-	for(int i = 0; i < kNumFaces_; ++i)
+	// The static layers before(box 0) and after(box 1) the rotating layers, box 0 holds all layers at rest
+	Vector3 box_min[2];
+	Vector3 box_max[2];
+	bool box_valid[2] = { false, false };
+
+	std::vector<LayerBox> layer_boxes(num_turning_layers);
+	for (int i = 0; i < num_turning_layers; ++i)
+		layer_boxes[i].valid = false;
+
+	InstanceData instance;
+	Matrix world_matrix;
+	int numCubes = transforms.GetCount();
+
+	for(int i = 0; i < numCubes; ++i)
 	{
-		if(textureId[i] >= 0)
+		Vector3 center = transforms.GetCenter(i);
+		int layer = axis >= 0 ? transforms.GetLayerId(i, axis) : -1;
+
+		// A cut plane lies after the layer if the layer or the next one rotates, and before it likewise
+		bool cut_after  = layer >= firstRotatingLayer - 1 && layer <= lastRotatingLayer && layer < last_axis_layer;
+		bool cut_before = layer >= firstRotatingLayer && layer <= lastRotatingLayer + 1 && layer > first_axis_layer;
+
+		unsigned int face_mask = cubes[i].GetStickerMask();
+		if (axis >= 0 && (cut_after || cut_before))
+		{
+			// The faces whose normal turned onto the positive or negative rotate axis
+			Quaternion orientation = transforms.GetOrientation(i);
+			Matrix rotation;
+			MatrixRotationQuaternion(&rotation, &orientation);
+
+			for (int face = 0; face < kNumFaces_; ++face)
+			{
+				float normal = kFaceSign[face] * rotation.m[kFaceAxis[face]][axis];
+				if ((cut_after && normal > 0.5f) || (cut_before && normal < -0.5f))
+					face_mask |= 1 << face;
+			}
+		}
+
+		if (face_mask != 0)
+		{
+			transforms.GetWorldMatrix(i, &world_matrix);
+			cubes[i].GetInstanceData(world_matrix, &instance);
+			instance.face_mask = face_mask;
+			instances->push_back(instance);
+		}
+
+		if (axis >= 0 && layer >= firstRotatingLayer && layer <= lastRotatingLayer)
+		{
+			LayerBox& box = layer_boxes[layer - firstRotatingLayer];
+			if (!box.valid)
+			{
+				// The cube axis nearest to the layer plane
+				Quaternion orientation = transforms.GetOrientation(i);
+				Matrix rotation;
+				MatrixRotationQuaternion(&rotation, &orientation);
+
+				int row = 0;
+				for (int r = 1; r < 3; ++r)
+				{
+					if (fabsf(rotation.m[r][axis]) < fabsf(rotation.m[row][axis]))
+						row = r;
+				}
+
+				Vector3 normal(0, 0, 0);
+				normal[axis] = 1.0f;
+				Vector3 u(rotation.m[row][0], rotation.m[row][1], rotation.m[row][2]);
+				u[axis] = 0;
+				Vec3Normalize(&u, &u);
+
+				box.axes[axis] = normal;
+				box.axes[(axis + 1) % 3] = u;
+				Vec3Cross(&box.axes[(axis + 2) % 3], &normal, &u);
+			}
+
+			for (int k = 0; k < 3; ++k)
+			{
+				float d = Vec3Dot(&center, &box.axes[k]);
+				box.min_point[k] = box.valid ? (std::min)(box.min_point[k], d) : d;
+				box.max_point[k] = box.valid ? (std::max)(box.max_point[k], d) : d;
+			}
+			box.valid = true;
+			continue;
+		}
+
+		// The cubes outside the rotating layers are at rest, so their box is axis aligned
+		int box = (axis >= 0 && layer > lastRotatingLayer) ? 1 : 0;
+		float half_length = cubes[i].GetLength() / 2;
+		Vector3 min_point = center - Vector3(half_length, half_length, half_length);
+		Vector3 max_point = center + Vector3(half_length, half_length, half_length);
+		if (!box_valid[box])
 		{
-			d3d_device_->SetTexture(0, pTextures[textureId[i]]);
+			box_min[box] = min_point;
+			box_max[box] = max_point;
+			box_valid[box] = true;
 		}
 		else
 		{
-			d3d_device_->SetTexture(0, inner_texture_);
+			Vec3Minimize(&box_min[box], &box_min[box], &min_point);
+			Vec3Maximize(&box_max[box], &box_max[box], &max_point);
 		}
+	}
 
-		d3d_device_->SetStreamSource(0, vertex_buffer_, 0, sizeof(Vertex));
-		d3d_device_->SetIndices(pIB[i]) ;
-		d3d_device_->SetFVF(VERTEX_FVF);
+	// A single cube has no gaps
+	if (numLayers <= 1)
+		return;
 
-		d3d_device_->DrawIndexedPrimitive(D3DPT_TRIANGLESTRIP, 0, 0, 24, 0, 2);
+	// Shrink the boxes just behind the faces of the cubes, so the gaps at the rim stay closed
+	float half_length = cubes[0].GetLength() / 2;
+	float inset = cubes[0].GetLength() / 20;
+
+	for(int i = 0; i < 2; ++i)
+	{
+		if (!box_valid[i])
+			continue;
+
+		Vector3 min_point = box_min[i] + Vector3(inset, inset, inset);
+		Vector3 max_point = box_max[i] - Vector3(inset, inset, inset);
+		GetBoxInstanceData(min_point, max_point, &instance);
+		instances->push_back(instance);
 	}
-}
 
-float Cube::GetLength() const
-{
-	return length_;
-}
+	for (int i = 0; i < num_turning_layers; ++i)
+	{
+		const LayerBox& box = layer_boxes[i];
+		if (!box.valid)
+			continue;
+
+		// Row k of the world matrix maps the unit mesh along axes[k]
+		Matrix box_world;
+		MatrixIdentity(&box_world);
+		Vector3 origin(0, 0, 0);
+		for (int k = 0; k < 3; ++k)
+		{
+			float low  = box.min_point[k] - half_length + inset;
+			float high = box.max_point[k] + half_length - inset;
+			for (int j = 0; j < 3; ++j)
+				box_world.m[k][j] = (high - low) * box.axes[k][j];
+			origin += low * box.axes[k];
+		}
+		for (int j = 0; j < 3; ++j)
+			box_world.m[3][j] = origin[j];
 
-D3DXVECTOR3 Cube::GetMinPoint() const
-{
-	return min_point_;
+		GetBoxInstanceData(box_world, &instance);
+		instances->push_back(instance);
+	}
 }
 
-D3DXVECTOR3 Cube::GetMaxPoint() const
+// All visible cubes and boxes are drawn with one call
+void Cube::DrawInstances(DrawList* draw_list, const Matrix& world_matrix, const InstanceData* instances, int numInstances)
 {
-	return max_point_;
-}
+	if (numInstances == 0)
+		return;
 
-D3DXVECTOR3 Cube::GetCenter() const
-{
-	return center_;
-}
+	DrawItem item;
+	item.texture = sticker_texture_;
+	GeometryPool::SetDrawItemMesh(kUnitCubeMesh, &item);
+	memcpy(item.world, (const float*)world_matrix, sizeof(item.world));
 
-void Cube::SetWorldMatrix(D3DXMATRIX& world_matrix)
-{
-	world_matrix_ = world_matrix;
+	draw_list->AddInstanced(item, instances, numInstances);
 }
 
-bool Cube::InLayer(int layer_id)
+void Cube::GetBoxInstanceData(const Vector3& min_point, const Vector3& max_point, InstanceData* instance)
 {
-	return ( layer_id_x_ == layer_id 
-		  || layer_id_y_ == layer_id
-		  || layer_id_z_ == layer_id );
+	Vector3 size = max_point - min_point;
+
+	Matrix scale_matrix;
+	MatrixScaling(&scale_matrix, size.x, size.y, size.z);
+
+	Matrix translate_matrix;
+	MatrixTranslation(&translate_matrix, min_point.x, min_point.y, min_point.z);
+
+	GetBoxInstanceData(scale_matrix * translate_matrix, instance);
 }
 
-void Cube::SetLayerIdX(int layer_id_x)
+void Cube::GetBoxInstanceData(const Matrix& box_world, InstanceData* instance)
 {
-	layer_id_x_ = layer_id_x;
+	memcpy(instance->world, (const float*)box_world, sizeof(instance->world));
+
+	for(int i = 0; i < kNumFaces_; ++i)
+	{
+		memcpy(instance->uv_rects[i], inner_rect_, sizeof(instance->uv_rects[i]));
+		instance->colors[i] = inner_color_;
+	}
+
+	instance->face_mask = kAllQuads;
 }
 
-void Cube::SetLayerIdY(int layer_id_y)
+unsigned int Cube::GetStickerMask() const
 {
-	layer_id_y_ = layer_id_y;
+	unsigned int mask = 0;
+	for(int i = 0; i < kNumFaces_; ++i)
+	{
+		if (textureId[i] >= 0)
+			mask |= 1 << i;
+	}
+
+	return mask;
 }
 
-void Cube::SetLayerIdZ(int layer_id_z)
+float Cube::GetLength() const
 {
-	layer_id_z_ = layer_id_z;
+	return length_;
 }
@@ -0,0 +1,224 @@
+#include "CubePlacement.h"
+
+#include <math.h>
+
+bool			CubePlacement::tables_ready_ = false;
+Quaternion		CubePlacement::orientation_quaternions_[kNumOrientations];
+unsigned char	CubePlacement::turned_orientations_[kNumOrientations][3][4];
+int				CubePlacement::turn_matrices_[3][4][3][3];
+
+CubePlacement::CubePlacement(int num_layers)
+	: num_layers_(num_layers)
+{
+	InitTables();
+
+	int num_cubes = num_layers * num_layers * num_layers;
+	slots_.resize(num_cubes);
+	cubes_.resize(num_cubes);
+	orientations_.resize(num_cubes);
+	layer_cubes_.reserve(num_layers * num_layers);
+
+	Reset();
+}
+
+CubePlacement::~CubePlacement(void)
+{
+}
+
+/*
+The orientations are all the products of quarter turns, found breadth first from the identity.
+q and -q are the same rotation, the orientations of a cube are 90 degrees apart at least, so the
+dot product of two different ones is at most cos(45 degrees) and 0.9 tells them apart whatever
+the rounding errors are.
+*/
+void CubePlacement::InitTables()
+{
+	if (tables_ready_)
+		return;
+
+	Quaternion turns[3][4];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		Vector3 v(axis == 0 ? 1.0f : 0.0f, axis == 1 ? 1.0f : 0.0f, axis == 2 ? 1.0f : 0.0f);
+		for (int quarter_turns = 0; quarter_turns < 4; ++quarter_turns)
+		{
+			QuaternionRotationAxis(&turns[axis][quarter_turns], &v, quarter_turns * kPi / 2);
+
+			Matrix m;
+			MatrixRotationQuaternion(&m, &turns[axis][quarter_turns]);
+			for (int row = 0; row < 3; ++row)
+			{
+				for (int col = 0; col < 3; ++col)
+				{
+					turn_matrices_[axis][quarter_turns][row][col] = (int)floorf(m.m[row][col] + 0.5f);
+				}
+			}
+		}
+	}
+
+	int num_orientations = 1;
+	QuaternionIdentity(&orientation_quaternions_[0]);
+	for (int i = 0; i < num_orientations; ++i)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			Quaternion q;
+			QuaternionMultiply(&q, &orientation_quaternions_[i], &turns[axis][1]);
+			if (FindOrientation(q, num_orientations) < 0)
+				orientation_quaternions_[num_orientations++] = q;
+		}
+	}
+
+	for (int i = 0; i < kNumOrientations; ++i)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			for (int quarter_turns = 0; quarter_turns < 4; ++quarter_turns)
+			{
+				Quaternion q;
+				QuaternionMultiply(&q, &orientation_quaternions_[i], &turns[axis][quarter_turns]);
+				turned_orientations_[i][axis][quarter_turns] = (unsigned char)FindOrientation(q, kNumOrientations);
+			}
+		}
+	}
+
+	tables_ready_ = true;
+}
+
+int CubePlacement::FindOrientation(const Quaternion& q, int num_orientations)
+{
+	for (int i = 0; i < num_orientations; ++i)
+	{
+		const Quaternion& o = orientation_quaternions_[i];
+		float dot = q.x * o.x + q.y * o.y + q.z * o.z + q.w * o.w;
+		if (fabsf(dot) > 0.9f)
+			return i;
+	}
+
+	return -1;
+}
+
+void CubePlacement::Reset()
+{
+	for (size_t i = 0; i < slots_.size(); ++i)
+	{
+		slots_[i] = (int)i;
+		cubes_[i] = (int)i;
+		orientations_[i] = 0;
+	}
+}
+
+bool CubePlacement::IsSolved() const
+{
+	int last = num_layers_ - 1;
+	for (int cube = 0; cube < (int)slots_.size(); ++cube)
+	{
+		int i = cube % num_layers_;
+		int j = (cube / num_layers_) % num_layers_;
+		int k = cube / (num_layers_ * num_layers_);
+		bool inside = i > 0 && i < last && j > 0 && j < last && k > 0 && k < last;
+
+		if (!inside && (slots_[cube] != cube || orientations_[cube] != 0))
+			return false;
+	}
+
+	return true;
+}
+
+int CubePlacement::GetNumLayers() const
+{
+	return num_layers_;
+}
+
+int CubePlacement::GetNumCubes() const
+{
+	return (int)slots_.size();
+}
+
+int CubePlacement::GetSlot(int cube) const
+{
+	return slots_[cube];
+}
+
+int CubePlacement::GetOrientation(int cube) const
+{
+	return orientations_[cube];
+}
+
+/*
+The slot coordinates are doubled and centered, 2 * index - (n - 1), so the rotation about the
+center of the Rubik Cube maps integers to integers. All the cubes of the layer are moved before
+the slot table is written, the layer is mapped onto itself.
+*/
+void CubePlacement::RotateLayer(int layer_id, int quarter_turns)
+{
+	quarter_turns = ((quarter_turns % 4) + 4) % 4;
+	if (layer_id < 0 || quarter_turns == 0)
+		return;
+
+	int n = num_layers_;
+	int axis = layer_id / n;
+	int index = layer_id % n;
+	int stride[3] = { 1, n, n * n };
+
+	layer_cubes_.clear();
+	for (int a = 0; a < n; ++a)
+	{
+		for (int b = 0; b < n; ++b)
+		{
+			int slot = index * stride[axis] + a * stride[(axis + 1) % 3] + b * stride[(axis + 2) % 3];
+			layer_cubes_.push_back(cubes_[slot]);
+		}
+	}
+
+	const int (*m)[3] = turn_matrices_[axis][quarter_turns];
+	for (size_t i = 0; i < layer_cubes_.size(); ++i)
+	{
+		int cube = layer_cubes_[i];
+		int slot = slots_[cube];
+
+		int p[3];
+		p[0] = 2 * (slot % n) - (n - 1);
+		p[1] = 2 * ((slot / n) % n) - (n - 1);
+		p[2] = 2 * (slot / (n * n)) - (n - 1);
+
+		int new_slot = 0;
+		for (int col = 0; col < 3; ++col)
+		{
+			int rotated = p[0] * m[0][col] + p[1] * m[1][col] + p[2] * m[2][col];
+			new_slot += ((rotated + n - 1) / 2) * stride[col];
+		}
+
+		slots_[cube] = new_slot;
+		orientations_[cube] = turned_orientations_[orientations_[cube]][axis][quarter_turns];
+	}
+
+	for (size_t i = 0; i < layer_cubes_.size(); ++i)
+	{
+		int cube = layer_cubes_[i];
+		cubes_[slots_[cube]] = cube;
+	}
+}
+
+void CubePlacement::Pack(unsigned int* packed) const
+{
+	for (size_t i = 0; i < slots_.size(); ++i)
+	{
+		packed[i] = (unsigned int)slots_[i] * kNumOrientations + orientations_[i];
+	}
+}
+
+void CubePlacement::Unpack(const unsigned int* packed)
+{
+	for (size_t i = 0; i < slots_.size(); ++i)
+	{
+		slots_[i] = (int)(packed[i] / kNumOrientations);
+		orientations_[i] = (unsigned char)(packed[i] % kNumOrientations);
+		cubes_[slots_[i]] = (int)i;
+	}
+}
+
+const Quaternion& CubePlacement::GetOrientationQuaternion(int orientation)
+{
+	return orientation_quaternions_[orientation];
+}
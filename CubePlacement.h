@@ -0,0 +1,58 @@
+#ifndef __CUBE_PLACEMENT_H__
+#define __CUBE_PLACEMENT_H__
+
+#include "VectorMath.h"
+#include <vector>
+
+// Where the unit cubes of a n x n x n Rubik Cube are after whole turns, in integers: the grid slot
+// i + j * n + k * n^2 of each cube and its orientation, one of the 24 rotations of a cube.
+// The cube and slot numbers are those of CubeTransforms, a cube starts in the slot of its own number.
+// A turn only touches the n x n cubes of its layer, so replaying many turns is cheap at any size,
+// and a whole placement packs into one unsigned int per cube.
+class CubePlacement
+{
+public:
+	static const int kNumOrientations = 24;
+
+	explicit CubePlacement(int num_layers);
+	~CubePlacement(void);
+
+	void Reset();		// All cubes in their own slot, not rotated
+
+	// The cubes on the surface are in their own slot and not rotated, the cubes inside are not seen
+	bool IsSolved() const;
+
+	int GetNumLayers() const;
+	int GetNumCubes() const;
+	int GetSlot(int cube) const;
+	int GetOrientation(int cube) const;
+
+	// Rotate a layer by quarter_turns x 90 degrees around the positive axis, the layer ids are
+	// counted as in CubeTransforms, the rotation is the same as CubeTransforms::RotateLayer.
+	void RotateLayer(int layer_id, int quarter_turns);
+
+	// GetNumCubes() values, slot * kNumOrientations + orientation for each cube
+	void Pack(unsigned int* packed) const;
+	void Unpack(const unsigned int* packed);
+
+	// The rotation of an orientation, the product of the layer rotations which turned an unrotated cube to it
+	static const Quaternion& GetOrientationQuaternion(int orientation);
+
+private:
+	static void InitTables();
+	static int FindOrientation(const Quaternion& q, int num_orientations);
+
+private:
+	int num_layers_;
+	std::vector<int> slots_;					// Slot of each cube
+	std::vector<int> cubes_;					// Cube in each slot
+	std::vector<unsigned char> orientations_;	// Orientation of each cube
+	std::vector<int> layer_cubes_;				// Scratch buffer of RotateLayer
+
+	static bool tables_ready_;
+	static Quaternion orientation_quaternions_[kNumOrientations];
+	static unsigned char turned_orientations_[kNumOrientations][3][4];	// Orientation after quarter turns around X, Y or Z axis
+	static int turn_matrices_[3][4][3][3];		// Rotation matrix of quarter turns around X, Y or Z axis, for row vectors
+};
+
+#endif // end __CUBE_PLACEMENT_H__
@@ -0,0 +1,206 @@
+#include "CubeState.h"
+
+#include <string.h>
+
+// Normal, right and up direction of each face as seen from outside the cube, in the order of the Face enum
+static const int kFaceNormal[6][3] = { {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0} };
+static const int kFaceRight[6][3]  = { {1, 0, 0}, {-1, 0, 0}, {0, 0, -1}, {0, 0, 1}, {1, 0, 0}, {1, 0, 0} };
+static const int kFaceUp[6][3]     = { {0, 1, 0}, {0, 1, 0},  {0, 1, 0},  {0, 1, 0}, {0, 0, 1}, {0, 0, -1} };
+
+static int Dot(const int* a, const int* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Rotate a vector 90 degrees around X, Y or Z axis, the same as MatrixRotationX/Y/Z(kPi / 2)
+static void RotateQuarter(int axis, int* v)
+{
+	int x = v[0];
+	int y = v[1];
+	int z = v[2];
+
+	if (axis == 0)
+	{
+		v[1] = -z;
+		v[2] = y;
+	}
+	else if (axis == 1)
+	{
+		v[0] = z;
+		v[2] = -x;
+	}
+	else
+	{
+		v[0] = -y;
+		v[1] = x;
+	}
+}
+
+CubeState::CubeState(int num_layers)
+	: num_layers_(num_layers)
+{
+	facelets_.resize(6 * num_layers_ * num_layers_);
+	rotated_.resize(facelets_.size());
+	Reset();
+}
+
+CubeState::~CubeState(void)
+{
+}
+
+int CubeState::GetNumLayers() const
+{
+	return num_layers_;
+}
+
+int CubeState::GetNumFacelets() const
+{
+	return (int)facelets_.size();
+}
+
+int CubeState::GetFaceletIndex(int face, int row, int col) const
+{
+	return (face * num_layers_ + row) * num_layers_ + col;
+}
+
+unsigned char CubeState::GetFacelet(int face, int row, int col) const
+{
+	return facelets_[GetFaceletIndex(face, row, col)];
+}
+
+void CubeState::SetFacelet(int face, int row, int col, unsigned char color)
+{
+	facelets_[GetFaceletIndex(face, row, col)] = color;
+}
+
+const unsigned char* CubeState::GetFacelets() const
+{
+	return &facelets_[0];
+}
+
+void CubeState::SetFacelets(const unsigned char* facelets)
+{
+	memcpy(&facelets_[0], facelets, facelets_.size());
+}
+
+void CubeState::Reset()
+{
+	int face_size = num_layers_ * num_layers_;
+	for (int i = 0; i < (int)facelets_.size(); ++i)
+	{
+		facelets_[i] = (unsigned char)(i / face_size);
+	}
+}
+
+bool CubeState::IsSolved() const
+{
+	int face_size = num_layers_ * num_layers_;
+	for (int face = 0; face < 6; ++face)
+	{
+		const unsigned char* facelets = &facelets_[face * face_size];
+		for (int i = 1; i < face_size; ++i)
+		{
+			if (facelets[i] != facelets[0])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+Each facelet is moved as a point on the cube surface. With the cube center as origin and
+half a unit cube as the unit, the facelet centers are at odd coordinates -(n - 1) .. (n - 1)
+on the face planes at +-n, so a quarter turn maps them to integer positions exactly.
+*/
+void CubeState::RotateLayer(int layer_id, int quarter_turns)
+{
+	int axis = layer_id / num_layers_;
+	int layer_position = 2 * (layer_id % num_layers_) - (num_layers_ - 1);
+	int turns = ((quarter_turns % 4) + 4) % 4;
+	if (turns == 0)
+		return;
+
+	for (int i = 0; i < (int)facelets_.size(); ++i)
+	{
+		int position[3];
+		GetFaceletPosition(i, position);
+
+		// The unit cube the facelet belongs to
+		int cube_position = position[axis];
+		if (cube_position > num_layers_ - 1)
+			cube_position = num_layers_ - 1;
+		else if (cube_position < -(num_layers_ - 1))
+			cube_position = -(num_layers_ - 1);
+
+		if (cube_position != layer_position)
+		{
+			rotated_[i] = facelets_[i];
+			continue;
+		}
+
+		int face = i / (num_layers_ * num_layers_);
+		int normal[3] = { kFaceNormal[face][0], kFaceNormal[face][1], kFaceNormal[face][2] };
+
+		for (int j = 0; j < turns; ++j)
+		{
+			RotateQuarter(axis, position);
+			RotateQuarter(axis, normal);
+		}
+
+		rotated_[FindFacelet(position, normal)] = facelets_[i];
+	}
+
+	facelets_.swap(rotated_);
+}
+
+void CubeState::GetFaceAxes(int face, int* normal, int* right, int* up)
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		normal[i] = kFaceNormal[face][i];
+		right[i]  = kFaceRight[face][i];
+		up[i]     = kFaceUp[face][i];
+	}
+}
+
+bool CubeState::operator==(const CubeState& other) const
+{
+	return num_layers_ == other.num_layers_ && facelets_ == other.facelets_;
+}
+
+bool CubeState::operator!=(const CubeState& other) const
+{
+	return !(*this == other);
+}
+
+void CubeState::GetFaceletPosition(int index, int* position) const
+{
+	int face_size = num_layers_ * num_layers_;
+	int face = index / face_size;
+	int row  = (index % face_size) / num_layers_;
+	int col  = index % num_layers_;
+
+	int x = 2 * col - (num_layers_ - 1);
+	int y = (num_layers_ - 1) - 2 * row;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		position[i] = kFaceNormal[face][i] * num_layers_ + kFaceRight[face][i] * x + kFaceUp[face][i] * y;
+	}
+}
+
+int CubeState::FindFacelet(const int* position, const int* normal) const
+{
+	for (int face = 0; face < 6; ++face)
+	{
+		if (Dot(normal, kFaceNormal[face]) != 1)
+			continue;
+
+		int col = (Dot(position, kFaceRight[face]) + (num_layers_ - 1)) / 2;
+		int row = ((num_layers_ - 1) - Dot(position, kFaceUp[face])) / 2;
+		return GetFaceletIndex(face, row, col);
+	}
+
+	return -1;
+}
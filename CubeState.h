@@ -0,0 +1,60 @@
+#ifndef __CUBE_STATE_H__
+#define __CUBE_STATE_H__
+
+#include <vector>
+
+// The sticker colors of a n x n x n Rubik Cube, independent of the cubes and the renderer.
+//
+// The faces use the order of the Face enum: front(-Z), back(+Z), left(-X), right(+X), top(+Y), bottom(-Y),
+// the color of a facelet is the index of the face it belongs to in the solved state.
+// Facelets of a face are stored row by row as seen from outside the cube, row 0 is the top row and
+// column 0 is the left column, the top and bottom faces are seen with the front face at the bottom/top.
+// This is the layout of the cross net:
+//            top
+//     left  front  right  back
+//           bottom
+class CubeState
+{
+public:
+	explicit CubeState(int num_layers);
+	~CubeState(void);
+
+	int GetNumLayers() const;
+	int GetNumFacelets() const;		// 6 x n x n
+
+	// Facelet index of (face, row, col)
+	int GetFaceletIndex(int face, int row, int col) const;
+
+	unsigned char GetFacelet(int face, int row, int col) const;
+	void SetFacelet(int face, int row, int col, unsigned char color);
+
+	// All the facelet colors, GetNumFacelets() values in the order of GetFaceletIndex
+	const unsigned char* GetFacelets() const;
+	void SetFacelets(const unsigned char* facelets);
+
+	void Reset();
+	bool IsSolved() const;
+
+	// Rotate a layer by quarter_turns x 90 degrees, the layer id is counted as in RubikCube:
+	// 0 .. n - 1 along X axis(left -> right), n .. 2n - 1 along Y axis(bottom -> top),
+	// 2n .. 3n - 1 along Z axis(front -> back). A positive turn is the same rotation as
+	// RubikCube::RotateLayer with angle kPi / 2 around the positive axis.
+	void RotateLayer(int layer_id, int quarter_turns);
+
+	// Unit normal, right and up direction of a face as seen from outside the cube
+	static void GetFaceAxes(int face, int* normal, int* right, int* up);
+
+	bool operator==(const CubeState& other) const;
+	bool operator!=(const CubeState& other) const;
+
+private:
+	void GetFaceletPosition(int index, int* position) const;
+	int FindFacelet(const int* position, const int* normal) const;
+
+private:
+	int num_layers_;
+	std::vector<unsigned char> facelets_;
+	std::vector<unsigned char> rotated_;	// Scratch buffer of RotateLayer
+};
+
+#endif // end __CUBE_STATE_H__
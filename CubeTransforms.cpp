@@ -0,0 +1,306 @@
+#include "CubeTransforms.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Stream indices in streams_
+enum
+{
+	kX  = 0,
+	kY  = 1,
+	kZ  = 2,
+	kQX = 3,
+	kQY = 4,
+	kQZ = 5,
+	kQW = 6,
+};
+
+CubeTransforms::CubeTransforms(void)
+	: num_layers_(0),
+	  num_cubes_(0),
+	  stride_(0),
+	  cube_length_(0),
+	  pitch_(0)
+{
+	for (int i = 0; i < kNumStreams; ++i)
+	{
+		streams_[i] = NULL;
+	}
+}
+
+// The streams belong to the arena
+CubeTransforms::~CubeTransforms(void)
+{
+}
+
+void CubeTransforms::Init(int num_layers, float cube_length, float gap, Arena* arena)
+{
+	num_layers_  = num_layers;
+	num_cubes_   = num_layers * num_layers * num_layers;
+	stride_      = (num_cubes_ + 3) & ~3;
+	cube_length_ = cube_length;
+	pitch_       = cube_length + gap;
+
+	// The first stream starts at a 16 byte boundary, the stride keeps the others aligned
+	float* block = (float*)arena->Allocate(kNumStreams * stride_ * sizeof(float), 16);
+	for (int i = 0; i < kNumStreams; ++i)
+	{
+		streams_[i] = block + i * stride_;
+	}
+
+	Reset();
+}
+
+size_t CubeTransforms::GetStorageSize(int num_layers)
+{
+	int num_cubes = num_layers * num_layers * num_layers;
+	int stride = (num_cubes + 3) & ~3;
+	return kNumStreams * stride * sizeof(float) + 15;
+}
+
+// The padding cubes after num_cubes_ sit at the origin, they are rotated with the center layers but never read
+void CubeTransforms::Reset()
+{
+	for (int i = 0; i < kNumStreams; ++i)
+	{
+		memset(streams_[i], 0, stride_ * sizeof(float));
+	}
+
+	for (int i = 0; i < stride_; ++i)
+	{
+		streams_[kQW][i] = 1.0f;
+	}
+
+	for (int k = 0; k < num_layers_; ++k)
+	{
+		for (int j = 0; j < num_layers_; ++j)
+		{
+			for (int i = 0; i < num_layers_; ++i)
+			{
+				int n = i + (j * num_layers_) + (k * num_layers_ * num_layers_);
+				streams_[kX][n] = GetLayerCenter(i);
+				streams_[kY][n] = GetLayerCenter(j);
+				streams_[kZ][n] = GetLayerCenter(k);
+			}
+		}
+	}
+}
+
+void CubeTransforms::SetPlacement(const CubePlacement& placement)
+{
+	for (int n = 0; n < num_cubes_; ++n)
+	{
+		int slot = placement.GetSlot(n);
+		streams_[kX][n] = GetLayerCenter(slot % num_layers_);
+		streams_[kY][n] = GetLayerCenter((slot / num_layers_) % num_layers_);
+		streams_[kZ][n] = GetLayerCenter(slot / (num_layers_ * num_layers_));
+
+		const Quaternion& q = CubePlacement::GetOrientationQuaternion(placement.GetOrientation(n));
+		streams_[kQX][n] = q.x;
+		streams_[kQY][n] = q.y;
+		streams_[kQZ][n] = q.z;
+		streams_[kQW][n] = q.w;
+	}
+}
+
+int CubeTransforms::GetCount() const
+{
+	return num_cubes_;
+}
+
+Vector3 CubeTransforms::GetCenter(int cube) const
+{
+	return Vector3(streams_[kX][cube], streams_[kY][cube], streams_[kZ][cube]);
+}
+
+Quaternion CubeTransforms::GetOrientation(int cube) const
+{
+	return Quaternion(streams_[kQX][cube], streams_[kQY][cube], streams_[kQZ][cube], streams_[kQW][cube]);
+}
+
+float CubeTransforms::GetLayerCenter(int index) const
+{
+	return (index - (num_layers_ - 1) * 0.5f) * pitch_;
+}
+
+int CubeTransforms::GetLayerId(int cube, int axis) const
+{
+	int index = (int)floorf(streams_[axis][cube] / pitch_ + num_layers_ * 0.5f);
+	if (index < 0)
+		index = 0;
+	else if (index >= num_layers_)
+		index = num_layers_ - 1;
+
+	return index + axis * num_layers_;
+}
+
+bool CubeTransforms::InLayer(int cube, int layer_id) const
+{
+	return GetLayerId(cube, layer_id / num_layers_) == layer_id;
+}
+
+/*
+The unit cube mesh is scaled to the cube length and centered at the origin, rotated by the
+orientation, then moved to the center:
+world = Scaling(length) * Translation(-length / 2) * Rotation(orientation) * Translation(center)
+*/
+void CubeTransforms::GetWorldMatrix(int cube, Matrix* world) const
+{
+	Quaternion orientation = GetOrientation(cube);
+	MatrixRotationQuaternion(world, &orientation);
+
+	Vector3 center = GetCenter(cube);
+	float half_length = cube_length_ / 2;
+	for (int i = 0; i < 3; ++i)
+	{
+		world->m[3][i] = center[i] - half_length * (world->m[0][i] + world->m[1][i] + world->m[2][i]);
+		world->m[0][i] *= cube_length_;
+		world->m[1][i] *= cube_length_;
+		world->m[2][i] *= cube_length_;
+	}
+}
+
+/*
+Each cube in the layer gets
+center' = the center rotated by rotation, the same as Vec3TransformCoord with MatrixRotationQuaternion
+          t = 2 * cross(r, center), center' = center + w * t + cross(r, t), r is the vector part
+orientation' = QuaternionMultiply(orientation, rotation), the cube's rotation followed by the layer's
+A cube is in the layer if its center is less than half a pitch away from the layer center along the axis.
+*/
+void CubeTransforms::RotateLayer(int layer_id, const Quaternion& rotation)
+{
+	if (layer_id < 0)
+		return;
+
+	int axis = layer_id / num_layers_;
+	float layer_center = GetLayerCenter(layer_id % num_layers_);
+
+#if defined(MATH_SSE)
+	const __m128 rx = _mm_set1_ps(rotation.x);
+	const __m128 ry = _mm_set1_ps(rotation.y);
+	const __m128 rz = _mm_set1_ps(rotation.z);
+	const __m128 rw = _mm_set1_ps(rotation.w);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 center = _mm_set1_ps(layer_center);
+	const __m128 half_pitch = _mm_set1_ps(pitch_ / 2);
+	const __m128 zero = _mm_setzero_ps();
+
+	float* axis_stream = streams_[axis];
+
+	for (int i = 0; i < stride_; i += 4)
+	{
+		__m128 offset = _mm_sub_ps(_mm_load_ps(axis_stream + i), center);
+		__m128 distance = _mm_max_ps(offset, _mm_sub_ps(zero, offset));
+		__m128 mask = _mm_cmplt_ps(distance, half_pitch);
+		if (_mm_movemask_ps(mask) == 0)
+			continue;
+
+		__m128 x = _mm_load_ps(streams_[kX] + i);
+		__m128 y = _mm_load_ps(streams_[kY] + i);
+		__m128 z = _mm_load_ps(streams_[kZ] + i);
+
+		// t = 2 * cross(r, p)
+		__m128 tx = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(ry, z), _mm_mul_ps(rz, y)));
+		__m128 ty = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(rz, x), _mm_mul_ps(rx, z)));
+		__m128 tz = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(rx, y), _mm_mul_ps(ry, x)));
+
+		// p' = p + w * t + cross(r, t)
+		__m128 new_x = _mm_add_ps(_mm_add_ps(x, _mm_mul_ps(rw, tx)), _mm_sub_ps(_mm_mul_ps(ry, tz), _mm_mul_ps(rz, ty)));
+		__m128 new_y = _mm_add_ps(_mm_add_ps(y, _mm_mul_ps(rw, ty)), _mm_sub_ps(_mm_mul_ps(rz, tx), _mm_mul_ps(rx, tz)));
+		__m128 new_z = _mm_add_ps(_mm_add_ps(z, _mm_mul_ps(rw, tz)), _mm_sub_ps(_mm_mul_ps(rx, ty), _mm_mul_ps(ry, tx)));
+
+		_mm_store_ps(streams_[kX] + i, _mm_or_ps(_mm_and_ps(mask, new_x), _mm_andnot_ps(mask, x)));
+		_mm_store_ps(streams_[kY] + i, _mm_or_ps(_mm_and_ps(mask, new_y), _mm_andnot_ps(mask, y)));
+		_mm_store_ps(streams_[kZ] + i, _mm_or_ps(_mm_and_ps(mask, new_z), _mm_andnot_ps(mask, z)));
+
+		__m128 qx = _mm_load_ps(streams_[kQX] + i);
+		__m128 qy = _mm_load_ps(streams_[kQY] + i);
+		__m128 qz = _mm_load_ps(streams_[kQZ] + i);
+		__m128 qw = _mm_load_ps(streams_[kQW] + i);
+
+		// rotation * orientation in Hamilton order, which is QuaternionMultiply(orientation, rotation)
+		__m128 new_qx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rw, qx), _mm_mul_ps(qw, rx)), _mm_sub_ps(_mm_mul_ps(ry, qz), _mm_mul_ps(rz, qy)));
+		__m128 new_qy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rw, qy), _mm_mul_ps(qw, ry)), _mm_sub_ps(_mm_mul_ps(rz, qx), _mm_mul_ps(rx, qz)));
+		__m128 new_qz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rw, qz), _mm_mul_ps(qw, rz)), _mm_sub_ps(_mm_mul_ps(rx, qy), _mm_mul_ps(ry, qx)));
+		__m128 new_qw = _mm_sub_ps(_mm_mul_ps(rw, qw),
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, qx), _mm_mul_ps(ry, qy)), _mm_mul_ps(rz, qz)));
+
+		_mm_store_ps(streams_[kQX] + i, _mm_or_ps(_mm_and_ps(mask, new_qx), _mm_andnot_ps(mask, qx)));
+		_mm_store_ps(streams_[kQY] + i, _mm_or_ps(_mm_and_ps(mask, new_qy), _mm_andnot_ps(mask, qy)));
+		_mm_store_ps(streams_[kQZ] + i, _mm_or_ps(_mm_and_ps(mask, new_qz), _mm_andnot_ps(mask, qz)));
+		_mm_store_ps(streams_[kQW] + i, _mm_or_ps(_mm_and_ps(mask, new_qw), _mm_andnot_ps(mask, qw)));
+	}
+#else
+	RotateLayerScalar(axis, layer_center, rotation);
+#endif
+}
+
+void CubeTransforms::RotateLayerScalar(int axis, float layer_center, const Quaternion& rotation)
+{
+	Matrix rotate_matrix;
+	MatrixRotationQuaternion(&rotate_matrix, &rotation);
+
+	for (int i = 0; i < num_cubes_; ++i)
+	{
+		if (fabsf(streams_[axis][i] - layer_center) >= pitch_ / 2)
+			continue;
+
+		Vector3 center = GetCenter(i);
+		Vec3TransformCoord(&center, &center, &rotate_matrix);
+
+		Quaternion orientation = GetOrientation(i);
+		QuaternionMultiply(&orientation, &orientation, &rotation);
+
+		streams_[kX][i]  = center.x;
+		streams_[kY][i]  = center.y;
+		streams_[kZ][i]  = center.z;
+		streams_[kQX][i] = orientation.x;
+		streams_[kQY][i] = orientation.y;
+		streams_[kQZ][i] = orientation.z;
+		streams_[kQW][i] = orientation.w;
+	}
+}
+
+// The components of the 24 orientations of a cube are 0, 1/2, 1/sqrt(2) or 1 in magnitude,
+// the thresholds are the midpoints between them.
+static float SnapComponent(float value)
+{
+	float magnitude = fabsf(value);
+	float snapped;
+	if (magnitude < 0.25f)
+		snapped = 0.0f;
+	else if (magnitude < 0.6036f)
+		snapped = 0.5f;
+	else if (magnitude < 0.8536f)
+		snapped = 0.70710678f;
+	else
+		snapped = 1.0f;
+
+	return value < 0 ? -snapped : snapped;
+}
+
+void CubeTransforms::SnapLayer(int layer_id)
+{
+	if (layer_id < 0)
+		return;
+
+	for (int i = 0; i < num_cubes_; ++i)
+	{
+		if (!InLayer(i, layer_id))
+			continue;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			streams_[axis][i] = GetLayerCenter(GetLayerId(i, axis) - axis * num_layers_);
+		}
+
+		Quaternion orientation(SnapComponent(streams_[kQX][i]), SnapComponent(streams_[kQY][i]),
+			SnapComponent(streams_[kQZ][i]), SnapComponent(streams_[kQW][i]));
+		QuaternionNormalize(&orientation, &orientation);
+
+		streams_[kQX][i] = orientation.x;
+		streams_[kQY][i] = orientation.y;
+		streams_[kQZ][i] = orientation.z;
+		streams_[kQW][i] = orientation.w;
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef __CUBE_TRANSFORMS_H__
+#define __CUBE_TRANSFORMS_H__
+
+#include "Arena.h"
+#include "CubePlacement.h"
+#include "VectorMath.h"
+
+// Position and orientation of all the unit cubes of a num_layers x num_layers x num_layers Rubik Cube,
+// stored as structure of arrays in one 16 byte aligned block of the puzzle arena: the centers x[], y[], z[] and the
+// orientation quaternions qx[], qy[], qz[], qw[], each padded to a multiple of 4 cubes.
+// A layer turn is one pass over the arrays, 4 cubes at a time, the cubes outside the layer are
+// masked out, so no cube is touched through its own object.
+// Cube i + j * num_layers + k * num_layers^2 starts in layer i along X, j along Y and k along Z.
+// A cube's layer ids are found from its center, the coordinate along the turn axis does not change during a turn.
+class CubeTransforms
+{
+public:
+	CubeTransforms(void);
+	~CubeTransforms(void);
+
+	// The streams are allocated from the arena, which must have GetStorageSize(num_layers) bytes left
+	void Init(int num_layers, float cube_length, float gap, Arena* arena);
+	static size_t GetStorageSize(int num_layers);
+	void Reset();		// All cubes at their initial position, not rotated
+
+	// Move all cubes to the slots and orientations of the placement, which has the same number of layers
+	void SetPlacement(const CubePlacement& placement);
+
+	int GetCount() const;
+	Vector3 GetCenter(int cube) const;
+	Quaternion GetOrientation(int cube) const;
+
+	// Layer id along X(0), Y(1) or Z(2) axis. The layer ids are counted along X first, from left to right
+	// 0 to num_layers - 1, then along Y from bottom to top, then along Z from front to back.
+	int GetLayerId(int cube, int axis) const;
+	bool InLayer(int cube, int layer_id) const;
+
+	// The world matrix of the unit cube mesh(0, 0, 0) to (1, 1, 1) for the cube
+	void GetWorldMatrix(int cube, Matrix* world) const;
+
+	// Rotate the cubes of the layer further by rotation about the center of the Rubik Cube, layer -1 is no layer
+	void RotateLayer(int layer_id, const Quaternion& rotation);
+
+	// Put the cubes of the layer back on the grid after a whole turn, this drops the rounding errors of the steps
+	void SnapLayer(int layer_id);
+
+private:
+	void RotateLayerScalar(int axis, float layer_center, const Quaternion& rotation);
+	float GetLayerCenter(int index) const;		// Coordinate of the cube centers of layer index 0 to num_layers - 1
+
+private:
+	static const int kNumStreams = 7;	// x, y, z, qx, qy, qz, qw
+
+	int num_layers_;
+	int num_cubes_;
+	int stride_;			// Floats per stream, num_cubes_ rounded up to 4
+	float cube_length_;
+	float pitch_;			// Distance between the centers of neighbour cubes, cube length + gap
+
+	float* streams_[kNumStreams];	// Aligned streams in one arena block
+};
+
+#endif // end __CUBE_TRANSFORMS_H__
@@ -3,9 +3,21 @@
 D3D9::D3D9(void)
     : d3d_(NULL),
 	  d3ddevice_(NULL),
-	  is_fullscreen_(false)
+	  render_device_(NULL),
+	  state_cache_(NULL),
+	  font_(NULL),
+	  font_failed_(false),
+	  is_fullscreen_(false),
+	  proj_scale_x_(1.0f),
+	  proj_scale_y_(1.0f),
+	  picking_version_(0),
+	  picking_valid_(false)
 {
 	camera = new Camera();
+
+	ZeroMemory(&viewport_, sizeof(viewport_));
+	viewport_.Width  = 1;
+	viewport_.Height = 1;
 }
 
 D3D9::~D3D9(void)
@@ -13,6 +25,19 @@ D3D9::~D3D9(void)
 	delete camera;
 	camera = NULL;
 
+	// Release render device resources before the device
+	if(font_ != NULL)
+	{
+		font_->Release();
+		font_ = NULL;
+	}
+
+	delete state_cache_;
+	state_cache_ = NULL;
+
+	delete render_device_;
+	render_device_ = NULL;
+
 	// Release Direct3D Device
 	if(d3ddevice_ != NULL)
 	{
@@ -82,174 +107,66 @@ void D3D9::InitD3D9(HWND hWnd)
 		MessageBox(hWnd, L"Create Direct3D9 device failed!", L"error!", 0) ;
 	}
 
+	render_device_ = new D3D9RenderDevice(d3ddevice_);
+
+	// All the states are set through the state cache, so the states which were not changed
+	// since the last frame are not sent to the device again.
+	state_cache_ = new StateCacheRenderDevice(render_device_);
+
 	// Setup view matrix
-	D3DXVECTOR3 vecEye(0.0f, 0.0f, -10.0f);
-	D3DXVECTOR3 vecAt (0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vecUp (0.0f, 1.0f, 0.0f) ;
+	Vector3 vecEye(0.0f, 0.0f, -10.0f);
+	Vector3 vecAt (0.0f, 0.0f, 0.0f);
+	Vector3 vecUp (0.0f, 1.0f, 0.0f) ;
 	camera->SetViewParams(vecEye, vecAt, vecUp);
 	
 	// Setup projection matrix
 	float aspectRatio = (float)d3dpp_.BackBufferWidth / (float)d3dpp_.BackBufferHeight ;
-	camera->SetProjParams(D3DX_PI / 4, aspectRatio, 1.0f, 1000.0f) ;
+	camera->SetProjParams(kPi / 4, aspectRatio, 1.0f, 1000.0f) ;
 
 	ResetDevice();
 }
 
-LPDIRECT3DTEXTURE9 D3D9::CreateTexture(int texWidth, int texHeight, D3DCOLOR color)
-{
-	LPDIRECT3DTEXTURE9 pTexture;
-
-	HRESULT hr = D3DXCreateTexture(d3ddevice_, 
-		texWidth, 
-		texHeight, 
-		0, 
-		0, 
-		D3DFMT_A8R8G8B8,  // 4 bytes for a pixel 
-		D3DPOOL_MANAGED, 
-		&pTexture);
-
-	if (FAILED(hr))
-	{
-		MessageBox(NULL, L"Create texture failed", L"Error", 0);
-	}
-
-	// Lock the texture and fill in color
-	D3DLOCKED_RECT lockedRect;
-	hr = pTexture->LockRect(0, &lockedRect, NULL, 0);
-	if (FAILED(hr))
-	{
-		MessageBox(NULL, L"Lock texture failed!", L"Error", 0);
-	}
-
-	DWORD sideColor = 0xff000000; // the side line color
-
-	int side_width = 10;
-
-	// Calculate number of rows in the locked Rect
-	int rowCount = (texWidth * texHeight * 4 ) / lockedRect.Pitch;
-
-	for (int i = 0; i < texWidth; ++i)
-	{
-		for (int j = 0; j < texHeight; ++j)
-		{
-			int index = i * rowCount + j;
-
-			int* pData = (int*)lockedRect.pBits;
-
-			if (i <= side_width || i >= texWidth - side_width 
-				|| j <= side_width || j >= texHeight - side_width)
-			{
-				memcpy(&pData[index], &sideColor, 4);
-			}
-			else
-			{
-				memcpy(&pData[index], &color, 4);
-			}
-		}
-	}
-
-	pTexture->UnlockRect(0);
-
-	return pTexture;
-}
-
-LPDIRECT3DTEXTURE9 D3D9::CreateInnerTexture(int texWidth, int texHeight, D3DCOLOR color)
-{
-	LPDIRECT3DTEXTURE9 pTexture;
-
-	HRESULT hr = D3DXCreateTexture(d3ddevice_, 
-		texWidth, 
-		texHeight, 
-		0, 
-		0, 
-		D3DFMT_A8R8G8B8,  // 4 bytes for a pixel 
-		D3DPOOL_MANAGED, 
-		&pTexture);
-
-	if(FAILED(hr))
-	{
-		MessageBox(NULL, L"Create texture failed", L"Error", 0);
-	}
-
-	// Lock the texture and fill in color
-	D3DLOCKED_RECT lockedRect;
-	hr = pTexture->LockRect(0, &lockedRect, NULL, 0);
-	if(FAILED(hr))
-	{
-		MessageBox(NULL, L"Lock texture failed!", L"Error", 0);
-	}
-
-	DWORD sideColor = 0xff121212; // the side line color
-
-	// Calculate number of rows in the locked Rect
-	int rowCount = (texWidth * texHeight * 4 ) / lockedRect.Pitch;
-
-	for (int i = 0; i < texWidth; ++i)
-	{
-		for (int j = 0; j < texHeight; ++j)
-		{
-			int index = i * rowCount + j;
-
-			int* pData = (int*)lockedRect.pBits;
-		
-			memcpy(&pData[index], &color, 4);
-		}
-	}
-
-	pTexture->UnlockRect(0);
-
-	return pTexture;
-}
-
 void D3D9::SetupMatrix()
 {
 	// View matrix
-	D3DXMATRIX matView = camera->GetViewMatrix() ;
-	d3ddevice_->SetTransform(D3DTS_VIEW, &matView) ;
+	Matrix matView = camera->GetViewMatrix() ;
+	state_cache_->SetTransform(kViewTransform, matView) ;
 
 	// Projection matrix
-	D3DXMATRIX matProj = camera->GetProjMatrix() ;
-	d3ddevice_->SetTransform(D3DTS_PROJECTION, &matProj) ;
+	Matrix matProj = camera->GetProjMatrix() ;
+	state_cache_->SetTransform(kProjectionTransform, matProj) ;
 }
 
 void D3D9::SetupLight()
 {
-	// Create light
-	D3DLIGHT9 pointLight ;
-
-	// Light color
-	D3DXCOLOR color = D3DCOLOR_XRGB(255, 255, 255) ;
-
 	// The light position is always same as the camera eye point
 	// so no matter how you rotate the camera, the cube will keep the same brightness
-	 D3DXVECTOR3 position = camera->GetEyePoint() ;
-
-	// Light type, we use point light here
-	pointLight.Type			= D3DLIGHT_POINT ;
-
-	// Light attributes
-	pointLight.Ambient		= color * 0.6f;
-	pointLight.Diffuse		= color;
-	pointLight.Specular		= color * 0.6f;
-	pointLight.Position		= position;
-	pointLight.Range		= 320.0f;
-	pointLight.Falloff		= 1.0f;
-	pointLight.Attenuation0	= 1.0f;
-	pointLight.Attenuation1	= 0.0f;
-	pointLight.Attenuation2	= 0.0f;
+	Vector3 position = camera->GetEyePoint() ;
+
+	// Point light, white color
+	Light pointLight =
+	{
+		{ position.x, position.y, position.z },	// position
+		{ 0.6f, 0.6f, 0.6f, 0.6f },				// ambient
+		{ 1.0f, 1.0f, 1.0f, 1.0f },				// diffuse
+		{ 0.6f, 0.6f, 0.6f, 0.6f },				// specular
+		320.0f,									// range
+		{ 1.0f, 0.0f, 0.0f },					// attenuation
+	};
 
 	// Set material
-	D3DMATERIAL9 material ;
-	material.Ambient = D3DXCOLOR(1.0f, 1.0f, 1.0f, 0) ;
-	material.Diffuse = D3DXCOLOR(1.0f, 1.0f, 1.0f, 0);
-	material.Specular = D3DXCOLOR(1.0f, 1.0f, 1.0f, 0);
-	material.Emissive = D3DXCOLOR(0.0f, 0.0f, 0.0f, 0.0f);
-	material.Power = 2.0f ;
-	d3ddevice_->SetMaterial(&material) ;
+	Material material =
+	{
+		{ 1.0f, 1.0f, 1.0f, 0.0f },	// ambient
+		{ 1.0f, 1.0f, 1.0f, 0.0f },	// diffuse
+		{ 1.0f, 1.0f, 1.0f, 0.0f },	// specular
+		{ 0.0f, 0.0f, 0.0f, 0.0f },	// emissive
+		2.0f,						// power
+	};
+	state_cache_->SetMaterial(material) ;
 
 	// Enable light
-	d3ddevice_->SetLight(0, &pointLight) ;		
-	d3ddevice_->LightEnable(0, true) ;		
+	state_cache_->SetLight(0, pointLight) ;
 }
 
 void D3D9::ResizeD3DScene(int width, int height)
@@ -261,7 +178,7 @@ void D3D9::ResizeD3DScene(int width, int height)
 	float fAspectRatio = width / (FLOAT)height;
 
 	// Setup Projection matrix
-	camera->SetProjParams(D3DX_PI / 4, fAspectRatio, 1.0f, 1000.0f);
+	camera->SetProjParams(kPi / 4, fAspectRatio, 1.0f, 1000.0f);
 
 	camera->SetWindow(width, height);
 }
@@ -276,10 +193,23 @@ HRESULT D3D9::ResetDevice()
 	// Device can be reset now
 	if (SUCCEEDED(hr) || hr == D3DERR_DEVICENOTRESET)
 	{
+		// The font holds default pool resources, which must be released before Reset
+		if (font_ != NULL)
+			font_->OnLostDevice();
+
 		// Reset device
 		HRESULT hr = d3ddevice_->Reset(&d3dpp_);
 		if (SUCCEEDED(hr))
 		{
+			// All the device states were reset
+			state_cache_->Invalidate();
+
+			if (font_ != NULL)
+				font_->OnResetDevice();
+
+			// The viewport was reset to the new back buffer size
+			d3ddevice_->GetViewport(&viewport_);
+
 			ResizeD3DScene(d3dpp_.BackBufferWidth, d3dpp_.BackBufferHeight) ;
 		}
 		else // Reset device failed, show error box
@@ -307,91 +237,121 @@ void D3D9::FrameMove()
 	camera->OnFrameMove() ;
 }
 
-// Calculate the picking ray and transform it to model space 
-// x and y are the screen coordinates when left button down
-Ray D3D9::CalculatePickingRay(int x, int y)
+// Draw a line of text on top of the scene, call between BeginScene and EndScene.
+// The font draws through its own sprite, so the cached states are not trusted after it.
+// The font is only needed by the overlay, so it is created when the first text is drawn
+void D3D9::DrawOverlayText(const WCHAR* text, int x, int y, D3DCOLOR color)
 {
-	float px = 0.0f;
-	float py = 0.0f;
-
-	// Get viewport
-	D3DVIEWPORT9 vp;
-	d3ddevice_->GetViewport(&vp);
-
-	// Get Projection matrix
-	D3DXMATRIX proj;
-	d3ddevice_->GetTransform(D3DTS_PROJECTION, &proj);
+	if (font_ == NULL && !font_failed_)
+	{
+		HRESULT hr = D3DXCreateFont(d3ddevice_, 16, 0, FW_NORMAL, 1, FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
+			DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Consolas", &font_);
+		if(FAILED(hr))
+		{
+			MessageBox(NULL, L"Create font failed!", L"error!", 0) ;
+			font_ = NULL;
+			font_failed_ = true;
+		}
+	}
 
-	px = ((( 2.0f*x) / vp.Width)  - 1.0f) / proj(0, 0);
-	py = (((-2.0f*y) / vp.Height) + 1.0f) / proj(1, 1);
+	if (font_ == NULL)
+		return;
 
-	Ray ray;
-	ray.origin    = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
-	ray.direction = D3DXVECTOR3(px, py, 1.0f); 
+	RECT rect = { x, y, x, y };
+	font_->DrawText(NULL, text, -1, &rect, DT_LEFT | DT_NOCLIP, color);
 
-	// Get view matrix
-	D3DXMATRIX view;
-	d3ddevice_->GetTransform(D3DTS_VIEW, &view);
+	state_cache_->Invalidate();
+}
 
-	// Get world matrix
-	D3DXMATRIX world;
-	d3ddevice_->GetTransform(D3DTS_WORLD, &world);
+bool D3D9::NeedFrameMove() const
+{
+	return camera->NeedFrameMove() ;
+}
 
-	// Concatinate them in to single matrix
-	D3DXMATRIX WorldView = world * view;
+// Calculate the picking ray and transform it to model space 
+// x and y are the screen coordinates when left button down
+Ray D3D9::CalculatePickingRay(int x, int y)
+{
+	POINT point = { x, y };
 
-	// inverse it
-	D3DXMATRIX worldviewInverse;
-	D3DXMatrixInverse(&worldviewInverse, 0, &WorldView);
+	Ray ray;
+	CalculatePickingRays(&point, 1, &ray);
 
+	return ray;
+}
 
-	// Transform the ray to model space
-	D3DXVec3TransformCoord(&ray.origin, &ray.origin, &worldviewInverse) ;
-	D3DXVec3TransformNormal(&ray.direction, &ray.direction, &worldviewInverse) ;
+// Transform the screen point to vector in model space
+Vector3 D3D9::ScreenToVector3(int x, int y)
+{
+	POINT point = { x, y };
 
-	// Normalize the direction
-	D3DXVec3Normalize(&ray.direction, &ray.direction) ;
+	Vector3 vector3;
+	ScreenToVectors3(&point, 1, &vector3);
 
-	return ray;
+	return vector3;
 }
 
-// Transform the screen point to vector in model space
-D3DXVECTOR3 D3D9::ScreenToVector3(int x, int y)
+void D3D9::CalculatePickingRays(const POINT* points, int num_points, Ray* rays)
 {
-	D3DXVECTOR3 vector3 ;
+	UpdatePickingTransform();
 
-	// Get viewport
-	D3DVIEWPORT9 vp;
-	d3ddevice_->GetViewport(&vp);
+	// The ray starts from the eye point, which is the origin in view space
+	Vector3 origin(0.0f, 0.0f, 0.0f);
+	Vec3TransformCoord(&origin, &origin, &world_view_inverse_) ;
 
-	// Get Projection matrix
-	D3DXMATRIX proj;
-	d3ddevice_->GetTransform(D3DTS_PROJECTION, &proj);
+	for (int i = 0; i < num_points; ++i)
+	{
+		float px = ((( 2.0f * points[i].x) / viewport_.Width)  - 1.0f) / proj_scale_x_;
+		float py = (((-2.0f * points[i].y) / viewport_.Height) + 1.0f) / proj_scale_y_;
 
-	vector3.x = ((( 2.0f*x) / vp.Width)  - 1.0f) / proj(0, 0);
-	vector3.y = (((-2.0f*y) / vp.Height) + 1.0f) / proj(1, 1);
-	vector3.z = 1.0f ;
+		// Transform the ray to model space
+		Vector3 direction(px, py, 1.0f);
+		Vec3TransformNormal(&direction, &direction, &world_view_inverse_) ;
 
-	// Get view matrix
-	D3DXMATRIX view;
-	d3ddevice_->GetTransform(D3DTS_VIEW, &view);
+		// Normalize the direction
+		rays[i].origin = origin;
+		Vec3Normalize(&rays[i].direction, &direction) ;
+	}
+}
 
-	// Get world matrix
-	D3DXMATRIX world;
-	d3ddevice_->GetTransform(D3DTS_WORLD, &world);
+void D3D9::ScreenToVectors3(const POINT* points, int num_points, Vector3* vectors)
+{
+	UpdatePickingTransform();
 
-	// Concatinate them in to single matrix
-	D3DXMATRIX WorldView = world * view;
+	for (int i = 0; i < num_points; ++i)
+	{
+		Vector3 vector3;
+		vector3.x = ((( 2.0f * points[i].x) / viewport_.Width)  - 1.0f) / proj_scale_x_;
+		vector3.y = (((-2.0f * points[i].y) / viewport_.Height) + 1.0f) / proj_scale_y_;
+		vector3.z = 1.0f ;
 
-	// inverse it
-	D3DXMATRIX worldviewInverse;
-	D3DXMatrixInverse(&worldviewInverse, 0, &WorldView);
+		Vec3TransformCoord(&vector3, &vector3, &world_view_inverse_) ;
 
-	D3DXVec3TransformCoord(&vector3, &vector3, &worldviewInverse) ;
+		Vec3Normalize(&vectors[i], &vector3) ;
+	}
+}
 
-	D3DXVec3Normalize(&vector3, &vector3) ;
+/*
+Picking used to read the viewport and the transforms back from the device and invert the world-view
+matrix on every mouse move. The transforms on the device are the camera matrices set by SetupMatrix,
+so they are taken from the camera instead, and the inverse is only computed again when the camera
+version changed. The viewport only changes with a device reset, it is read once after each reset.
+*/
+void D3D9::UpdatePickingTransform()
+{
+	if (picking_valid_ && picking_version_ == camera->GetVersion())
+		return;
+
+	Matrix proj = camera->GetProjMatrix();
+	proj_scale_x_ = proj(0, 0);
+	proj_scale_y_ = proj(1, 1);
+
+	// Concatinate them in to single matrix and inverse it
+	Matrix world_view = camera->GetWorldMatrix() * camera->GetViewMatrix();
+	MatrixInverse(&world_view_inverse_, 0, &world_view);
 
-	return vector3 ;
+	picking_version_ = camera->GetVersion();
+	picking_valid_ = true;
 }
 
 LRESULT D3D9::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
@@ -409,6 +369,21 @@ LPDIRECT3DDEVICE9 D3D9::GetD3DDevice() const
 	return d3ddevice_;
 }
 
+RenderDevice* D3D9::GetRenderDevice() const
+{
+	return state_cache_;
+}
+
+Camera* D3D9::GetCamera() const
+{
+	return camera;
+}
+
+StateCacheRenderDevice* D3D9::GetStateCache() const
+{
+	return state_cache_;
+}
+
 D3DPRESENT_PARAMETERS D3D9::GetD3Dpp() const
 {
 	return d3dpp_;
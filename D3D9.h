@@ -5,6 +5,8 @@
 #include <DxErr.h>
 
 #include "Camera.h"
+#include "D3D9RenderDevice.h"
+#include "StateCacheRenderDevice.h"
 #include "Math.h"
 
 class D3D9
@@ -15,21 +17,29 @@ public:
 
 public:
 	void InitD3D9(HWND hWnd);
-	LPDIRECT3DTEXTURE9 CreateTexture(int texWidth, int texHeight, D3DCOLOR color);
-	LPDIRECT3DTEXTURE9 CreateInnerTexture(int texWidth, int texHeight, D3DCOLOR color);
 	void ResizeD3DScene(int width, int height);
 	HRESULT ResetDevice();
 	void ToggleFullScreen();
 	void SetupLight();
 	void SetupMatrix();
 	void FrameMove();
+	bool NeedFrameMove() const;
+	void DrawOverlayText(const WCHAR* text, int x, int y, D3DCOLOR color);
 	Ray CalculatePickingRay(int x, int y);
-	D3DXVECTOR3 ScreenToVector3(int x, int y);
+	Vector3 ScreenToVector3(int x, int y);
+
+	// Batch versions of the above, the points are unprojected with the same cached transform
+	void CalculatePickingRays(const POINT* points, int num_points, Ray* rays);
+	void ScreenToVectors3(const POINT* points, int num_points, Vector3* vectors);
+
 	LRESULT HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
 	//HWND getWindowHandle() const;
 	LPDIRECT3D9 GetD3D9() const;
 	LPDIRECT3DDEVICE9 GetD3DDevice() const;
+	RenderDevice* GetRenderDevice() const;		// The state cache in front of the D3D9 render device
+	Camera* GetCamera() const;
+	StateCacheRenderDevice* GetStateCache() const;
 	D3DPRESENT_PARAMETERS GetD3Dpp() const;
 
 	void SetBackBufferWidth(int width);
@@ -50,6 +60,10 @@ public:
 private:
 	LPDIRECT3D9				d3d_;			// Direct3D object
 	LPDIRECT3DDEVICE9		d3ddevice_;		// D3D9 Device
+	D3D9RenderDevice*		render_device_;	// Render device on top of d3ddevice_
+	StateCacheRenderDevice*	state_cache_;	// Drops the redundant state changes before render_device_
+	LPD3DXFONT				font_;			// Font of the overlay text, created by the first DrawOverlayText
+	bool					font_failed_;	// The font could not be created, it is not tried again
 	D3DPRESENT_PARAMETERS	d3dpp_;			// D3D presentation parameters
 	bool					is_fullscreen_;	// Is Game in Full-Screen mode?
 
@@ -60,8 +74,19 @@ private:
 	int screen_width_;	// The maximum resolution width
 	int screen_height_;	// The maximum resolution height
 
+private:
+	void UpdatePickingTransform();
+
 private:
 	Camera*					camera;			// Model-view camera
+
+	// Picking transform, recomputed when the camera version changed
+	D3DVIEWPORT9			viewport_;				// Viewport of the device, read after each reset
+	Matrix				world_view_inverse_;	// Inverse of world * view
+	float					proj_scale_x_;			// proj(0, 0)
+	float					proj_scale_y_;			// proj(1, 1)
+	unsigned int			picking_version_;		// Camera version of the picking transform
+	bool					picking_valid_;			// false until the first picking
 };
 
 #endif // end __D3D9_H__
\ No newline at end of file
@@ -0,0 +1,445 @@
+#include "D3D9RenderDevice.h"
+
+// Map the neutral vertex format to FVF
+static const DWORD kVertexFormatFVF[kNumVertexFormats] =
+{
+	D3DFVF_XYZ | D3DFVF_NORMAL | D3DFVF_TEX1,	// kVertexPositionNormalTexture
+};
+
+// FVF of the vertices expanded by the instanced draw
+static const DWORD kColoredVertexFVF = D3DFVF_XYZ | D3DFVF_NORMAL | D3DFVF_DIFFUSE | D3DFVF_TEX1;
+
+static const D3DTRANSFORMSTATETYPE kTransformStates[kNumTransformTypes] =
+{
+	D3DTS_WORLD,		// kWorldTransform
+	D3DTS_VIEW,			// kViewTransform
+	D3DTS_PROJECTION,	// kProjectionTransform
+};
+
+static D3DCOLORVALUE ToColorValue(const float color[4])
+{
+	D3DCOLORVALUE value;
+	value.r = color[0];
+	value.g = color[1];
+	value.b = color[2];
+	value.a = color[3];
+	return value;
+}
+
+D3D9RenderDevice::D3D9RenderDevice(LPDIRECT3DDEVICE9 d3d_device)
+	: d3ddevice_(d3d_device),
+	  vertex_buffer_(kInvalidHandle),
+	  index_buffer_(kInvalidHandle),
+	  stride_(0),
+	  vertex_format_(kVertexPositionNormalTexture),
+	  bindings_lost_(false)
+{
+}
+
+D3D9RenderDevice::~D3D9RenderDevice(void)
+{
+	// Release all the buffers and textures still alive
+	for (size_t i = 0; i < buffers_.size(); ++i)
+	{
+		ReleaseBuffer((BufferHandle)i);
+	}
+
+	for (size_t i = 0; i < textures_.size(); ++i)
+	{
+		ReleaseTexture((TextureHandle)i);
+	}
+}
+
+BufferHandle D3D9RenderDevice::AddBuffer(LPDIRECT3DVERTEXBUFFER9 vertex_buffer, LPDIRECT3DINDEXBUFFER9 index_buffer, int size)
+{
+	Buffer buffer;
+	buffer.vertex_buffer = vertex_buffer;
+	buffer.index_buffer  = index_buffer;
+	buffer.size          = size;
+	buffer.data.resize(size);
+
+	// Reuse a released slot if there is one
+	for (size_t i = 0; i < buffers_.size(); ++i)
+	{
+		if (buffers_[i].vertex_buffer == NULL && buffers_[i].index_buffer == NULL)
+		{
+			buffers_[i] = buffer;
+			return (BufferHandle)i;
+		}
+	}
+
+	buffers_.push_back(buffer);
+	return (BufferHandle)(buffers_.size() - 1);
+}
+
+BufferHandle D3D9RenderDevice::CreateVertexBuffer(const void* vertices, int size, VertexFormat format)
+{
+	LPDIRECT3DVERTEXBUFFER9 vertex_buffer = NULL;
+
+	if (FAILED(d3ddevice_->CreateVertexBuffer(size,
+		D3DUSAGE_WRITEONLY,
+		kVertexFormatFVF[format],
+		D3DPOOL_MANAGED,
+		&vertex_buffer,
+		NULL)))
+	{
+		MessageBox(NULL, L"Create vertex buffer failed", L"Error", 0);
+		return kInvalidHandle;
+	}
+
+	BufferHandle handle = AddBuffer(vertex_buffer, NULL, size);
+	UpdateBuffer(handle, vertices, 0, size);
+
+	return handle;
+}
+
+BufferHandle D3D9RenderDevice::CreateIndexBuffer(const unsigned short* indices, int num_indices)
+{
+	LPDIRECT3DINDEXBUFFER9 index_buffer = NULL;
+	int size = num_indices * sizeof(WORD);
+
+	if (FAILED(d3ddevice_->CreateIndexBuffer(size,
+		D3DUSAGE_WRITEONLY,
+		D3DFMT_INDEX16,
+		D3DPOOL_MANAGED,
+		&index_buffer,
+		0)))
+	{
+		MessageBox(NULL, L"Create index buffer failed", L"Error", 0);
+		return kInvalidHandle;
+	}
+
+	BufferHandle handle = AddBuffer(NULL, index_buffer, size);
+	UpdateBuffer(handle, indices, 0, size);
+
+	return handle;
+}
+
+void D3D9RenderDevice::UpdateBuffer(BufferHandle buffer, const void* data, int offset, int size)
+{
+	if (buffer == kInvalidHandle || data == NULL)
+		return;
+
+	Buffer& b = buffers_[buffer];
+
+	VOID* pData = NULL;
+	HRESULT hr = E_FAIL;
+
+	if (b.vertex_buffer != NULL)
+		hr = b.vertex_buffer->Lock(offset, size, &pData, 0);
+	else if (b.index_buffer != NULL)
+		hr = b.index_buffer->Lock(offset, size, &pData, 0);
+
+	if (FAILED(hr))
+	{
+		MessageBox(NULL, L"Copy buffer data failed", L"Error", 0);
+		return;
+	}
+
+	memcpy(pData, data, size);
+	memcpy(&b.data[offset], data, size);
+
+	if (b.vertex_buffer != NULL)
+		b.vertex_buffer->Unlock();
+	else
+		b.index_buffer->Unlock();
+}
+
+void D3D9RenderDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	if (buffer == kInvalidHandle)
+		return;
+
+	Buffer& b = buffers_[buffer];
+
+	if (b.vertex_buffer != NULL)
+	{
+		b.vertex_buffer->Release();
+		b.vertex_buffer = NULL;
+	}
+
+	if (b.index_buffer != NULL)
+	{
+		b.index_buffer->Release();
+		b.index_buffer = NULL;
+	}
+
+	std::vector<BYTE>().swap(b.data);
+}
+
+TextureHandle D3D9RenderDevice::CreateTexture(int width, int height, const unsigned int* pixels)
+{
+	LPDIRECT3DTEXTURE9 pTexture = NULL;
+
+	HRESULT hr = D3DXCreateTexture(d3ddevice_,
+		width,
+		height,
+		1,
+		0,
+		D3DFMT_A8R8G8B8,  // 4 bytes for a pixel
+		D3DPOOL_MANAGED,
+		&pTexture);
+
+	if (FAILED(hr))
+	{
+		MessageBox(NULL, L"Create texture failed", L"Error", 0);
+		return kInvalidHandle;
+	}
+
+	// Lock the texture and copy the pixels row by row, the Pitch of the locked rect may be larger than the row size.
+	D3DLOCKED_RECT lockedRect;
+	hr = pTexture->LockRect(0, &lockedRect, NULL, 0);
+	if (FAILED(hr))
+	{
+		MessageBox(NULL, L"Lock texture failed!", L"Error", 0);
+		pTexture->Release();
+		return kInvalidHandle;
+	}
+
+	BYTE* pRow = (BYTE*)lockedRect.pBits;
+	for (int i = 0; i < height; ++i)
+	{
+		memcpy(pRow, pixels + i * width, width * 4);
+		pRow += lockedRect.Pitch;
+	}
+
+	pTexture->UnlockRect(0);
+
+	// Reuse a released slot if there is one
+	for (size_t i = 0; i < textures_.size(); ++i)
+	{
+		if (textures_[i] == NULL)
+		{
+			textures_[i] = pTexture;
+			return (TextureHandle)i;
+		}
+	}
+
+	textures_.push_back(pTexture);
+	return (TextureHandle)(textures_.size() - 1);
+}
+
+void D3D9RenderDevice::UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels)
+{
+	if (texture == kInvalidHandle || textures_[texture] == NULL)
+		return;
+
+	// Only the updated rectangle is locked, so the managed texture uploads only the dirty part
+	RECT rect = { x, y, x + width, y + height };
+	D3DLOCKED_RECT lockedRect;
+	HRESULT hr = textures_[texture]->LockRect(0, &lockedRect, &rect, 0);
+	if (FAILED(hr))
+	{
+		MessageBox(NULL, L"Lock texture failed!", L"Error", 0);
+		return;
+	}
+
+	BYTE* pRow = (BYTE*)lockedRect.pBits;
+	for (int i = 0; i < height; ++i)
+	{
+		memcpy(pRow, pixels + i * width, width * 4);
+		pRow += lockedRect.Pitch;
+	}
+
+	textures_[texture]->UnlockRect(0);
+}
+
+void D3D9RenderDevice::ReleaseTexture(TextureHandle texture)
+{
+	if (texture == kInvalidHandle || textures_[texture] == NULL)
+		return;
+
+	textures_[texture]->Release();
+	textures_[texture] = NULL;
+}
+
+void D3D9RenderDevice::SetTransform(TransformType type, const float* matrix)
+{
+	d3ddevice_->SetTransform(kTransformStates[type], (const D3DMATRIX*)matrix);
+}
+
+void D3D9RenderDevice::SetTexture(TextureHandle texture)
+{
+	d3ddevice_->SetTexture(0, texture == kInvalidHandle ? NULL : textures_[texture]);
+}
+
+void D3D9RenderDevice::SetStreamSource(BufferHandle vertex_buffer, int stride)
+{
+	vertex_buffer_ = vertex_buffer;
+	stride_ = stride;
+	d3ddevice_->SetStreamSource(0, vertex_buffer == kInvalidHandle ? NULL : buffers_[vertex_buffer].vertex_buffer, 0, stride);
+}
+
+void D3D9RenderDevice::SetIndices(BufferHandle index_buffer)
+{
+	index_buffer_ = index_buffer;
+	d3ddevice_->SetIndices(index_buffer == kInvalidHandle ? NULL : buffers_[index_buffer].index_buffer);
+}
+
+void D3D9RenderDevice::SetVertexFormat(VertexFormat format)
+{
+	vertex_format_ = format;
+	d3ddevice_->SetFVF(kVertexFormatFVF[format]);
+}
+
+void D3D9RenderDevice::SetLight(int index, const Light& light)
+{
+	D3DLIGHT9 pointLight;
+	ZeroMemory(&pointLight, sizeof(pointLight));
+
+	pointLight.Type			= D3DLIGHT_POINT;
+	pointLight.Ambient		= ToColorValue(light.ambient);
+	pointLight.Diffuse		= ToColorValue(light.diffuse);
+	pointLight.Specular		= ToColorValue(light.specular);
+	pointLight.Position		= D3DXVECTOR3(light.position[0], light.position[1], light.position[2]);
+	pointLight.Range		= light.range;
+	pointLight.Falloff		= 1.0f;
+	pointLight.Attenuation0	= light.attenuation[0];
+	pointLight.Attenuation1	= light.attenuation[1];
+	pointLight.Attenuation2	= light.attenuation[2];
+
+	d3ddevice_->SetLight(index, &pointLight);
+	d3ddevice_->LightEnable(index, true);
+}
+
+void D3D9RenderDevice::SetMaterial(const Material& material)
+{
+	D3DMATERIAL9 d3d_material;
+	d3d_material.Ambient  = ToColorValue(material.ambient);
+	d3d_material.Diffuse  = ToColorValue(material.diffuse);
+	d3d_material.Specular = ToColorValue(material.specular);
+	d3d_material.Emissive = ToColorValue(material.emissive);
+	d3d_material.Power    = material.power;
+
+	d3ddevice_->SetMaterial(&d3d_material);
+}
+
+void D3D9RenderDevice::DrawIndexedPrimitive(PrimitiveType type, int num_vertices, int start_index, int primitive_count)
+{
+	if (bindings_lost_)
+	{
+		RestoreBindings();
+	}
+
+	D3DPRIMITIVETYPE d3d_type = (type == kTriangleStrip) ? D3DPT_TRIANGLESTRIP : D3DPT_TRIANGLELIST;
+	d3ddevice_->DrawIndexedPrimitive(d3d_type, 0, 0, num_vertices, start_index, primitive_count);
+}
+
+// The fixed pipeline has no hardware instancing, so the instances are expanded on the CPU:
+// every instance's copy of the mesh is transformed by its world matrix, colored by its instance colors
+// and all the copies are sent to the device with one DrawIndexedPrimitiveUP call(split in batches
+// only when the 16 bit indices overflow). The quads hidden by the face mask are neither transformed nor drawn.
+void D3D9RenderDevice::DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances)
+{
+	if (vertex_buffer_ == kInvalidHandle || index_buffer_ == kInvalidHandle || num_instances <= 0)
+		return;
+
+	const Vertex* vertices = (const Vertex*)&buffers_[vertex_buffer_].data[0];
+	const WORD* indices = (const WORD*)&buffers_[index_buffer_].data[0] + start_index;
+	int num_indices = primitive_count * 3;
+
+	int max_instances_per_batch = 0xffff / num_vertices;
+	int batch_size = min(num_instances, max_instances_per_batch);
+
+	instance_vertices_.resize(batch_size * num_vertices);
+	instance_indices_.resize(batch_size * num_indices);
+
+	// Take the diffuse and ambient color from the vertex color
+	d3ddevice_->SetRenderState(D3DRS_DIFFUSEMATERIALSOURCE, D3DMCS_COLOR1);
+	d3ddevice_->SetRenderState(D3DRS_AMBIENTMATERIALSOURCE, D3DMCS_COLOR1);
+	d3ddevice_->SetFVF(kColoredVertexFVF);
+
+	for (int first = 0; first < num_instances; first += batch_size)
+	{
+		int count = min(batch_size, num_instances - first);
+		int num_batch_indices = 0;
+
+		for (int i = 0; i < count; ++i)
+		{
+			const InstanceData& instance = instances[first + i];
+			const D3DXMATRIX world(instance.world);
+
+			ColoredVertex* dest = &instance_vertices_[i * num_vertices];
+			for (int j = 0; j < num_vertices; ++j)
+			{
+				if ((instance.face_mask & (1 << (j / 4))) == 0)
+					continue;
+
+				D3DXVECTOR3 position(vertices[j].x, vertices[j].y, vertices[j].z);
+				D3DXVECTOR3 normal(vertices[j].nx, vertices[j].ny, vertices[j].nz);
+				D3DXVec3TransformCoord(&position, &position, &world);
+				D3DXVec3TransformNormal(&normal, &normal, &world);
+				D3DXVec3Normalize(&normal, &normal);
+
+				dest[j].x = position.x;
+				dest[j].y = position.y;
+				dest[j].z = position.z;
+				dest[j].nx = normal.x;
+				dest[j].ny = normal.y;
+				dest[j].nz = normal.z;
+				const float* uv_rect = instance.uv_rects[(j / 4) % kMaxInstanceColors];
+				dest[j].diffuse = instance.colors[(j / 4) % kMaxInstanceColors];
+				dest[j].u = uv_rect[0] + vertices[j].u * uv_rect[2];
+				dest[j].v = uv_rect[1] + vertices[j].v * uv_rect[3];
+			}
+
+			WORD base = (WORD)(i * num_vertices);
+			for (int j = 0; j < num_indices; j += 3)
+			{
+				if ((instance.face_mask & (1 << (indices[j] / 4))) == 0)
+					continue;
+
+				instance_indices_[num_batch_indices++] = indices[j] + base;
+				instance_indices_[num_batch_indices++] = indices[j + 1] + base;
+				instance_indices_[num_batch_indices++] = indices[j + 2] + base;
+			}
+		}
+
+		if (num_batch_indices == 0)
+			continue;
+
+		d3ddevice_->DrawIndexedPrimitiveUP(D3DPT_TRIANGLELIST,
+			0,
+			count * num_vertices,
+			num_batch_indices / 3,
+			&instance_indices_[0],
+			D3DFMT_INDEX16,
+			&instance_vertices_[0],
+			sizeof(ColoredVertex));
+	}
+
+	// DrawIndexedPrimitiveUP unbinds the stream source and the indices, they are bound again
+	// by the next DrawIndexedPrimitive so the states set by the caller stay valid
+	bindings_lost_ = true;
+}
+
+void D3D9RenderDevice::RestoreBindings()
+{
+	d3ddevice_->SetStreamSource(0, vertex_buffer_ == kInvalidHandle ? NULL : buffers_[vertex_buffer_].vertex_buffer, 0, stride_);
+	d3ddevice_->SetIndices(index_buffer_ == kInvalidHandle ? NULL : buffers_[index_buffer_].index_buffer);
+	d3ddevice_->SetFVF(kVertexFormatFVF[vertex_format_]);
+	d3ddevice_->SetRenderState(D3DRS_DIFFUSEMATERIALSOURCE, D3DMCS_MATERIAL);
+	d3ddevice_->SetRenderState(D3DRS_AMBIENTMATERIALSOURCE, D3DMCS_MATERIAL);
+
+	bindings_lost_ = false;
+}
+
+void D3D9RenderDevice::Clear(unsigned int color)
+{
+	d3ddevice_->Clear(0, NULL, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, color, 1.0f, 0);
+}
+
+bool D3D9RenderDevice::BeginScene()
+{
+	return SUCCEEDED(d3ddevice_->BeginScene());
+}
+
+void D3D9RenderDevice::EndScene()
+{
+	d3ddevice_->EndScene();
+}
+
+bool D3D9RenderDevice::Present()
+{
+	return SUCCEEDED(d3ddevice_->Present(NULL, NULL, NULL, NULL));
+}
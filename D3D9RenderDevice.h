@@ -0,0 +1,77 @@
+#ifndef __D3D9_RENDER_DEVICE_H__
+#define __D3D9_RENDER_DEVICE_H__
+
+#include <d3dx9.h>
+#include <vector>
+
+#include "RenderDevice.h"
+
+// Direct3D 9 implementation of the render device, handles are indices into the resource tables.
+class D3D9RenderDevice : public RenderDevice
+{
+public:
+	D3D9RenderDevice(LPDIRECT3DDEVICE9 d3d_device);
+	~D3D9RenderDevice(void);
+
+	BufferHandle CreateVertexBuffer(const void* vertices, int size, VertexFormat format);
+	BufferHandle CreateIndexBuffer(const unsigned short* indices, int num_indices);
+	void UpdateBuffer(BufferHandle buffer, const void* data, int offset, int size);
+	void ReleaseBuffer(BufferHandle buffer);
+
+	TextureHandle CreateTexture(int width, int height, const unsigned int* pixels);
+	void UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels);
+	void ReleaseTexture(TextureHandle texture);
+
+	void SetTransform(TransformType type, const float* matrix);
+	void SetTexture(TextureHandle texture);
+	void SetStreamSource(BufferHandle vertex_buffer, int stride);
+	void SetIndices(BufferHandle index_buffer);
+	void SetVertexFormat(VertexFormat format);
+	void SetLight(int index, const Light& light);
+	void SetMaterial(const Material& material);
+
+	void DrawIndexedPrimitive(PrimitiveType type, int num_vertices, int start_index, int primitive_count);
+	void DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances);
+
+	void Clear(unsigned int color);
+	bool BeginScene();
+	void EndScene();
+	bool Present();
+
+private:
+	BufferHandle AddBuffer(LPDIRECT3DVERTEXBUFFER9 vertex_buffer, LPDIRECT3DINDEXBUFFER9 index_buffer, int size);
+	void RestoreBindings();
+
+private:
+	struct Buffer
+	{
+		LPDIRECT3DVERTEXBUFFER9 vertex_buffer;	// Only one of the two buffers is used
+		LPDIRECT3DINDEXBUFFER9  index_buffer;
+		int size;								// Buffer size in bytes
+		std::vector<BYTE> data;					// System memory copy, the instanced draw reads the mesh from it
+	};
+
+	// Vertex expanded by the instanced draw, the instance color is stored in diffuse
+	struct ColoredVertex
+	{
+		float x, y, z;
+		float nx, ny, nz;
+		D3DCOLOR diffuse;
+		float u, v;
+	};
+
+	LPDIRECT3DDEVICE9				d3ddevice_;		// D3D9 Device, not owned
+	std::vector<Buffer>				buffers_;		// Indexed by BufferHandle
+	std::vector<LPDIRECT3DTEXTURE9>	textures_;		// Indexed by TextureHandle
+
+	BufferHandle	vertex_buffer_;		// Current stream source
+	BufferHandle	index_buffer_;		// Current indices
+	int				stride_;			// Stride of the current stream source
+	VertexFormat	vertex_format_;		// Current vertex format
+	bool			bindings_lost_;		// The instanced draw changed the D3D stream source, indices and FVF
+
+	std::vector<ColoredVertex>	instance_vertices_;	// Scratch buffers of the instanced draw
+	std::vector<WORD>			instance_indices_;
+};
+
+#endif // end __D3D9_RENDER_DEVICE_H__
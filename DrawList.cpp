@@ -0,0 +1,99 @@
+#include "DrawList.h"
+
+#include <algorithm>
+
+static bool CompareDrawItems(const DrawItem& a, const DrawItem& b)
+{
+	if (a.texture != b.texture)
+		return a.texture < b.texture;
+	if (a.vertex_buffer != b.vertex_buffer)
+		return a.vertex_buffer < b.vertex_buffer;
+	if (a.index_buffer != b.index_buffer)
+		return a.index_buffer < b.index_buffer;
+
+	return a.vertex_format < b.vertex_format;
+}
+
+DrawList::DrawList(void)
+{
+}
+
+DrawList::~DrawList(void)
+{
+}
+
+void DrawList::Add(const DrawItem& item)
+{
+	items_.push_back(item);
+	items_.back().first_instance = 0;
+	items_.back().num_instances  = 0;
+	items_.back().instances      = NULL;
+}
+
+InstanceData* DrawList::AddInstanced(const DrawItem& item, int num_instances)
+{
+	if (num_instances <= 0)
+		return NULL;
+
+	items_.push_back(item);
+	items_.back().type           = kTriangleList;
+	items_.back().first_instance = (int)instances_.size();
+	items_.back().num_instances  = num_instances;
+	items_.back().instances      = NULL;
+
+	instances_.resize(instances_.size() + num_instances);
+	return &instances_[items_.back().first_instance];
+}
+
+void DrawList::AddInstanced(const DrawItem& item, const InstanceData* instances, int num_instances)
+{
+	if (num_instances <= 0)
+		return;
+
+	items_.push_back(item);
+	items_.back().type           = kTriangleList;
+	items_.back().first_instance = 0;
+	items_.back().num_instances  = num_instances;
+	items_.back().instances      = instances;
+}
+
+void DrawList::Sort()
+{
+	std::stable_sort(items_.begin(), items_.end(), CompareDrawItems);
+}
+
+void DrawList::Submit(RenderDevice* render_device) const
+{
+	for (size_t i = 0; i < items_.size(); ++i)
+	{
+		const DrawItem& item = items_[i];
+
+		render_device->SetTexture(item.texture);
+		render_device->SetStreamSource(item.vertex_buffer, item.stride);
+		render_device->SetIndices(item.index_buffer);
+		render_device->SetVertexFormat(item.vertex_format);
+		render_device->SetTransform(kWorldTransform, item.world);
+
+		if (item.num_instances > 0)
+		{
+			const InstanceData* instances = item.instances != NULL ? item.instances : &instances_[item.first_instance];
+			render_device->DrawIndexedInstanced(item.num_vertices, item.start_index, item.primitive_count,
+				instances, item.num_instances);
+		}
+		else
+		{
+			render_device->DrawIndexedPrimitive(item.type, item.num_vertices, item.start_index, item.primitive_count);
+		}
+	}
+}
+
+void DrawList::Clear()
+{
+	items_.clear();
+	instances_.clear();
+}
+
+int DrawList::GetNumDraws() const
+{
+	return (int)items_.size();
+}
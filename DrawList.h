@@ -0,0 +1,61 @@
+#ifndef __DRAW_LIST_H__
+#define __DRAW_LIST_H__
+
+#include <vector>
+
+#include "RenderDevice.h"
+
+// One recorded draw and the states it needs
+struct DrawItem
+{
+	TextureHandle	texture;
+	BufferHandle	vertex_buffer;
+	int				stride;
+	BufferHandle	index_buffer;
+	VertexFormat	vertex_format;
+	float			world[16];			// World transform
+
+	PrimitiveType	type;				// Only kTriangleList for instanced draws
+	int				num_vertices;
+	int				start_index;
+	int				primitive_count;
+
+	int				first_instance;		// Instances in the draw list, num_instances = 0 for a non-instanced draw
+	int				num_instances;
+	const InstanceData* instances;		// Instances kept by the caller, NULL if they are in the draw list
+};
+
+// Draws are recorded into the list during the frame, then sorted by their states and submitted
+// together, so draws sharing a texture or a mesh are sent one after another and each state is
+// set only when it changes(the redundant calls are dropped by StateCacheRenderDevice).
+class DrawList
+{
+public:
+	DrawList(void);
+	~DrawList(void);
+
+	void Add(const DrawItem& item);
+
+	// Add an instanced draw, return the storage of its num_instances instances which the caller fills.
+	// The pointer is valid until the next Add.
+	InstanceData* AddInstanced(const DrawItem& item, int num_instances);
+
+	// Add an instanced draw of instances kept by the caller, they are not copied and must stay
+	// valid until Submit, e.g. the instances of a snapshot drawn every frame.
+	void AddInstanced(const DrawItem& item, const InstanceData* instances, int num_instances);
+
+	// Sort the draws by texture, then by mesh, draws with the same states keep their order
+	void Sort();
+
+	// Set the states of each draw and draw it
+	void Submit(RenderDevice* render_device) const;
+
+	void Clear();
+	int GetNumDraws() const;
+
+private:
+	std::vector<DrawItem> items_;
+	std::vector<InstanceData> instances_;
+};
+
+#endif // end __DRAW_LIST_H__
@@ -0,0 +1,444 @@
+#include "FaceMesher.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+RenderDevice*	FaceMesher::render_device_      = NULL;
+bool			FaceMesher::has_mesh_           = false;
+
+FaceMesher::FaceMesher(const CubeState* state, float face_length)
+	: state_(state),
+	  num_layers_(state->GetNumLayers()),
+	  face_length_(face_length),
+	  sticker_size_(face_length / state->GetNumLayers()),
+	  sticker_texture_(kInvalidHandle),
+	  num_chunks_per_side_((state->GetNumLayers() + kChunkSize - 1) / kChunkSize),
+	  texture_size_(1)
+{
+	memset(sticker_rect_, 0, sizeof(sticker_rect_));
+	memset(inner_rect_, 0, sizeof(inner_rect_));
+	memset(face_colors_, 0, sizeof(face_colors_));
+
+	for (int face = 0; face < 6; ++face)
+		face_textures_[face] = kInvalidHandle;
+
+	while (texture_size_ < num_layers_)
+		texture_size_ *= 2;
+
+	// The rows of the basis are the right, up and inward directions of the face, and the
+	// face center, so the quad mesh facing -Z in the XY plane is turned to face outward.
+	float half_length = face_length_ / 2;
+	for (int face = 0; face < 6; ++face)
+	{
+		int normal[3];
+		int right[3];
+		int up[3];
+		CubeState::GetFaceAxes(face, normal, right, up);
+
+		float* basis = face_basis_[face];
+		for (int i = 0; i < 3; ++i)
+		{
+			basis[i]      = (float)right[i];
+			basis[4 + i]  = (float)up[i];
+			basis[8 + i]  = (float)-normal[i];
+			basis[12 + i] = normal[i] * half_length;
+		}
+		basis[3]  = 0;
+		basis[7]  = 0;
+		basis[11] = 0;
+		basis[15] = 1;
+	}
+
+	for (int face = 0; face < 6; ++face)
+	{
+		for (int i = 0; i < num_chunks_per_side_; ++i)
+		{
+			for (int j = 0; j < num_chunks_per_side_; ++j)
+			{
+				Chunk chunk;
+				chunk.face = face;
+				chunk.row  = i * kChunkSize;
+				chunk.col  = j * kChunkSize;
+				chunk.rows = (std::min)(kChunkSize, num_layers_ - chunk.row);
+				chunk.cols = (std::min)(kChunkSize, num_layers_ - chunk.col);
+				for (int lod = 0; lod < kNumChunkLods; ++lod)
+					chunk.dirty[lod] = true;
+
+				chunks_.push_back(chunk);
+			}
+		}
+	}
+}
+
+FaceMesher::~FaceMesher(void)
+{
+	ReleaseTextures();
+}
+
+bool FaceMesher::InitMesh(RenderDevice* render_device)
+{
+	if (has_mesh_)
+		return true;
+
+	render_device_ = render_device;
+	has_mesh_ = GeometryPool::Acquire(render_device);
+	return has_mesh_;
+}
+
+void FaceMesher::ReleaseMesh()
+{
+	if (!has_mesh_)
+		return;
+
+	GeometryPool::Release();
+	has_mesh_ = false;
+}
+
+void FaceMesher::SetStickerTexture(TextureHandle sticker_texture, const float* sticker_rect, const float* inner_rect)
+{
+	sticker_texture_ = sticker_texture;
+	memcpy(sticker_rect_, sticker_rect, sizeof(sticker_rect_));
+	memcpy(inner_rect_, inner_rect, sizeof(inner_rect_));
+	Invalidate();
+}
+
+void FaceMesher::SetFaceColors(const unsigned int* face_colors)
+{
+	memcpy(face_colors_, face_colors, sizeof(face_colors_));
+	Invalidate();
+}
+
+/*
+A layer turn moves the stickers of the layer on the 4 faces around it, this is one row or
+one column of each face, and turns the whole face on its side if the layer is an outer layer.
+The layer is at 2 * index - (n - 1) along its axis in the doubled coordinates of CubeState.
+*/
+void FaceMesher::OnLayerRotated(int layer_id)
+{
+	int axis  = layer_id / num_layers_;
+	int index = layer_id % num_layers_;
+	int position = 2 * index - (num_layers_ - 1);
+
+	for (int face = 0; face < 6; ++face)
+	{
+		int normal[3];
+		int right[3];
+		int up[3];
+		CubeState::GetFaceAxes(face, normal, right, up);
+
+		if (normal[axis] != 0)
+		{
+			int outer_index = normal[axis] > 0 ? num_layers_ - 1 : 0;
+			if (index == outer_index)
+				MarkDirty(face, 0, 0, num_layers_, num_layers_);
+		}
+		else if (right[axis] != 0)
+		{
+			int col = (position * right[axis] + (num_layers_ - 1)) / 2;
+			MarkDirty(face, 0, col, num_layers_, 1);
+		}
+		else
+		{
+			int row = ((num_layers_ - 1) - position * up[axis]) / 2;
+			MarkDirty(face, row, 0, 1, num_layers_);
+		}
+	}
+}
+
+void FaceMesher::Invalidate()
+{
+	for (int face = 0; face < 6; ++face)
+		MarkDirty(face, 0, 0, num_layers_, num_layers_);
+}
+
+int FaceMesher::Update(Lod lod)
+{
+	if (lod == kTextureLod)
+		return UpdateTextures();
+
+	int num_rebuilt = 0;
+	for (size_t i = 0; i < chunks_.size(); ++i)
+	{
+		if (chunks_[i].dirty[lod])
+		{
+			BuildChunk(chunks_[i], lod);
+			chunks_[i].dirty[lod] = false;
+			++num_rebuilt;
+		}
+	}
+
+	return num_rebuilt;
+}
+
+void FaceMesher::Draw(DrawList* draw_list, const float* world, Lod lod)
+{
+	if (lod == kTextureLod && face_textures_[0] == kInvalidHandle && !CreateTextures())
+		return;
+
+	Update(lod);
+
+	DrawItem item;
+	item.texture = sticker_texture_;
+	GeometryPool::SetDrawItemMesh(kUnitQuadMesh, &item);
+	memcpy(item.world, world, sizeof(item.world));
+
+	// One draw for each face texture, the texels used are the top left n x n of the texture
+	if (lod == kTextureLod)
+	{
+		float texture_rect[4] = { 0, 0, (float)num_layers_ / texture_size_, (float)num_layers_ / texture_size_ };
+		for (int face = 0; face < 6; ++face)
+		{
+			item.texture = face_textures_[face];
+			InstanceData* instance = draw_list->AddInstanced(item, 1);
+			GetQuad(face, 0, 0, num_layers_, num_layers_, 0xffffffff, texture_rect, instance);
+		}
+		return;
+	}
+
+	InstanceData* instances = draw_list->AddInstanced(item, GetNumQuads(lod));
+	if (instances == NULL)
+		return;
+
+	for (size_t i = 0; i < chunks_.size(); ++i)
+	{
+		const std::vector<InstanceData>& quads = chunks_[i].quads[lod];
+		if (!quads.empty())
+		{
+			memcpy(instances, &quads[0], quads.size() * sizeof(InstanceData));
+			instances += quads.size();
+		}
+	}
+}
+
+int FaceMesher::GetNumQuads(Lod lod) const
+{
+	if (lod == kTextureLod)
+		return 6;
+
+	int num_quads = 0;
+	for (size_t i = 0; i < chunks_.size(); ++i)
+		num_quads += (int)chunks_[i].quads[lod].size();
+
+	return num_quads;
+}
+
+void FaceMesher::ReleaseTextures()
+{
+	for (int face = 0; face < 6; ++face)
+	{
+		if (face_textures_[face] != kInvalidHandle)
+		{
+			render_device_->ReleaseTexture(face_textures_[face]);
+			face_textures_[face] = kInvalidHandle;
+		}
+	}
+}
+
+// A sticker covers sticker_size / (2 * radius * tan(fov / 2)) of the viewport height at the distance
+// of the cube center, the faces facing the camera are a little closer, which is fine for choosing the lod.
+FaceMesher::Lod FaceMesher::SelectLod(float camera_radius, float fov, int viewport_height) const
+{
+	if (num_layers_ > kMaxQuadLayers)
+		return kTextureLod;
+
+	float view_height = 2 * camera_radius * tanf(fov / 2);
+	if (view_height <= 0)
+		return kStickerLod;
+
+	float sticker_pixels = sticker_size_ / view_height * viewport_height;
+	return sticker_pixels < kGreedyLodPixels ? kGreedyLod : kStickerLod;
+}
+
+/*
+Greedy meshing of a chunk: take the first sticker not merged yet in row order, grow the quad to the
+right while the stickers have the same color, then grow it down while the whole next row of the quad
+has the same color, mark the covered stickers merged and repeat. Each quad is a rectangle of one color.
+*/
+void FaceMesher::BuildChunk(Chunk& chunk, Lod lod)
+{
+	chunk.quads[lod].clear();
+
+	if (lod == kStickerLod)
+	{
+		for (int i = 0; i < chunk.rows; ++i)
+		{
+			for (int j = 0; j < chunk.cols; ++j)
+			{
+				int row = chunk.row + i;
+				int col = chunk.col + j;
+				chunk.quads[lod].push_back(InstanceData());
+				GetQuad(chunk.face, row, col, 1, 1, face_colors_[state_->GetFacelet(chunk.face, row, col)], sticker_rect_, &chunk.quads[lod].back());
+			}
+		}
+		return;
+	}
+
+	merged_.assign(chunk.rows * chunk.cols, 0);
+
+	for (int i = 0; i < chunk.rows; ++i)
+	{
+		for (int j = 0; j < chunk.cols; ++j)
+		{
+			if (merged_[i * chunk.cols + j])
+				continue;
+
+			unsigned char color = state_->GetFacelet(chunk.face, chunk.row + i, chunk.col + j);
+
+			int cols = 1;
+			while (j + cols < chunk.cols
+				&& !merged_[i * chunk.cols + j + cols]
+				&& state_->GetFacelet(chunk.face, chunk.row + i, chunk.col + j + cols) == color)
+			{
+				++cols;
+			}
+
+			int rows = 1;
+			for (; i + rows < chunk.rows; ++rows)
+			{
+				bool same_color = true;
+				for (int k = 0; k < cols && same_color; ++k)
+				{
+					same_color = !merged_[(i + rows) * chunk.cols + j + k]
+						&& state_->GetFacelet(chunk.face, chunk.row + i + rows, chunk.col + j + k) == color;
+				}
+
+				if (!same_color)
+					break;
+			}
+
+			for (int r = 0; r < rows; ++r)
+				memset(&merged_[(i + r) * chunk.cols + j], 1, cols);
+
+			chunk.quads[lod].push_back(InstanceData());
+			GetQuad(chunk.face, chunk.row + i, chunk.col + j, rows, cols, face_colors_[color], inner_rect_, &chunk.quads[lod].back());
+		}
+	}
+}
+
+// The quad covering rows x cols stickers from (row, col) of a face
+void FaceMesher::GetQuad(int face, int row, int col, int rows, int cols, unsigned int color, const float* uv_rect, InstanceData* quad) const
+{
+	const float* basis = face_basis_[face];
+	float half_length = face_length_ / 2;
+
+	// Bottom left corner and size of the quad in the face plane, row 0 is the top row
+	float x = col * sticker_size_ - half_length;
+	float y = half_length - (row + rows) * sticker_size_;
+	float width  = cols * sticker_size_;
+	float height = rows * sticker_size_;
+
+	memset(quad, 0, sizeof(InstanceData));
+
+	for (int i = 0; i < 3; ++i)
+	{
+		quad->world[i]      = basis[i] * width;
+		quad->world[4 + i]  = basis[4 + i] * height;
+		quad->world[8 + i]  = basis[8 + i];
+		quad->world[12 + i] = basis[12 + i] + x * basis[i] + y * basis[4 + i];
+	}
+	quad->world[15] = 1;
+
+	quad->colors[0] = color;
+	memcpy(quad->uv_rects[0], uv_rect, sizeof(quad->uv_rects[0]));
+	quad->face_mask = 1;
+}
+
+// Mark the chunks overlapping rows x cols stickers from (row, col) of a face dirty, and add the
+// rectangle to the strips to upload into the face texture
+void FaceMesher::MarkDirty(int face, int row, int col, int rows, int cols)
+{
+	int first_row = row / kChunkSize;
+	int last_row  = (row + rows - 1) / kChunkSize;
+	int first_col = col / kChunkSize;
+	int last_col  = (col + cols - 1) / kChunkSize;
+
+	for (int i = first_row; i <= last_row; ++i)
+	{
+		for (int j = first_col; j <= last_col; ++j)
+		{
+			Chunk& chunk = chunks_[(face * num_chunks_per_side_ + i) * num_chunks_per_side_ + j];
+			for (int lod = 0; lod < kNumChunkLods; ++lod)
+				chunk.dirty[lod] = true;
+		}
+	}
+
+	// A whole face replaces its strips, too many strips are merged into their bounding rectangle
+	std::vector<Strip>& strips = dirty_strips_[face];
+	if (!strips.empty() && strips[0].rows == num_layers_ && strips[0].cols == num_layers_)
+		return;
+
+	Strip strip = { row, col, rows, cols };
+	if (rows == num_layers_ && cols == num_layers_)
+		strips.clear();
+
+	strips.push_back(strip);
+
+	if ((int)strips.size() > kMaxDirtyStrips)
+	{
+		int min_row = num_layers_, min_col = num_layers_, max_row = 0, max_col = 0;
+		for (size_t i = 0; i < strips.size(); ++i)
+		{
+			min_row = (std::min)(min_row, strips[i].row);
+			min_col = (std::min)(min_col, strips[i].col);
+			max_row = (std::max)(max_row, strips[i].row + strips[i].rows);
+			max_col = (std::max)(max_col, strips[i].col + strips[i].cols);
+		}
+
+		Strip bounds = { min_row, min_col, max_row - min_row, max_col - min_col };
+		strips.clear();
+		strips.push_back(bounds);
+	}
+}
+
+bool FaceMesher::CreateTextures()
+{
+	std::vector<unsigned int> pixels(texture_size_ * texture_size_, 0xffffffff);
+
+	for (int face = 0; face < 6; ++face)
+	{
+		face_textures_[face] = render_device_->CreateTexture(texture_size_, texture_size_, &pixels[0]);
+		if (face_textures_[face] == kInvalidHandle)
+		{
+			ReleaseTextures();
+			return false;
+		}
+
+		MarkDirty(face, 0, 0, num_layers_, num_layers_);
+	}
+
+	return true;
+}
+
+// Upload the dirty strips of the face textures, each texel is the color of one sticker
+int FaceMesher::UpdateTextures()
+{
+	if (face_textures_[0] == kInvalidHandle)
+		return 0;
+
+	int num_strips = 0;
+	for (int face = 0; face < 6; ++face)
+	{
+		std::vector<Strip>& strips = dirty_strips_[face];
+		for (size_t i = 0; i < strips.size(); ++i)
+		{
+			const Strip& strip = strips[i];
+			texels_.resize(strip.rows * strip.cols);
+
+			unsigned int* texel = &texels_[0];
+			for (int row = strip.row; row < strip.row + strip.rows; ++row)
+			{
+				const unsigned char* facelets = state_->GetFacelets() + state_->GetFaceletIndex(face, row, strip.col);
+				for (int col = 0; col < strip.cols; ++col)
+					*texel++ = face_colors_[facelets[col]];
+			}
+
+			render_device_->UpdateTexture(face_textures_[face], strip.col, strip.row, strip.cols, strip.rows, &texels_[0]);
+			++num_strips;
+		}
+
+		strips.clear();
+	}
+
+	return num_strips;
+}
@@ -0,0 +1,128 @@
+#ifndef __FACE_MESHER_H__
+#define __FACE_MESHER_H__
+
+#include <vector>
+
+#include "CubeState.h"
+#include "DrawList.h"
+#include "GeometryPool.h"
+#include "RenderDevice.h"
+
+// Builds the sticker quads of a large cube from its CubeState, for cubes with too many unit
+// cubes to be drawn one by one. Only the 6 faces are drawn, each quad is one instance of a
+// shared unit quad mesh, so all the quads of a frame are one instanced draw.
+//
+// Each face is split into chunks of kChunkSize x kChunkSize stickers, the quads of a chunk are
+// cached and only rebuilt when one of its stickers was moved.
+//
+// For huge cubes the quads are too many even merged, then each face is one quad textured by
+// a color map with one texel per sticker(kTextureLod), a move uploads only the texels of the
+// rows or columns it moved. The face mesher benchmark checks the 6 draws and the uploaded texels
+// of 128 and 512 layer cubes on the recording device only. The window draws a 3 layer cube, so
+// the face textures have not run on D3D9, where a cube larger than the maximum texture size of
+// the device fails CreateTextures and draws nothing.
+class FaceMesher
+{
+public:
+	enum Lod
+	{
+		kStickerLod = 0,	// One bordered quad for each sticker
+		kGreedyLod  = 1,	// Runs of same colored stickers merged into larger plain quads
+		kTextureLod = 2,	// One quad for each face, textured by the sticker colors
+
+		kNumLods    = 3
+	};
+
+	// The faces are centered at the origin, face_length is the side length of a face
+	FaceMesher(const CubeState* state, float face_length);
+	~FaceMesher(void);
+
+	// The meshers draw the unit quad mesh of GeometryPool, InitMesh acquires it once and sets the
+	// render device of the face textures, return false if the mesh could not be created
+	static bool InitMesh(RenderDevice* render_device);
+	static void ReleaseMesh();
+
+	void SetStickerTexture(TextureHandle sticker_texture, const float* sticker_rect, const float* inner_rect);
+	void SetFaceColors(const unsigned int* face_colors);	// 6 ARGB colors indexed by facelet color
+
+	// Mark the stickers moved by CubeState::RotateLayer(layer_id, ...) dirty
+	void OnLayerRotated(int layer_id);
+
+	// Mark all stickers dirty, e.g. after CubeState::SetFacelets
+	void Invalidate();
+
+	// Rebuild the dirty chunks of a lod or upload the dirty strips of the face textures,
+	// return the number of chunks rebuilt or strips uploaded
+	int Update(Lod lod);
+
+	// Add the quads of a lod to the draw list, the dirty chunks are rebuilt first
+	void Draw(DrawList* draw_list, const float* world, Lod lod);
+
+	int GetNumQuads(Lod lod) const;
+
+	// Release the face textures, they are created again by the next Draw of kTextureLod
+	void ReleaseTextures();
+
+	// Choose the lod by the size of a sticker on the screen. The camera looks at the cube
+	// center from camera_radius away(Camera::GetRadius) with a vertical field of view fov.
+	// Cubes with more than kMaxQuadLayers layers always use kTextureLod.
+	Lod SelectLod(float camera_radius, float fov, int viewport_height) const;
+
+private:
+	static const int kChunkSize = 16;			// Chunk side in stickers
+	static const int kGreedyLodPixels = 6;		// Stickers smaller than this on the screen use kGreedyLod
+	static const int kMaxQuadLayers = 64;		// Larger cubes are drawn with face textures
+	static const int kMaxDirtyStrips = 8;		// More dirty strips of a face are merged into one
+	static const int kNumChunkLods = 2;			// Lods built from chunk quads
+
+	struct Strip
+	{
+		int row;
+		int col;
+		int rows;
+		int cols;
+	};
+
+	struct Chunk
+	{
+		int face;
+		int row;		// First row and column of the chunk in the face
+		int col;
+		int rows;
+		int cols;
+		bool dirty[kNumChunkLods];
+		std::vector<InstanceData> quads[kNumChunkLods];
+	};
+
+	void BuildChunk(Chunk& chunk, Lod lod);
+	void GetQuad(int face, int row, int col, int rows, int cols, unsigned int color, const float* uv_rect, InstanceData* quad) const;
+	void MarkDirty(int face, int row, int col, int rows, int cols);
+	bool CreateTextures();
+	int UpdateTextures();
+
+private:
+	const CubeState* state_;
+	int num_layers_;
+	float face_length_;
+	float sticker_size_;
+
+	TextureHandle sticker_texture_;
+	float sticker_rect_[4];
+	float inner_rect_[4];
+	unsigned int face_colors_[6];
+
+	float face_basis_[6][16];		// Maps the quad in the face plane(x right, y up) onto each face
+	std::vector<Chunk> chunks_;		// Chunks of all faces, face by face, row by row
+	int num_chunks_per_side_;
+	std::vector<unsigned char> merged_;	// Scratch buffer of the greedy mesher
+
+	TextureHandle face_textures_[6];	// Sticker colors of each face, texel (col, row)
+	int texture_size_;					// Power of 2 side of the face textures, n x n texels are used
+	std::vector<Strip> dirty_strips_[6];	// Rectangles of each face to upload into its texture
+	std::vector<unsigned int> texels_;	// Scratch buffer of UpdateTextures
+
+	static RenderDevice* render_device_;
+	static bool has_mesh_;				// The unit quad mesh of GeometryPool was acquired
+};
+
+#endif // end __FACE_MESHER_H__
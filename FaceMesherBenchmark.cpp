@@ -0,0 +1,286 @@
+#include "FaceMesherBenchmark.h"
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "FaceMesher.h"
+#include "RecordingRenderDevice.h"
+
+static const int kNumTurns       = 64;		// Random layer turns of each cube
+static const float kStickerLength = 10.0f;	// Side length of a sticker
+static const int kViewportHeight = 1000;	// Viewport height in pixels for SelectLod
+static const float kFov          = 3.141592654f / 4;
+
+static const char* kLodNames[] = { "sticker", "greedy", "texture" };
+
+static double GetTime()
+{
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000.0 / frequency.QuadPart;
+}
+
+// A recording device which also hashes the instances it draws, so two meshers can be compared,
+// and keeps a copy of its textures, so the texels uploaded by UpdateTexture can be checked
+class CheckingRenderDevice : public RecordingRenderDevice
+{
+public:
+	CheckingRenderDevice(void) : hash_(2166136261u), texels_uploaded_(0) {}
+
+	TextureHandle CreateTexture(int width, int height, const unsigned int* pixels)
+	{
+		TextureHandle texture = RecordingRenderDevice::CreateTexture(width, height, pixels);
+		if (texture >= (int)textures_.size())
+			textures_.resize(texture + 1);
+
+		textures_[texture].width = width;
+		textures_[texture].pixels.assign(pixels, pixels + width * height);
+		created_textures_.push_back(texture);
+		return texture;
+	}
+
+	void UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels)
+	{
+		Texture& copy = textures_[texture];
+		for (int row = 0; row < height; ++row)
+			memcpy(&copy.pixels[(y + row) * copy.width + x], pixels + row * width, width * sizeof(unsigned int));
+
+		texels_uploaded_ += width * height;
+		RecordingRenderDevice::UpdateTexture(texture, x, y, width, height, pixels);
+	}
+
+	void ReleaseTexture(TextureHandle texture)
+	{
+		textures_[texture].pixels.clear();
+		RecordingRenderDevice::ReleaseTexture(texture);
+	}
+
+	void DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances)
+	{
+		// FNV-1a over the instance bytes
+		const unsigned char* bytes = (const unsigned char*)instances;
+		for (size_t i = 0; i < num_instances * sizeof(InstanceData); ++i)
+			hash_ = (hash_ ^ bytes[i]) * 16777619u;
+
+		RecordingRenderDevice::DrawIndexedInstanced(num_vertices, start_index, primitive_count, instances, num_instances);
+	}
+
+	unsigned int GetHash() const { return hash_; }
+	void ResetHash() { hash_ = 2166136261u; }
+
+	const std::vector<TextureHandle>& GetCreatedTextures() const { return created_textures_; }
+	const unsigned int* GetTexels(TextureHandle texture) const { return &textures_[texture].pixels[0]; }
+	int GetTexturePitch(TextureHandle texture) const { return textures_[texture].width; }
+
+	long long GetTexelsUploaded() const { return texels_uploaded_; }
+
+private:
+	struct Texture
+	{
+		int width;
+		std::vector<unsigned int> pixels;
+	};
+
+	unsigned int hash_;
+	std::vector<Texture> textures_;					// Indexed by TextureHandle
+	std::vector<TextureHandle> created_textures_;	// In creation order
+	long long texels_uploaded_;
+};
+
+// Hash of the quads a mesher draws for a lod
+static unsigned int GetQuadsHash(FaceMesher* mesher, FaceMesher::Lod lod, CheckingRenderDevice* device)
+{
+	float world[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+
+	DrawList draw_list;
+	mesher->Draw(&draw_list, world, lod);
+
+	device->ResetHash();
+	draw_list.Submit(device);
+	return device->GetHash();
+}
+
+// The lods picked from close to far, the lod must not get finer as the camera moves away
+static void WriteLodSwitching(FILE* file, int num_layers)
+{
+	CubeState state(num_layers);
+	FaceMesher mesher(&state, num_layers * kStickerLength);
+
+	float face_length = num_layers * kStickerLength;
+	fprintf(file, "  %4d layers:", num_layers);
+
+	int last_lod = FaceMesher::kStickerLod;
+	bool monotonic = true;
+	for (float distance = 1; distance <= 64; distance *= 2)
+	{
+		FaceMesher::Lod lod = mesher.SelectLod(face_length * distance, kFov, kViewportHeight);
+		fprintf(file, " %gx %s", distance, kLodNames[lod]);
+
+		monotonic = monotonic && lod >= last_lod;
+		last_lod = lod;
+	}
+
+	fprintf(file, "%s\n", monotonic ? "" : "  NOT MONOTONIC");
+}
+
+// Turn random layers, rebuild only the dirty chunks after each turn, compare with all chunks rebuilt
+static void WriteChunkRebuilds(FILE* file, int num_layers, CheckingRenderDevice* device)
+{
+	CubeState state(num_layers);
+	FaceMesher mesher(&state, num_layers * kStickerLength);
+
+	unsigned int face_colors[6] = { 0xffffffff, 0xffffff00, 0xffff0000, 0xffffa500, 0xff00ff00, 0xff0000ff };
+	mesher.SetFaceColors(face_colors);
+
+	int num_chunks = mesher.Update(FaceMesher::kStickerLod);
+	mesher.Update(FaceMesher::kGreedyLod);
+
+	int num_rebuilt = 0;
+	double update_time = 0;
+	for (int i = 0; i < kNumTurns; ++i)
+	{
+		int layer = rand() % (3 * num_layers);
+		state.RotateLayer(layer, 1 + rand() % 3);
+		mesher.OnLayerRotated(layer);
+
+		double start = GetTime();
+		num_rebuilt += mesher.Update(FaceMesher::kStickerLod);
+		num_rebuilt += mesher.Update(FaceMesher::kGreedyLod);
+		update_time += GetTime() - start;
+	}
+
+	// A new mesher of the final state builds all its chunks
+	FaceMesher fresh(&state, num_layers * kStickerLength);
+	fresh.SetFaceColors(face_colors);
+
+	double start = GetTime();
+	fresh.Update(FaceMesher::kStickerLod);
+	fresh.Update(FaceMesher::kGreedyLod);
+	double full_time = GetTime() - start;
+
+	int num_mismatches = 0;
+	for (int lod = FaceMesher::kStickerLod; lod <= FaceMesher::kGreedyLod; ++lod)
+	{
+		if (GetQuadsHash(&mesher, (FaceMesher::Lod)lod, device) != GetQuadsHash(&fresh, (FaceMesher::Lod)lod, device))
+			++num_mismatches;
+	}
+
+	fprintf(file, "  %4d layers: %d chunks, %.1f chunks rebuilt per turn(of %d), %.3f ms per turn, %.3f ms all chunks, %d/%d greedy quads, mismatching lods %d\n",
+		num_layers, num_chunks, num_rebuilt / (double)kNumTurns, 2 * num_chunks, update_time / kNumTurns, full_time,
+		mesher.GetNumQuads(FaceMesher::kGreedyLod), mesher.GetNumQuads(FaceMesher::kStickerLod), num_mismatches);
+}
+
+// Count the texels of the face textures which are not the color of their sticker, texel (col, row) of the
+// texture of each face is sticker (row, col). The mesher creates its 6 face textures in face order.
+static int CountTexelMismatches(const CubeState& state, const unsigned int* face_colors, const CheckingRenderDevice& device)
+{
+	const std::vector<TextureHandle>& textures = device.GetCreatedTextures();
+	int first_texture = (int)textures.size() - 6;
+	int num_layers = state.GetNumLayers();
+
+	int num_mismatches = 0;
+	for (int face = 0; face < 6; ++face)
+	{
+		const unsigned int* texels = device.GetTexels(textures[first_texture + face]);
+		int pitch = device.GetTexturePitch(textures[first_texture + face]);
+		for (int row = 0; row < num_layers; ++row)
+		{
+			for (int col = 0; col < num_layers; ++col)
+			{
+				if (texels[row * pitch + col] != face_colors[state.GetFacelet(face, row, col)])
+					++num_mismatches;
+			}
+		}
+	}
+
+	return num_mismatches;
+}
+
+// Turn random layers and upload the dirty strips of the face textures after each turn, check after
+// each upload that the textures hold the stickers, count the texels uploaded and the texels changed
+static void WriteTextureUpdates(FILE* file, int num_layers, CheckingRenderDevice* device)
+{
+	CubeState state(num_layers);
+	FaceMesher mesher(&state, num_layers * kStickerLength);
+
+	unsigned int face_colors[6] = { 0xffffffff, 0xffffff00, 0xffff0000, 0xffffa500, 0xff00ff00, 0xff0000ff };
+	mesher.SetFaceColors(face_colors);
+
+	// The first draw creates the textures and uploads all faces
+	float world[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+	DrawList draw_list;
+	mesher.Draw(&draw_list, world, FaceMesher::kTextureLod);
+
+	long long texels_before = device->GetTexelsUploaded();
+	long long texels_changed = 0;
+	int num_strips = 0;
+	int num_bad_turns = 0;
+	double update_time = 0;
+
+	std::vector<unsigned char> facelets(state.GetFacelets(), state.GetFacelets() + state.GetNumFacelets());
+	for (int i = 0; i < kNumTurns; ++i)
+	{
+		int layer = rand() % (3 * num_layers);
+		state.RotateLayer(layer, 1 + rand() % 3);
+		mesher.OnLayerRotated(layer);
+
+		double start = GetTime();
+		num_strips += mesher.Update(FaceMesher::kTextureLod);
+		update_time += GetTime() - start;
+
+		for (int j = 0; j < state.GetNumFacelets(); ++j)
+		{
+			if (state.GetFacelets()[j] != facelets[j])
+				++texels_changed;
+		}
+		facelets.assign(state.GetFacelets(), state.GetFacelets() + state.GetNumFacelets());
+
+		if (CountTexelMismatches(state, face_colors, *device) != 0)
+			++num_bad_turns;
+	}
+
+	long long texels_uploaded = device->GetTexelsUploaded() - texels_before;
+	fprintf(file, "  %4d layers: %.1f strips per turn, %.0f texels uploaded per turn(of %d), %.0f changed, %.3f ms per turn, turns leaving wrong texels %d\n",
+		num_layers, num_strips / (double)kNumTurns, texels_uploaded / (double)kNumTurns, 6 * num_layers * num_layers,
+		texels_changed / (double)kNumTurns, update_time / kNumTurns, num_bad_turns);
+}
+
+bool RunFaceMesherBenchmark(const char* file_name)
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	CheckingRenderDevice device;
+	if (!FaceMesher::InitMesh(&device))
+	{
+		fprintf(file, "GeometryPool is in use by another render device\n");
+		fclose(file);
+		return false;
+	}
+
+	srand(1);
+
+	fprintf(file, "Lod by camera distance, in face lengths\n");
+	WriteLodSwitching(file, 16);
+	WriteLodSwitching(file, 64);
+	WriteLodSwitching(file, 256);
+
+	fprintf(file, "Chunk rebuilds after %d random turns\n", kNumTurns);
+	WriteChunkRebuilds(file, 16, &device);
+	WriteChunkRebuilds(file, 64, &device);
+
+	fprintf(file, "Face texture strips after %d random turns\n", kNumTurns);
+	WriteTextureUpdates(file, 128, &device);
+	WriteTextureUpdates(file, 512, &device);
+
+	FaceMesher::ReleaseMesh();
+
+	fclose(file);
+	return true;
+}
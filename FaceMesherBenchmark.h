@@ -0,0 +1,13 @@
+#ifndef __FACE_MESHER_BENCHMARK_H__
+#define __FACE_MESHER_BENCHMARK_H__
+
+// Drives FaceMesher on a recording device: lists the lod SelectLod picks as the camera moves away
+// from cubes of several sizes, turns random layers and times the chunk rebuilds after OnLayerRotated
+// against rebuilding all chunks, and checks that the rebuilt quads are the same as those of a new mesher.
+// For the face textures of huge cubes it counts the texels uploaded after each turn and checks
+// that the textures hold the colors of the stickers after each upload.
+// The meshers need GeometryPool on the recording device, so it runs before the app creates its device.
+// Return false if the file could not be written or the pool is in use.
+bool RunFaceMesherBenchmark(const char* file_name);
+
+#endif // end __FACE_MESHER_BENCHMARK_H__
@@ -0,0 +1,186 @@
+#include "FrameProfiler.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+static const char* kPhaseNames[kNumFramePhases] =
+{
+	"FrameMove",
+	"SetupMatrix",
+	"SetupLight",
+	"Draw",
+	"Present",
+};
+
+FrameProfiler::FrameProfiler(int capacity)
+	: records_(capacity),
+	  num_frames_(0),
+	  current_phase_(-1)
+{
+	memset(&current_, 0, sizeof(current_));
+	QueryPerformanceFrequency(&frequency_);
+	QueryPerformanceCounter(&start_counter_);
+}
+
+FrameProfiler::~FrameProfiler(void)
+{
+}
+
+void FrameProfiler::BeginFrame()
+{
+	memset(&current_, 0, sizeof(current_));
+	current_.frame = num_frames_.load(std::memory_order_relaxed);
+	current_.start_time = GetTime();
+	current_phase_ = -1;
+}
+
+void FrameProfiler::BeginPhase(FramePhase phase)
+{
+	float time = (float)(GetTime() - current_.start_time);
+
+	if (current_phase_ >= 0)
+		current_.phase_times[current_phase_] = time - current_.phase_starts[current_phase_];
+
+	current_phase_ = phase;
+	current_.phase_starts[phase] = time;
+}
+
+void FrameProfiler::EndFrame(int draw_calls)
+{
+	float time = (float)(GetTime() - current_.start_time);
+
+	if (current_phase_ >= 0)
+		current_.phase_times[current_phase_] = time - current_.phase_starts[current_phase_];
+	current_phase_ = -1;
+
+	current_.frame_time = time;
+	current_.draw_calls = draw_calls;
+
+	// Fill the slot, then publish it
+	int frame = current_.frame;
+	records_[frame % records_.size()] = current_;
+	num_frames_.store(frame + 1, std::memory_order_release);
+}
+
+void FrameProfiler::GetRecords(std::vector<FrameRecord>* records) const
+{
+	int capacity = (int)records_.size();
+	int num_frames = num_frames_.load(std::memory_order_acquire);
+	int first = (std::max)(0, num_frames - capacity);
+
+	records->clear();
+	for (int i = first; i < num_frames; ++i)
+		records->push_back(records_[i % capacity]);
+
+	// The writer may have overwritten the oldest slots during the copy, it is writing the
+	// record num_frames_ into the slot of record num_frames_ - capacity.
+	int valid_first = num_frames_.load(std::memory_order_acquire) + 1 - capacity;
+	if (valid_first > first)
+		records->erase(records->begin(), records->begin() + (std::min)(valid_first - first, (int)records->size()));
+}
+
+FrameStats FrameProfiler::GetStats() const
+{
+	std::vector<FrameRecord> records;
+	GetRecords(&records);
+
+	FrameStats stats;
+	memset(&stats, 0, sizeof(stats));
+	stats.num_frames = (int)records.size();
+	if (records.empty())
+		return stats;
+
+	std::vector<float> frame_times(records.size());
+	for (size_t i = 0; i < records.size(); ++i)
+		frame_times[i] = records[i].frame_time;
+	std::sort(frame_times.begin(), frame_times.end());
+
+	int last = (int)frame_times.size() - 1;
+	stats.p50_frame_time = frame_times[last / 2];
+	stats.p99_frame_time = frame_times[last * 99 / 100];
+	stats.draw_calls     = records.back().draw_calls;
+
+	double span = records.back().start_time - records.front().start_time;
+	if (span > 0)
+		stats.fps = (float)(last * 1000.0 / span);
+
+	return stats;
+}
+
+bool FrameProfiler::WriteCSV(const char* file_name) const
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "frame,start_ms,frame_ms");
+	for (int i = 0; i < kNumFramePhases; ++i)
+		fprintf(file, ",%s_ms", kPhaseNames[i]);
+	fprintf(file, ",draw_calls\n");
+
+	std::vector<FrameRecord> records;
+	GetRecords(&records);
+
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		const FrameRecord& record = records[i];
+		fprintf(file, "%d,%.3f,%.3f", record.frame, record.start_time, record.frame_time);
+		for (int j = 0; j < kNumFramePhases; ++j)
+			fprintf(file, ",%.3f", record.phase_times[j]);
+		fprintf(file, ",%d\n", record.draw_calls);
+	}
+
+	fclose(file);
+	return true;
+}
+
+// Chrome trace event format: each frame and each phase is a complete event("ph":"X") with the
+// start time and duration in microseconds, the phases nest inside their frame.
+bool FrameProfiler::WriteTrace(const char* file_name) const
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	std::vector<FrameRecord> records;
+	GetRecords(&records);
+
+	fprintf(file, "{\"traceEvents\":[\n");
+
+	const char* separator = "";
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		const FrameRecord& record = records[i];
+		double start = record.start_time * 1000.0;
+
+		fprintf(file, "%s{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f,\"args\":{\"frame\":%d,\"draw_calls\":%d}}",
+			separator, start, record.frame_time * 1000.0, record.frame, record.draw_calls);
+		separator = ",\n";
+
+		for (int j = 0; j < kNumFramePhases; ++j)
+		{
+			if (record.phase_times[j] <= 0)
+				continue;
+
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}",
+				separator, kPhaseNames[j], start + record.phase_starts[j] * 1000.0, record.phase_times[j] * 1000.0);
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return true;
+}
+
+const char* FrameProfiler::GetPhaseName(FramePhase phase)
+{
+	return kPhaseNames[phase];
+}
+
+double FrameProfiler::GetTime() const
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (counter.QuadPart - start_counter_.QuadPart) * 1000.0 / frequency_.QuadPart;
+}
@@ -0,0 +1,78 @@
+#ifndef __FRAME_PROFILER_H__
+#define __FRAME_PROFILER_H__
+
+#include <windows.h>
+#include <atomic>
+#include <vector>
+
+// The phases of RubikCube::Render, in the order they run
+enum FramePhase
+{
+	kPhaseFrameMove   = 0,
+	kPhaseSetupMatrix = 1,
+	kPhaseSetupLight  = 2,
+	kPhaseDraw        = 3,	// Clear, recording and submitting the draws
+	kPhasePresent     = 4,
+
+	kNumFramePhases   = 5
+};
+
+// Timing of one frame, times are in milliseconds, start times are counted from the profiler creation
+struct FrameRecord
+{
+	int frame;									// Frame number
+	double start_time;							// BeginFrame time
+	float frame_time;							// BeginFrame to EndFrame
+	float phase_starts[kNumFramePhases];		// Phase start, relative to start_time
+	float phase_times[kNumFramePhases];			// Phase duration, 0 if the phase did not run
+	int draw_calls;
+};
+
+// Summary of the frames in the profiler
+struct FrameStats
+{
+	int num_frames;
+	float fps;					// Frames drawn per second
+	float p50_frame_time;		// Median frame time
+	float p99_frame_time;
+	int draw_calls;				// Draw calls of the last frame
+};
+
+// Collects the phase times of each frame into a ring buffer holding the last frames.
+// The render thread is the only writer, a record is published by one atomic store after it
+// is complete, so other threads can read the frames(GetRecords, GetStats, the exports) without
+// a lock. A reader drops the records which were overwritten while it copied them.
+class FrameProfiler
+{
+public:
+	explicit FrameProfiler(int capacity = 512);
+	~FrameProfiler(void);
+
+	// Called by the render thread, BeginPhase ends the running phase
+	void BeginFrame();
+	void BeginPhase(FramePhase phase);
+	void EndFrame(int draw_calls);
+
+	// Copy the frames in the buffer, oldest first
+	void GetRecords(std::vector<FrameRecord>* records) const;
+	FrameStats GetStats() const;
+
+	// Export the frames as CSV, one row per frame, or as Chrome trace events(chrome://tracing)
+	bool WriteCSV(const char* file_name) const;
+	bool WriteTrace(const char* file_name) const;
+
+	static const char* GetPhaseName(FramePhase phase);
+
+private:
+	double GetTime() const;			// Milliseconds from the profiler creation
+
+private:
+	std::vector<FrameRecord> records_;	// Ring buffer, record i is in slot i % capacity
+	std::atomic<int> num_frames_;		// Number of records published
+	FrameRecord current_;				// The frame in progress
+	int current_phase_;					// Running phase of current_, -1 if none
+	LARGE_INTEGER frequency_;			// Performance counter ticks per second
+	LARGE_INTEGER start_counter_;
+};
+
+#endif // end __FRAME_PROFILER_H__
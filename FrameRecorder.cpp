@@ -0,0 +1,70 @@
+#include "FrameRecorder.h"
+
+#include <stdio.h>
+
+#include "RecordingRenderDevice.h"
+#include "StateCacheRenderDevice.h"
+
+static const char* kCommandNames[] =
+{
+	"SetTransform",
+	"SetTexture",
+	"SetStreamSource",
+	"SetIndices",
+	"SetVertexFormat",
+	"SetLight",
+	"SetMaterial",
+	"Draw",
+	"Clear",
+	"Present"
+};
+
+static void SubmitFrame(const DrawList& draw_list, RenderDevice* render_device)
+{
+	render_device->Clear(0x4F94CD);
+	if (render_device->BeginScene())
+	{
+		draw_list.Submit(render_device);
+		render_device->EndScene();
+	}
+	render_device->Present();
+}
+
+static void WriteStats(FILE* file, const char* name, const RenderStats& stats)
+{
+	fprintf(file, "%s\n", name);
+	fprintf(file, "  draw calls              %d\n", stats.draw_calls);
+	fprintf(file, "  primitives              %d\n", stats.primitives);
+	fprintf(file, "  state changes           %d\n", stats.state_changes);
+	fprintf(file, "  redundant state changes %d\n", stats.redundant_state_changes);
+	fprintf(file, "  bytes uploaded          %d\n", stats.bytes_uploaded);
+}
+
+bool RecordFrame(const DrawList& draw_list, const char* file_name)
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	RecordingRenderDevice direct;
+	direct.SetRecordCommands(true);
+	SubmitFrame(draw_list, &direct);
+
+	// The state cache drops the redundant Set* calls before they reach the device
+	RecordingRenderDevice cached;
+	StateCacheRenderDevice state_cache(&cached);
+	SubmitFrame(draw_list, &state_cache);
+
+	fprintf(file, "Frame of %d draws\n", draw_list.GetNumDraws());
+	WriteStats(file, "Direct", direct.GetStats());
+	WriteStats(file, "Through the state cache", cached.GetStats());
+	fprintf(file, "  states saved            %d\n", state_cache.GetFrameStats().states_saved);
+
+	fprintf(file, "Calls\n");
+	const std::vector<RenderCommand>& commands = direct.GetCommands();
+	for (size_t i = 0; i < commands.size(); ++i)
+		fprintf(file, "  %-16s %d\n", kCommandNames[commands[i].type], commands[i].value);
+
+	fclose(file);
+	return true;
+}
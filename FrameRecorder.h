@@ -0,0 +1,12 @@
+#ifndef __FRAME_RECORDER_H__
+#define __FRAME_RECORDER_H__
+
+#include "DrawList.h"
+
+// Submits the draws of one frame to a RecordingRenderDevice, once directly and once through a
+// StateCacheRenderDevice, and writes the counters of both and the recorded calls as text.
+// The handles in the draw list are only recorded, they may belong to another device.
+// Return false if the file could not be written.
+bool RecordFrame(const DrawList& draw_list, const char* file_name);
+
+#endif // end __FRAME_RECORDER_H__
@@ -0,0 +1,63 @@
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler(void)
+	: target_fps_(0),
+	  dirty_(true),
+	  last_frame_time_(0)
+{
+	QueryPerformanceFrequency(&frequency_);
+}
+
+FrameScheduler::~FrameScheduler(void)
+{
+}
+
+void FrameScheduler::SetTargetFps(int fps)
+{
+	target_fps_ = fps > 0 ? fps : 0;
+}
+
+int FrameScheduler::GetTargetFps() const
+{
+	return target_fps_;
+}
+
+void FrameScheduler::Invalidate()
+{
+	dirty_ = true;
+}
+
+bool FrameScheduler::IsDirty() const
+{
+	return dirty_;
+}
+
+DWORD FrameScheduler::GetWaitTime(double min_frame_time) const
+{
+	if (!dirty_)
+		return INFINITE;
+
+	double frame_time = target_fps_ > 0 ? 1000.0 / target_fps_ : 0;
+	if (frame_time < min_frame_time)
+		frame_time = min_frame_time;
+
+	double wait_time = last_frame_time_ + frame_time - GetTime();
+	if (wait_time <= 0)
+		return 0;
+
+	// Round up, so the frame is not drawn a little too early and then waits again for 0 ms
+	return (DWORD)wait_time + 1;
+}
+
+void FrameScheduler::OnFrameBegin()
+{
+	dirty_ = false;
+	last_frame_time_ = GetTime();
+}
+
+double FrameScheduler::GetTime() const
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000.0 / frequency_.QuadPart;
+}
@@ -0,0 +1,39 @@
+#ifndef __FRAME_SCHEDULER_H__
+#define __FRAME_SCHEDULER_H__
+
+#include <windows.h>
+
+// Decides when the next frame is drawn. A frame is only drawn after something on the screen
+// changed(Invalidate), and not earlier than one frame time of the target frame rate after
+// the previous frame, so an idle window draws nothing and waits for messages.
+class FrameScheduler
+{
+public:
+	FrameScheduler(void);
+	~FrameScheduler(void);
+
+	// Target frame rate, 0 for no limit
+	void SetTargetFps(int fps);
+	int GetTargetFps() const;
+
+	// The scene changed, a frame should be drawn
+	void Invalidate();
+	bool IsDirty() const;
+
+	// Milliseconds to wait before the next frame is due, INFINITE if there is nothing to draw.
+	// min_frame_time is a lower limit of the frame time in milliseconds added to the target frame rate.
+	DWORD GetWaitTime(double min_frame_time) const;
+
+	// Called when a frame is drawn, clear the dirty flag and start the next frame time
+	void OnFrameBegin();
+
+	double GetTime() const;			// Milliseconds from an arbitrary start
+
+private:
+	int target_fps_;
+	bool dirty_;
+	double last_frame_time_;		// Time of the last OnFrameBegin, in milliseconds
+	LARGE_INTEGER frequency_;		// Performance counter ticks per second
+};
+
+#endif // end __FRAME_SCHEDULER_H__
@@ -0,0 +1,188 @@
+#include "GeometryPool.h"
+
+#include <stddef.h>
+
+RenderDevice*	GeometryPool::render_device_ = NULL;
+int				GeometryPool::ref_count_     = 0;
+Mesh			GeometryPool::meshes_[kNumMeshes];
+int				GeometryPool::memory_usage_  = 0;
+
+bool GeometryPool::Acquire(RenderDevice* render_device)
+{
+	if (ref_count_ > 0)
+	{
+		if (render_device != render_device_)
+			return false;
+
+		++ref_count_;
+		return true;
+	}
+
+	render_device_ = render_device;
+	if (!CreateMeshes(render_device, meshes_))
+		return false;
+
+	memory_usage_ = 0;
+	for (int i = 0; i < kNumMeshes; ++i)
+		memory_usage_ += meshes_[i].num_vertices * sizeof(Vertex) + meshes_[i].primitive_count * 3 * sizeof(unsigned short);
+
+	ref_count_ = 1;
+	return true;
+}
+
+bool GeometryPool::CreateMeshes(RenderDevice* render_device, Mesh* meshes)
+{
+	for (int i = 0; i < kNumMeshes; ++i)
+	{
+		meshes[i].vertex_buffer = kInvalidHandle;
+		meshes[i].index_buffer  = kInvalidHandle;
+	}
+
+	/* Example of front face
+   1               2
+	---------------
+	|             |
+	|             |
+	|             |
+	|             |
+	|             |
+	---------------
+   0               3
+	*/
+
+	// Unit cube from (0, 0, 0) to (1, 1, 1), each cube scales and moves it by the instance world matrix.
+	Vertex cube_vertices[24] =
+	{
+		// Front face
+		{0.0f, 0.0f, 0.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f}, // 0
+		{0.0f, 1.0f, 0.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f}, // 1
+		{1.0f, 1.0f, 0.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f}, // 2
+		{1.0f, 0.0f, 0.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f}, // 3
+
+		// Back face
+		{1.0f, 0.0f, 1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f}, // 4
+		{1.0f, 1.0f, 1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f}, // 5
+		{0.0f, 1.0f, 1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f}, // 6
+		{0.0f, 0.0f, 1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f}, // 7
+
+		// Left face
+		{0.0f, 0.0f, 1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f}, // 8
+		{0.0f, 1.0f, 1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f}, // 9
+		{0.0f, 1.0f, 0.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f}, // 10
+		{0.0f, 0.0f, 0.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f}, // 11
+
+		// Right face 
+		{1.0f, 0.0f, 0.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f}, // 12
+		{1.0f, 1.0f, 0.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f}, // 13
+		{1.0f, 1.0f, 1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f}, // 14
+		{1.0f, 0.0f, 1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f}, // 15
+
+		// Top face
+		{0.0f, 1.0f, 0.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f}, // 16
+		{0.0f, 1.0f, 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f}, // 17
+		{1.0f, 1.0f, 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f}, // 18
+		{1.0f, 1.0f, 0.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f}, // 19
+
+		// Bottom face
+		{1.0f, 0.0f, 0.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f}, // 20
+		{1.0f, 0.0f, 1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f}, // 21
+		{0.0f, 0.0f, 1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f}, // 22
+		{0.0f, 0.0f, 0.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f}, // 23
+	};
+
+	// Indices for triangle list, the same winding as the triangle strip 0, 1, 3, 2 of each face
+	unsigned short cube_indices[36] =
+	{
+		 0,  1,  3,  3,  1,  2, // Front face
+		 4,  5,  7,  7,  5,  6, // Back face
+		 8,  9, 11, 11,  9, 10, // Left face
+		12, 13, 15, 15, 13, 14, // Right face
+		16, 17, 19, 19, 17, 18, // Top face
+		20, 21, 23, 23, 21, 22, // Bottom face
+	};
+
+	// Unit quad from (0, 0, 0) to (1, 1, 0) with the winding of the front face of the cube mesh,
+	// the texture is upright: u goes right and v goes down, as the columns and rows of a face.
+	Vertex quad_vertices[4] =
+	{
+		{0.0f, 0.0f, 0.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f}, // 0
+		{0.0f, 1.0f, 0.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f}, // 1
+		{1.0f, 1.0f, 0.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f}, // 2
+		{1.0f, 0.0f, 0.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f}, // 3
+	};
+
+	unsigned short quad_indices[6] = { 0, 1, 3, 3, 1, 2 };
+
+	if (!CreateMesh(render_device, cube_vertices, 24, cube_indices, 36, &meshes[kUnitCubeMesh])
+		|| !CreateMesh(render_device, quad_vertices, 4, quad_indices, 6, &meshes[kUnitQuadMesh]))
+	{
+		ReleaseMeshes(render_device, meshes);
+		return false;
+	}
+
+	return true;
+}
+
+void GeometryPool::Release()
+{
+	if (ref_count_ == 0)
+		return;
+
+	if (--ref_count_ == 0)
+	{
+		ReleaseMeshes(render_device_, meshes_);
+		memory_usage_ = 0;
+	}
+}
+
+void GeometryPool::ReleaseMeshes(RenderDevice* render_device, Mesh* meshes)
+{
+	for (int i = 0; i < kNumMeshes; ++i)
+	{
+		if (meshes[i].vertex_buffer != kInvalidHandle)
+			render_device->ReleaseBuffer(meshes[i].vertex_buffer);
+		if (meshes[i].index_buffer != kInvalidHandle)
+			render_device->ReleaseBuffer(meshes[i].index_buffer);
+
+		meshes[i].vertex_buffer = kInvalidHandle;
+		meshes[i].index_buffer  = kInvalidHandle;
+	}
+}
+
+bool GeometryPool::CreateMesh(RenderDevice* render_device, const Vertex* vertices, int num_vertices, const unsigned short* indices, int num_indices, Mesh* mesh)
+{
+	mesh->vertex_buffer   = render_device->CreateVertexBuffer(vertices, num_vertices * sizeof(Vertex), kVertexPositionNormalTexture);
+	mesh->index_buffer    = render_device->CreateIndexBuffer(indices, num_indices);
+	mesh->num_vertices    = num_vertices;
+	mesh->start_index     = 0;
+	mesh->primitive_count = num_indices / 3;
+
+	return mesh->vertex_buffer != kInvalidHandle && mesh->index_buffer != kInvalidHandle;
+}
+
+const Mesh& GeometryPool::GetMesh(MeshId id)
+{
+	return meshes_[id];
+}
+
+void GeometryPool::SetDrawItemMesh(MeshId id, DrawItem* item)
+{
+	SetDrawItemMesh(meshes_[id], item);
+}
+
+void GeometryPool::SetDrawItemMesh(const Mesh& mesh, DrawItem* item)
+{
+	item->vertex_buffer   = mesh.vertex_buffer;
+	item->stride          = sizeof(Vertex);
+	item->index_buffer    = mesh.index_buffer;
+	item->vertex_format   = kVertexPositionNormalTexture;
+	item->type            = kTriangleList;
+	item->num_vertices    = mesh.num_vertices;
+	item->start_index     = mesh.start_index;
+	item->primitive_count = mesh.primitive_count;
+}
+
+int GeometryPool::GetMemoryUsage()
+{
+	return memory_usage_;
+}
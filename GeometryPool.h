@@ -0,0 +1,61 @@
+#ifndef __GEOMETRY_POOL_H__
+#define __GEOMETRY_POOL_H__
+
+#include "DrawList.h"
+#include "RenderDevice.h"
+
+enum MeshId
+{
+	kUnitCubeMesh = 0,	// Cube from (0, 0, 0) to (1, 1, 1), 4 vertices for each face: front, back, left, right, top, bottom
+	kUnitQuadMesh = 1,	// Quad from (0, 0, 0) to (1, 1, 0) facing -Z, the texture upright
+
+	kNumMeshes    = 2
+};
+
+// Buffers and index range of a mesh in the pool, a triangle list
+struct Mesh
+{
+	BufferHandle vertex_buffer;
+	BufferHandle index_buffer;
+	int num_vertices;
+	int start_index;
+	int primitive_count;
+};
+
+// The unit meshes drawn by all the cubes and faces, each instance places one with its own world
+// matrix, so the pool holds one copy of each mesh whatever the size of the Rubik Cube is. The meshes
+// are written once when created and never locked again, a Restore only resets the instance data.
+// The users share the pool by reference count, the first Acquire creates the meshes on the render
+// device and the last Release frees them.
+class GeometryPool
+{
+public:
+	// Return false if the meshes could not be created, or the pool lives on another render device
+	static bool Acquire(RenderDevice* render_device);
+	static void Release();
+
+	static const Mesh& GetMesh(MeshId id);
+
+	// Fill the mesh and vertex states of a draw item
+	static void SetDrawItemMesh(MeshId id, DrawItem* item);
+	static void SetDrawItemMesh(const Mesh& mesh, DrawItem* item);
+
+	// Create kNumMeshes meshes, indexed by MeshId, on a render device outside the pool, e.g. an offscreen
+	// device next to the one of the pool. The caller releases them with ReleaseMeshes.
+	static bool CreateMeshes(RenderDevice* render_device, Mesh* meshes);
+	static void ReleaseMeshes(RenderDevice* render_device, Mesh* meshes);
+
+	// Bytes of vertex and index data in the pool
+	static int GetMemoryUsage();
+
+private:
+	static bool CreateMesh(RenderDevice* render_device, const Vertex* vertices, int num_vertices, const unsigned short* indices, int num_indices, Mesh* mesh);
+
+private:
+	static RenderDevice*	render_device_;
+	static int				ref_count_;
+	static Mesh				meshes_[kNumMeshes];
+	static int				memory_usage_;
+};
+
+#endif // end __GEOMETRY_POOL_H__
@@ -0,0 +1,152 @@
+#include "GridPicker.h"
+
+#include <algorithm>
+#include <math.h>
+
+// Slab test of the ray against a cubie box, axis(out) is the axis of the box face the ray enters through
+static bool RayCubieIntersection(const Ray& ray, const Vector3& min_point, const Vector3& max_point, float* t, int* axis)
+{
+	float t_near = -FLT_MAX;
+	float t_far  = FLT_MAX;
+	int near_axis = -1;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		// Parallel to the slab, the ray is inside it or misses the box
+		if (ray.direction[i] == 0)
+		{
+			if (ray.origin[i] < min_point[i] || ray.origin[i] > max_point[i])
+				return false;
+			continue;
+		}
+
+		float t1 = (min_point[i] - ray.origin[i]) / ray.direction[i];
+		float t2 = (max_point[i] - ray.origin[i]) / ray.direction[i];
+		if (t1 > t2)
+		{
+			float temp = t1;
+			t1 = t2;
+			t2 = temp;
+		}
+
+		if (t1 > t_near)
+		{
+			t_near = t1;
+			near_axis = i;
+		}
+		if (t2 < t_far)
+			t_far = t2;
+	}
+
+	// The origin inside the box is not a pick, the camera is always outside the puzzle
+	if (near_axis < 0 || t_near > t_far || t_near < 0)
+		return false;
+
+	*t = t_near;
+	*axis = near_axis;
+	return true;
+}
+
+GridPicker::GridPicker(void)
+	: num_layers_(0),
+	  cube_length_(0),
+	  pitch_(0),
+	  half_length_(0)
+{
+}
+
+GridPicker::~GridPicker(void)
+{
+}
+
+void GridPicker::Init(int num_layers, float cube_length, float gap)
+{
+	num_layers_  = num_layers;
+	cube_length_ = cube_length;
+	pitch_       = cube_length + gap;
+	half_length_ = (num_layers * pitch_ - gap) / 2;
+}
+
+/*
+Amanatides-Woo traversal: t_next is the distance along the ray to the next cell boundary on each
+axis, the ray always crosses the nearest one. Each cell holds one cubie, its box is the cell
+without the gap on the positive side, and the cells are visited in the order the ray passes them,
+so the first cubie hit is the nearest one.
+*/
+bool GridPicker::Pick(const Ray& ray, PickResult* result) const
+{
+	Vector3 grid_min(-half_length_, -half_length_, -half_length_);
+	float grid_length = num_layers_ * pitch_;
+	Vector3 grid_max = grid_min + Vector3(grid_length, grid_length, grid_length);
+
+	float t_enter;
+	if (num_layers_ <= 0 || !RayBoxIntersection(ray, grid_min, grid_max, &t_enter))
+		return false;
+
+	int cell[3];
+	int step[3];
+	float t_next[3];
+	float t_delta[3];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		float position = ray.origin[i] + ray.direction[i] * t_enter - grid_min[i];
+		cell[i] = (int)floor(position / pitch_);
+		cell[i] = (std::max)(0, (std::min)(cell[i], num_layers_ - 1));
+
+		if (ray.direction[i] > 0)
+		{
+			step[i]    = 1;
+			t_next[i]  = (grid_min[i] + (cell[i] + 1) * pitch_ - ray.origin[i]) / ray.direction[i];
+			t_delta[i] = pitch_ / ray.direction[i];
+		}
+		else if (ray.direction[i] < 0)
+		{
+			step[i]    = -1;
+			t_next[i]  = (grid_min[i] + cell[i] * pitch_ - ray.origin[i]) / ray.direction[i];
+			t_delta[i] = -pitch_ / ray.direction[i];
+		}
+		else
+		{
+			step[i]    = 0;
+			t_next[i]  = FLT_MAX;
+			t_delta[i] = FLT_MAX;
+		}
+	}
+
+	for (;;)
+	{
+		Vector3 box_min(grid_min.x + cell[0] * pitch_, grid_min.y + cell[1] * pitch_, grid_min.z + cell[2] * pitch_);
+		Vector3 box_max = box_min + Vector3(cube_length_, cube_length_, cube_length_);
+
+		float distance;
+		int face_axis;
+		if (RayCubieIntersection(ray, box_min, box_max, &distance, &face_axis))
+		{
+			// Entered through the negative side of the box if the ray goes toward positive
+			static const int kNegativeFaces[3] = { 2, 5, 0 };	// left, bottom, front
+			static const int kPositiveFaces[3] = { 3, 4, 1 };	// right, top, back
+			bool negative_side = ray.direction[face_axis] > 0;
+
+			for (int i = 0; i < 3; ++i)
+				result->cell[i] = cell[i];
+			result->face     = negative_side ? kNegativeFaces[face_axis] : kPositiveFaces[face_axis];
+			result->sticker  = negative_side ? cell[face_axis] == 0 : cell[face_axis] == num_layers_ - 1;
+			result->distance = distance;
+			result->point    = ray.origin + ray.direction * distance;
+			return true;
+		}
+
+		int axis = 0;
+		if (t_next[1] < t_next[axis])
+			axis = 1;
+		if (t_next[2] < t_next[axis])
+			axis = 2;
+
+		cell[axis] += step[axis];
+		if (cell[axis] < 0 || cell[axis] >= num_layers_)
+			return false;
+
+		t_next[axis] += t_delta[axis];
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef __GRID_PICKER_H__
+#define __GRID_PICKER_H__
+
+#include "Math.h"
+
+// What a picking ray hit
+struct PickResult
+{
+	int cell[3];			// Grid position of the cubie along X, Y and Z, 0 to num_layers - 1
+	int face;				// Face of the cubie hit, in the order of the Face enum: front(-Z), back, left, right, top, bottom
+	bool sticker;			// The face is on the surface of the puzzle, so it has a sticker
+	float distance;			// Distance along the ray direction to the hit point
+	Vector3 point;		// Hit point in model space
+};
+
+// Picks the cubies of a num_layers x num_layers x num_layers puzzle. The cubies sit on a grid of
+// cells of cube_length + gap, the ray walks the cells it passes through from the bounding box of the
+// puzzle inward(3D DDA), so a pick visits at most 3 * num_layers cells whatever the puzzle size is.
+// Only a puzzle at rest is picked, every cubie is on its cell.
+class GridPicker
+{
+public:
+	GridPicker(void);
+	~GridPicker(void);
+
+	void Init(int num_layers, float cube_length, float gap);
+
+	// The nearest cubie hit by the ray, false if the ray misses all cubies
+	bool Pick(const Ray& ray, PickResult* result) const;
+
+private:
+	int num_layers_;
+	float cube_length_;
+	float pitch_;				// Cell size, cube length + gap
+	float half_length_;			// Half of the puzzle edge length
+};
+
+#endif // end __GRID_PICKER_H__
@@ -1,6 +1,14 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "FaceMesherBenchmark.h"
+#include "MathBenchmark.h"
+#include "PickingBenchmark.h"
 #include "RubikCube.h"
+#include "SoftwareRenderBenchmark.h"
+#include "ThumbnailBenchmark.h"
 
 RubikCube rubikCube;
 
@@ -19,6 +27,18 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 // Main entry point of program
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine, int iCmdShow)
 {
+	// Run the benchmarks without a window and quit: -benchmark
+	// The face mesher needs the geometry pool before the app takes it for its render device.
+	if (strstr(szCmdLine, "-benchmark") != NULL)
+	{
+		RunPickingBenchmark("PickingBenchmark.txt");
+		RunMathBenchmark("MathBenchmark.txt");
+		RunSoftwareRenderBenchmark("SoftwareRenderBenchmark.txt");
+		RunThumbnailBenchmark("ThumbnailBenchmark.txt");
+		RunFaceMesherBenchmark("FaceMesherBenchmark.txt");
+		return 0;
+	}
+
 	WNDCLASSEX winClass ;
 
 	winClass.lpszClassName = L"MY_WINDOWS_CLASS";
@@ -49,8 +69,23 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
 		hInstance,					// program instance handle
 		NULL) ;						// creation parameters
 
+	// Optional saved puzzle to start from: -load <file>
+	char puzzle_file[MAX_PATH] = { 0 };
+	const char* load = strstr(szCmdLine, "-load");
+	if (load != NULL)
+		sscanf(load + 5, " %259s", puzzle_file);
+
 	// Initialize rubik cube
-	rubikCube.Initialize(hWnd);
+	rubikCube.Initialize(hWnd, puzzle_file[0] != 0 ? puzzle_file : NULL);
+
+	// Optional frame rate limit from the command line: -fps <frames per second>
+	const char* fps = strstr(szCmdLine, "-fps");
+	if (fps != NULL)
+		rubikCube.SetTargetFps(atoi(fps + 4));
+
+	// Optional raw mouse input for the layer drags: -rawinput
+	if (strstr(szCmdLine, "-rawinput") != NULL)
+		rubikCube.EnableRawInput();
 
 	ShowWindow(hWnd, iCmdShow) ;
 	UpdateWindow(hWnd) ;
@@ -67,9 +102,14 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
 			TranslateMessage (&msg) ;
 			DispatchMessage (&msg) ;
 		}
-		else // Render game scene if no message to process
+		else // Render game scene if no message to process and the scene changed
 		{
-			rubikCube.Render() ;
+			// Sleep until the next message arrives or the next frame is due
+			DWORD wait_time = rubikCube.GetRenderWaitTime() ;
+			if (wait_time == 0)
+				rubikCube.Render() ;
+			else
+				MsgWaitForMultipleObjects(0, NULL, FALSE, wait_time, QS_ALLINPUT) ;
 		}
 	}
 
@@ -1,47 +1,48 @@
 #ifndef __MATH_H__
 #define __MATH_H__
 
-#include <d3dx9.h>
+#include "VectorMath.h"
+#include <float.h>
 
 const float float_epsilon = 0.00001f;
 
 struct Box
 {
-	D3DXVECTOR3 min_point;
-	D3DXVECTOR3 max_point;
+	Vector3 min_point;
+	Vector3 max_point;
 
-	D3DXVECTOR3 points[8];	// All the 8 corner points of the box
+	Vector3 points[8];	// All the 8 corner points of the box
 
 	Box(){}; 
 
-	Box(D3DXVECTOR3 min_point, D3DXVECTOR3 max_point)
+	Box(Vector3 min_point, Vector3 max_point)
 	{
 		this->min_point = min_point;
 		this->max_point = max_point;
 
 		// Init the 8 points
 		// Front face
-		points[0] = D3DXVECTOR3(min_point.x, max_point.y, min_point.z);
-		points[1] = D3DXVECTOR3(max_point.x, max_point.y, min_point.z);
-		points[2] = D3DXVECTOR3(max_point.x, min_point.y, min_point.z);
+		points[0] = Vector3(min_point.x, max_point.y, min_point.z);
+		points[1] = Vector3(max_point.x, max_point.y, min_point.z);
+		points[2] = Vector3(max_point.x, min_point.y, min_point.z);
 		points[3] = min_point;
 
 		// Back face
-		points[4] = D3DXVECTOR3(min_point.x, max_point.y, max_point.z);
+		points[4] = Vector3(min_point.x, max_point.y, max_point.z);
 		points[5] = max_point;
-		points[6] = D3DXVECTOR3(max_point.x, min_point.y, max_point.z);
-		points[7] = D3DXVECTOR3(min_point.x, min_point.y, max_point.z);
+		points[6] = Vector3(max_point.x, min_point.y, max_point.z);
+		points[7] = Vector3(min_point.x, min_point.y, max_point.z);
 	}
 };
 
 // Triangle
 struct Triangle
 {
-	D3DXVECTOR3 v1 ;
-	D3DXVECTOR3 v2 ;
-	D3DXVECTOR3 v3 ;
+	Vector3 v1 ;
+	Vector3 v2 ;
+	Vector3 v3 ;
 
-	Triangle(D3DXVECTOR3 v1, D3DXVECTOR3 v2, D3DXVECTOR3 v3)
+	Triangle(const Vector3& v1, const Vector3& v2, const Vector3& v3)
 	{
 		this->v1 = v1 ;
 		this->v2 = v2 ;
@@ -52,14 +53,14 @@ struct Triangle
 // Rectangle
 struct Rect 
 {
-	D3DXVECTOR3 v1 ; // top-left 
-	D3DXVECTOR3 v2 ; // top-right
-	D3DXVECTOR3 v3 ; // left-bottom
-	D3DXVECTOR3 v4 ; // right-bottom
+	Vector3 v1 ; // top-left 
+	Vector3 v2 ; // top-right
+	Vector3 v3 ; // left-bottom
+	Vector3 v4 ; // right-bottom
 
 	Rect(){};
 
-	Rect(D3DXVECTOR3 v1, D3DXVECTOR3 v2, D3DXVECTOR3 v3, D3DXVECTOR3 v4)
+	Rect(const Vector3& v1, const Vector3& v2, const Vector3& v3, const Vector3& v4)
 	{
 		this->v1 = v1 ;
 		this->v2 = v2 ;
@@ -71,12 +72,12 @@ struct Rect
 // Picking ray
 struct Ray
 {
-	D3DXVECTOR3 origin;
-	D3DXVECTOR3 direction;
+	Vector3 origin;
+	Vector3 direction;
 
 	Ray(){}
 
-	Ray(D3DXVECTOR3 origin, D3DXVECTOR3 direction)
+	Ray(const Vector3& origin, const Vector3& direction)
 	{
 		this->origin    = origin;
 		this->direction = direction;
@@ -84,7 +85,7 @@ struct Ray
 };
 
 // Calculate the square distance of two points
-inline float SquareDistance(D3DXVECTOR3 v1, D3DXVECTOR3 v2)
+inline float SquareDistance(const Vector3& v1, const Vector3& v2)
 {
 	return (v1.x - v2.x) * (v1.x - v2.x) +
 		   (v1.y - v2.y) * (v1.y - v2.y) +
@@ -98,31 +99,31 @@ inline float SquareDistance(D3DXVECTOR3 v1, D3DXVECTOR3 v2)
 // v0, v1, v2: vertices of triangle
 // t(out): weight of the intersection for the ray
 // u(out), v(out): barycentric coordinate of intersection
-inline bool RayTriangleIntersection(Ray* ray, Triangle* triangle, D3DXVECTOR3* hit_point)
+inline bool RayTriangleIntersection(Ray* ray, Triangle* triangle, Vector3* hit_point)
 {
-	D3DXVECTOR3 orig = ray->origin;
-	D3DXVECTOR3 dir  = ray->direction;
+	Vector3 orig = ray->origin;
+	Vector3 dir  = ray->direction;
 
-	D3DXVECTOR3 v0 = triangle->v1;
-	D3DXVECTOR3 v1 = triangle->v2;
-	D3DXVECTOR3 v2 = triangle->v3;
+	Vector3 v0 = triangle->v1;
+	Vector3 v1 = triangle->v2;
+	Vector3 v2 = triangle->v3;
 
 	// E1
-	D3DXVECTOR3 E1 = v1 - v0;
+	Vector3 E1 = v1 - v0;
 
 	// E2
-	D3DXVECTOR3 E2 = v2 - v0;
+	Vector3 E2 = v2 - v0;
 
 	// P
-	D3DXVECTOR3 P;
-	D3DXVec3Cross(&P, &dir, &E2);
+	Vector3 P;
+	Vec3Cross(&P, &dir, &E2);
 
 	// determinant
 	//float det = E1.Dot(P);
-	float det = D3DXVec3Dot(&E1, &P);
+	float det = Vec3Dot(&E1, &P);
 
 	// keep det > 0, modify T accordingly
-	D3DXVECTOR3 T;
+	Vector3 T;
 	if( det >0 )
 	{
 		T = orig - v0;
@@ -138,21 +139,21 @@ inline bool RayTriangleIntersection(Ray* ray, Triangle* triangle, D3DXVECTOR3* h
 		return false;
 
 	// Calculate u and make sure u <= 1
-	float u = D3DXVec3Dot(&T, &P);
+	float u = Vec3Dot(&T, &P);
 	if( u < 0.0f || u > det )
 		return false;
 
 	// Q
-	D3DXVECTOR3 Q;
-	D3DXVec3Cross(&Q, &T, &E1);
+	Vector3 Q;
+	Vec3Cross(&Q, &T, &E1);
 
 	// Calculate v and make sure u + v <= 1
-	float v = D3DXVec3Dot(&dir, &Q);
+	float v = Vec3Dot(&dir, &Q);
 	if( v < 0.0f || u + v > det )
 		return false;
 
 	// Calculate t, scale parameters, ray intersects triangle
-	float t = D3DXVec3Dot(&E2, &Q);
+	float t = Vec3Dot(&E2, &Q);
 
 	float fInvDet = 1.0f / det;
 	t *= fInvDet;
@@ -170,7 +171,7 @@ inline bool RayTriangleIntersection(Ray* ray, Triangle* triangle, D3DXVECTOR3* h
 
 // Determine Whether a ray intersect with a rectangle
 // Divide the rectangle into two triangles and if the ray intersect with any of them
-inline bool RayRectIntersection(Ray& ray, Rect& rect, D3DXVECTOR3& hit_point)
+inline bool RayRectIntersection(Ray& ray, Rect& rect, Vector3& hit_point)
 {
 	// Divide the rectangle into two triangles
 	Triangle t1(rect.v1, rect.v2, rect.v3);
@@ -179,14 +180,43 @@ inline bool RayRectIntersection(Ray& ray, Rect& rect, D3DXVECTOR3& hit_point)
 	return RayTriangleIntersection(&ray, &t1, &hit_point) || RayTriangleIntersection(&ray, &t2, &hit_point);
 }
 
+// Determine whether a ray intersect with an axis aligned box, by the slab test
+// t(out): distance along the ray direction to the entry point, 0 if the origin is inside the box
+inline bool RayBoxIntersection(const Ray& ray, const Vector3& min_point, const Vector3& max_point, float* t)
+{
+	float t_near = 0.0f;
+	float t_far  = FLT_MAX;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		float inv_dir = 1.0f / ray.direction[i];
+		float t1 = (min_point[i] - ray.origin[i]) * inv_dir;
+		float t2 = (max_point[i] - ray.origin[i]) * inv_dir;
+		if (t1 > t2)
+		{
+			float temp = t1;
+			t1 = t2;
+			t2 = temp;
+		}
+
+		t_near = t1 > t_near ? t1 : t_near;
+		t_far  = t2 < t_far ? t2 : t_far;
+		if (t_near > t_far)
+			return false;
+	}
+
+	*t = t_near;
+	return true;
+}
+
 // Determine whether a plane was intersect with a box
 // If all the 8 points of the box exists on the same side of the plane, they are not intersect.
 // else they are intersect.
-inline bool PlaneBoxIntersection(const D3DXPLANE& plane, const Box& box)
+inline bool PlaneBoxIntersection(const Plane& plane, const Box& box)
 {
 	// Normalize the plane
-	D3DXPLANE normalized_plane;
-	D3DXPlaneNormalize(&normalized_plane, &plane);
+	Plane normalized_plane;
+	PlaneNormalize(&normalized_plane, &plane);
 
 	// Use a variable side_count to count the points
 	// If the point on the positive side, increase the side_count, else decrease the side_count
@@ -196,7 +226,7 @@ inline bool PlaneBoxIntersection(const D3DXPLANE& plane, const Box& box)
 	int side_count = 0;
 	for (int i = 0; i < 8; ++i)
 	{
-		if (D3DXPlaneDotCoord(&normalized_plane, &box.points[i]) > 0.0f)
+		if (PlaneDotCoord(&normalized_plane, &box.points[i]) > 0.0f)
 		{
 			++side_count;
 		}
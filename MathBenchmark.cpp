@@ -0,0 +1,141 @@
+#include "MathBenchmark.h"
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "VectorMath.h"
+
+static const int kNumMatrices = 4096;	// Matrix products per run
+static const int kNumVectors  = 65536;	// Transformed vectors per run
+static const int kRepeats     = 5;		// The fastest run is reported
+
+static double GetTime()
+{
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000.0 / frequency.QuadPart;
+}
+
+static float RandomFloat(float low, float high)
+{
+	return low + (high - low) * rand() / RAND_MAX;
+}
+
+// A rotation, scaling and translation, like the cube instance matrices
+static Matrix RandomMatrix()
+{
+	Vector3 axis(RandomFloat(-1, 1), RandomFloat(-1, 1), RandomFloat(-1, 1));
+
+	Matrix rotation;
+	Matrix scaling;
+	Matrix translation;
+	MatrixRotationAxis(&rotation, &axis, RandomFloat(-kPi, kPi));
+	MatrixScaling(&scaling, RandomFloat(0.5f, 2), RandomFloat(0.5f, 2), RandomFloat(0.5f, 2));
+	MatrixTranslation(&translation, RandomFloat(-10, 10), RandomFloat(-10, 10), RandomFloat(-10, 10));
+
+	Matrix result;
+	MatrixMultiplyScalar(&result, &scaling, &rotation);
+	MatrixMultiplyScalar(&result, &result, &translation);
+	return result;
+}
+
+static void WriteResult(FILE* file, const char* name, double scalar_time, double simd_time, float max_error)
+{
+	fprintf(file, "%s\n", name);
+	fprintf(file, "  scalar %9.3f ms\n", scalar_time);
+	fprintf(file, "  simd   %9.3f ms  %.1fx\n", simd_time, simd_time > 0 ? scalar_time / simd_time : 0);
+	fprintf(file, "  max error %g\n", max_error);
+}
+
+bool RunMathBenchmark(const char* file_name)
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	srand(1);
+
+#if defined(MATH_SSE)
+	fprintf(file, "SIMD path: SSE\n");
+#elif defined(MATH_NEON)
+	fprintf(file, "SIMD path: NEON\n");
+#else
+	fprintf(file, "SIMD path: none, both columns run the scalar code\n");
+#endif
+
+	// Products of a chain of matrices
+	std::vector<Matrix> matrices(kNumMatrices);
+	for (int i = 0; i < kNumMatrices; ++i)
+		matrices[i] = RandomMatrix();
+
+	std::vector<Matrix> scalar_products(kNumMatrices);
+	std::vector<Matrix> simd_products(kNumMatrices);
+	double scalar_time = 0;
+	double simd_time   = 0;
+
+	for (int repeat = 0; repeat < kRepeats; ++repeat)
+	{
+		double start = GetTime();
+		for (int i = 0; i < kNumMatrices; ++i)
+			MatrixMultiplyScalar(&scalar_products[i], &matrices[i], &matrices[(i + 1) % kNumMatrices]);
+		double time = GetTime() - start;
+		scalar_time = repeat == 0 ? time : min(scalar_time, time);
+
+		start = GetTime();
+		for (int i = 0; i < kNumMatrices; ++i)
+			MatrixMultiply(&simd_products[i], &matrices[i], &matrices[(i + 1) % kNumMatrices]);
+		time = GetTime() - start;
+		simd_time = repeat == 0 ? time : min(simd_time, time);
+	}
+
+	float max_error = 0;
+	for (int i = 0; i < kNumMatrices; ++i)
+	{
+		for (int j = 0; j < 16; ++j)
+		{
+			float error = fabsf(((const float*)scalar_products[i])[j] - ((const float*)simd_products[i])[j]);
+			max_error = max(max_error, error);
+		}
+	}
+
+	WriteResult(file, "MatrixMultiply", scalar_time, simd_time, max_error);
+
+	// Points through one matrix
+	std::vector<Vector3> points(kNumVectors);
+	for (int i = 0; i < kNumVectors; ++i)
+		points[i] = Vector3(RandomFloat(-10, 10), RandomFloat(-10, 10), RandomFloat(-10, 10));
+
+	std::vector<Vector3> scalar_points(kNumVectors);
+	std::vector<Vector3> simd_points(kNumVectors);
+	Matrix matrix = RandomMatrix();
+
+	for (int repeat = 0; repeat < kRepeats; ++repeat)
+	{
+		double start = GetTime();
+		Vec3TransformCoordArrayScalar(&scalar_points[0], &points[0], kNumVectors, &matrix);
+		double time = GetTime() - start;
+		scalar_time = repeat == 0 ? time : min(scalar_time, time);
+
+		start = GetTime();
+		Vec3TransformCoordArray(&simd_points[0], &points[0], kNumVectors, &matrix);
+		time = GetTime() - start;
+		simd_time = repeat == 0 ? time : min(simd_time, time);
+	}
+
+	max_error = 0;
+	for (int i = 0; i < kNumVectors; ++i)
+	{
+		Vector3 difference = scalar_points[i] - simd_points[i];
+		float error = Vec3Length(&difference);
+		max_error = max(max_error, error);
+	}
+
+	WriteResult(file, "Vec3TransformCoordArray", scalar_time, simd_time, max_error);
+
+	fclose(file);
+	return true;
+}
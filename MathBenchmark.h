@@ -0,0 +1,8 @@
+#ifndef __MATH_BENCHMARK_H__
+#define __MATH_BENCHMARK_H__
+
+// Times the SIMD paths of VectorMath.h against their scalar reference versions, checks that both
+// give the same results, and writes the results as text. Return false if the file could not be written.
+bool RunMathBenchmark(const char* file_name);
+
+#endif // end __MATH_BENCHMARK_H__
@@ -0,0 +1,355 @@
+#include "MathSIMD.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+#if !defined(MATH_NO_SIMD) && (defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__))
+#define MATH_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+TriangleBatch::TriangleBatch(void)
+	: count_(0)
+{
+}
+
+TriangleBatch::~TriangleBatch(void)
+{
+}
+
+void TriangleBatch::Clear()
+{
+	count_ = 0;
+	groups_.clear();
+}
+
+// A new group starts zeroed, zero edges give a zero determinant, so the padding never hits
+void TriangleBatch::Add(const Triangle& triangle)
+{
+	int lane = count_ % 4;
+	if (lane == 0)
+		groups_.resize(groups_.size() + kGroupFloats, 0.0f);
+
+	float* group = &groups_[(count_ / 4) * kGroupFloats];
+
+	Vector3 e1 = triangle.v2 - triangle.v1;
+	Vector3 e2 = triangle.v3 - triangle.v1;
+	float values[9] =
+	{
+		triangle.v1.x, triangle.v1.y, triangle.v1.z,
+		e1.x, e1.y, e1.z,
+		e2.x, e2.y, e2.z,
+	};
+
+	for (int i = 0; i < 9; ++i)
+		group[i * 4 + lane] = values[i];
+
+	++count_;
+}
+
+void TriangleBatch::AddRect(const Rect& rect)
+{
+	Add(Triangle(rect.v1, rect.v2, rect.v3));
+	Add(Triangle(rect.v1, rect.v3, rect.v4));
+}
+
+int TriangleBatch::GetCount() const
+{
+	return count_;
+}
+
+RayBatch::RayBatch(void)
+	: count_(0)
+{
+}
+
+RayBatch::~RayBatch(void)
+{
+}
+
+void RayBatch::Clear()
+{
+	count_ = 0;
+	groups_.clear();
+}
+
+// The padding rays start far outside any box and point away from it
+void RayBatch::Add(const Ray& ray)
+{
+	int lane = count_ % 4;
+	if (lane == 0)
+	{
+		groups_.resize(groups_.size() + kGroupFloats, 0.0f);
+
+		float* group = &groups_[(count_ / 4) * kGroupFloats];
+		for (int i = 0; i < 3 * 4; ++i)
+			group[i] = FLT_MAX;
+		for (int i = 3 * 4; i < 6 * 4; ++i)
+			group[i] = 1.0f;
+	}
+
+	float* group = &groups_[(count_ / 4) * kGroupFloats];
+
+	float values[6] =
+	{
+		ray.origin.x, ray.origin.y, ray.origin.z,
+		1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z,
+	};
+
+	for (int i = 0; i < 6; ++i)
+		group[i * 4 + lane] = values[i];
+
+	++count_;
+}
+
+int RayBatch::GetCount() const
+{
+	return count_;
+}
+
+#ifdef MATH_SIMD_SSE2
+
+/*
+The same Moller-Trumbore test as RayTriangleIntersection, for 4 triangles at once. Instead of
+branching, every lane computes u, v and t and the tests are combined into a mask. The nearest hit
+of each lane is kept in registers, the 4 lanes are compared once at the end.
+*/
+int RayTriangleBatchIntersection(const Ray& ray, const TriangleBatch& batch, float* t)
+{
+	const __m128 ox = _mm_set1_ps(ray.origin.x);
+	const __m128 oy = _mm_set1_ps(ray.origin.y);
+	const __m128 oz = _mm_set1_ps(ray.origin.z);
+	const __m128 dx = _mm_set1_ps(ray.direction.x);
+	const __m128 dy = _mm_set1_ps(ray.direction.y);
+	const __m128 dz = _mm_set1_ps(ray.direction.z);
+
+	const __m128 zero    = _mm_setzero_ps();
+	const __m128 one     = _mm_set1_ps(1.0f);
+	const __m128 epsilon = _mm_set1_ps(0.0001f);
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	__m128 best_t     = _mm_set1_ps(FLT_MAX);
+	__m128 best_index = _mm_set1_ps(-1.0f);
+	__m128 index      = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 four = _mm_set1_ps(4.0f);
+
+	int num_groups = (batch.count_ + 3) / 4;
+	const float* group = batch.groups_.empty() ? NULL : &batch.groups_[0];
+
+	for (int i = 0; i < num_groups; ++i, group += TriangleBatch::kGroupFloats, index = _mm_add_ps(index, four))
+	{
+		__m128 v0x = _mm_loadu_ps(group +  0);
+		__m128 v0y = _mm_loadu_ps(group +  4);
+		__m128 v0z = _mm_loadu_ps(group +  8);
+		__m128 e1x = _mm_loadu_ps(group + 12);
+		__m128 e1y = _mm_loadu_ps(group + 16);
+		__m128 e1z = _mm_loadu_ps(group + 20);
+		__m128 e2x = _mm_loadu_ps(group + 24);
+		__m128 e2y = _mm_loadu_ps(group + 28);
+		__m128 e2z = _mm_loadu_ps(group + 32);
+
+		// P = dir x E2
+		__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+		__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+		__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+		// determinant, near zero if the ray lies in plane of triangle
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+		__m128 mask = _mm_cmpge_ps(_mm_and_ps(det, abs_mask), epsilon);
+		__m128 inv_det = _mm_div_ps(one, det);
+
+		// T = orig - v0
+		__m128 tx = _mm_sub_ps(ox, v0x);
+		__m128 ty = _mm_sub_ps(oy, v0y);
+		__m128 tz = _mm_sub_ps(oz, v0z);
+
+		__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inv_det);
+
+		// Q = T x E1
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+		__m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+
+		__m128 v    = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv_det);
+		__m128 dist = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv_det);
+
+		// u >= 0, v >= 0, u + v <= 1, in front of the ray and nearer than the hits so far
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+		mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+		mask = _mm_and_ps(mask, _mm_cmpge_ps(dist, zero));
+		mask = _mm_and_ps(mask, _mm_cmplt_ps(dist, best_t));
+
+		best_t     = _mm_or_ps(_mm_and_ps(mask, dist),  _mm_andnot_ps(mask, best_t));
+		best_index = _mm_or_ps(_mm_and_ps(mask, index), _mm_andnot_ps(mask, best_index));
+	}
+
+	float lane_t[4];
+	float lane_index[4];
+	_mm_storeu_ps(lane_t, best_t);
+	_mm_storeu_ps(lane_index, best_index);
+
+	int nearest = -1;
+	float nearest_t = FLT_MAX;
+	for (int i = 0; i < 4; ++i)
+	{
+		if (lane_index[i] >= 0 && lane_t[i] < nearest_t)
+		{
+			nearest_t = lane_t[i];
+			nearest = (int)lane_index[i];
+		}
+	}
+
+	if (nearest >= 0)
+		*t = nearest_t;
+
+	return nearest;
+}
+
+/*
+Slab test, as RayBoxIntersection, for 4 rays at once. A direction component of 0 gives an infinite
+inverse, the slab of that axis then either contains the whole ray or none of it.
+*/
+int RayBatchBoxIntersection(const RayBatch& batch, const Vector3& min_point, const Vector3& max_point, float* t)
+{
+	const __m128 min_x = _mm_set1_ps(min_point.x);
+	const __m128 min_y = _mm_set1_ps(min_point.y);
+	const __m128 min_z = _mm_set1_ps(min_point.z);
+	const __m128 max_x = _mm_set1_ps(max_point.x);
+	const __m128 max_y = _mm_set1_ps(max_point.y);
+	const __m128 max_z = _mm_set1_ps(max_point.z);
+	const __m128 zero  = _mm_setzero_ps();
+	const __m128 miss  = _mm_set1_ps(-1.0f);
+
+	int num_hits = 0;
+	int num_groups = (batch.count_ + 3) / 4;
+	const float* group = batch.groups_.empty() ? NULL : &batch.groups_[0];
+
+	for (int i = 0; i < num_groups; ++i, group += RayBatch::kGroupFloats)
+	{
+		__m128 ox  = _mm_loadu_ps(group +  0);
+		__m128 oy  = _mm_loadu_ps(group +  4);
+		__m128 oz  = _mm_loadu_ps(group +  8);
+		__m128 idx = _mm_loadu_ps(group + 12);
+		__m128 idy = _mm_loadu_ps(group + 16);
+		__m128 idz = _mm_loadu_ps(group + 20);
+
+		__m128 t1 = _mm_mul_ps(_mm_sub_ps(min_x, ox), idx);
+		__m128 t2 = _mm_mul_ps(_mm_sub_ps(max_x, ox), idx);
+		__m128 t_near = _mm_min_ps(t1, t2);
+		__m128 t_far  = _mm_max_ps(t1, t2);
+
+		t1 = _mm_mul_ps(_mm_sub_ps(min_y, oy), idy);
+		t2 = _mm_mul_ps(_mm_sub_ps(max_y, oy), idy);
+		t_near = _mm_max_ps(t_near, _mm_min_ps(t1, t2));
+		t_far  = _mm_min_ps(t_far,  _mm_max_ps(t1, t2));
+
+		t1 = _mm_mul_ps(_mm_sub_ps(min_z, oz), idz);
+		t2 = _mm_mul_ps(_mm_sub_ps(max_z, oz), idz);
+		t_near = _mm_max_ps(t_near, _mm_min_ps(t1, t2));
+		t_far  = _mm_min_ps(t_far,  _mm_max_ps(t1, t2));
+
+		// The box is hit if the slabs overlap in front of the origin
+		t_near = _mm_max_ps(t_near, zero);
+		__m128 mask = _mm_cmple_ps(t_near, t_far);
+		__m128 result = _mm_or_ps(_mm_and_ps(mask, t_near), _mm_andnot_ps(mask, miss));
+
+		float lanes[4];
+		_mm_storeu_ps(lanes, result);
+
+		int num_lanes = (std::min)(4, batch.count_ - i * 4);
+		for (int j = 0; j < num_lanes; ++j)
+		{
+			t[i * 4 + j] = lanes[j];
+			if (lanes[j] >= 0)
+				++num_hits;
+		}
+	}
+
+	return num_hits;
+}
+
+#else
+
+// The lanes one after another, without SSE the batches are tested as the scalar versions do
+int RayTriangleBatchIntersection(const Ray& ray, const TriangleBatch& batch, float* t)
+{
+	int nearest = -1;
+	float nearest_t = FLT_MAX;
+
+	int num_groups = (batch.count_ + 3) / 4;
+	const float* group = batch.groups_.empty() ? NULL : &batch.groups_[0];
+
+	for (int i = 0; i < num_groups; ++i, group += TriangleBatch::kGroupFloats)
+	{
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			Vector3 v0(group[lane], group[4 + lane], group[8 + lane]);
+			Vector3 e1(group[12 + lane], group[16 + lane], group[20 + lane]);
+			Vector3 e2(group[24 + lane], group[28 + lane], group[32 + lane]);
+
+			// P = dir x E2, the determinant is near zero if the ray lies in plane of triangle
+			Vector3 p;
+			Vec3Cross(&p, &ray.direction, &e2);
+			float det = Vec3Dot(&e1, &p);
+			if (fabsf(det) < 0.0001f)
+				continue;
+			float inv_det = 1.0f / det;
+
+			Vector3 tvec = ray.origin - v0;
+			float u = Vec3Dot(&tvec, &p) * inv_det;
+
+			Vector3 q;
+			Vec3Cross(&q, &tvec, &e1);
+			float v = Vec3Dot(&ray.direction, &q) * inv_det;
+			float dist = Vec3Dot(&e2, &q) * inv_det;
+
+			if (u >= 0 && v >= 0 && u + v <= 1 && dist >= 0 && dist < nearest_t)
+			{
+				nearest_t = dist;
+				nearest = i * 4 + lane;
+			}
+		}
+	}
+
+	if (nearest >= 0)
+		*t = nearest_t;
+
+	return nearest;
+}
+
+int RayBatchBoxIntersection(const RayBatch& batch, const Vector3& min_point, const Vector3& max_point, float* t)
+{
+	int num_hits = 0;
+	int num_groups = (batch.count_ + 3) / 4;
+	const float* group = batch.groups_.empty() ? NULL : &batch.groups_[0];
+
+	for (int i = 0; i < num_groups; ++i, group += RayBatch::kGroupFloats)
+	{
+		int num_lanes = (std::min)(4, batch.count_ - i * 4);
+		for (int j = 0; j < num_lanes; ++j)
+		{
+			float t_near = 0;
+			float t_far  = FLT_MAX;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float origin = group[axis * 4 + j];
+				float inverse_direction = group[12 + axis * 4 + j];
+				float t1 = (min_point[axis] - origin) * inverse_direction;
+				float t2 = (max_point[axis] - origin) * inverse_direction;
+				t_near = (std::max)(t_near, (std::min)(t1, t2));
+				t_far  = (std::min)(t_far,  (std::max)(t1, t2));
+			}
+
+			// The box is hit if the slabs overlap in front of the origin
+			t[i * 4 + j] = t_near <= t_far ? t_near : -1.0f;
+			if (t_near <= t_far)
+				++num_hits;
+		}
+	}
+
+	return num_hits;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef __MATH_SIMD_H__
+#define __MATH_SIMD_H__
+
+#include <vector>
+
+#include "Math.h"
+
+// SSE versions of the intersection tests in Math.h, which test 4 triangles or 4 rays at once.
+// The batches keep their data as structure of arrays in groups of 4, one group fills one SSE
+// register per coordinate, the last group is padded with entries that never hit. Where there is
+// no SSE2 the lanes are tested one after another.
+
+// Triangles for testing one ray against many triangles
+class TriangleBatch
+{
+public:
+	TriangleBatch(void);
+	~TriangleBatch(void);
+
+	void Clear();
+	void Add(const Triangle& triangle);
+	void AddRect(const Rect& rect);		// The two triangles of RayRectIntersection, index 2i and 2i + 1
+	int GetCount() const;
+
+private:
+	friend int RayTriangleBatchIntersection(const Ray& ray, const TriangleBatch& batch, float* t);
+
+	// Per group: v0.x[4], v0.y[4], v0.z[4], e1.x[4] ... e2.z[4], e1 = v1 - v0, e2 = v2 - v0
+	static const int kGroupFloats = 36;
+
+	int count_;
+	std::vector<float> groups_;
+};
+
+// Rays for testing many rays against one box
+class RayBatch
+{
+public:
+	RayBatch(void);
+	~RayBatch(void);
+
+	void Clear();
+	void Add(const Ray& ray);
+	int GetCount() const;
+
+private:
+	friend int RayBatchBoxIntersection(const RayBatch& batch, const Vector3& min_point, const Vector3& max_point, float* t);
+
+	// Per group: origin.x[4], origin.y[4], origin.z[4], 1 / direction.x[4] ... 1 / direction.z[4]
+	static const int kGroupFloats = 24;
+
+	int count_;
+	std::vector<float> groups_;
+};
+
+// The nearest triangle hit by the ray in front of its origin, -1 if none is hit.
+// t(out) is the distance along the ray direction to the hit point.
+int RayTriangleBatchIntersection(const Ray& ray, const TriangleBatch& batch, float* t);
+
+// Test each ray of the batch against the axis aligned box, return the number of rays hitting it.
+// t(out) has GetCount() entries, the distance to the entry point, 0 if the origin is inside, -1 for a miss.
+int RayBatchBoxIntersection(const RayBatch& batch, const Vector3& min_point, const Vector3& max_point, float* t);
+
+#endif // end __MATH_SIMD_H__
@@ -0,0 +1,89 @@
+#include "MouseInput.h"
+
+MouseInput::MouseInput(void)
+	: raw_input_(false),
+	  dragging_(false),
+	  move_pending_(false),
+	  x_(0),
+	  y_(0)
+{
+}
+
+MouseInput::~MouseInput(void)
+{
+}
+
+bool MouseInput::EnableRawInput(HWND hWnd)
+{
+	RAWINPUTDEVICE device;
+	device.usUsagePage = 0x01;	// Generic desktop controls
+	device.usUsage     = 0x02;	// Mouse
+	device.dwFlags     = 0;
+	device.hwndTarget  = hWnd;
+
+	raw_input_ = RegisterRawInputDevices(&device, 1, sizeof(device)) == TRUE;
+	return raw_input_;
+}
+
+bool MouseInput::IsRawInputEnabled() const
+{
+	return raw_input_;
+}
+
+// The moves before the button went down are dropped, they belong to no drag
+void MouseInput::OnButtonDown(int x, int y)
+{
+	dragging_ = true;
+	move_pending_ = false;
+	x_ = x;
+	y_ = y;
+}
+
+void MouseInput::OnButtonUp()
+{
+	dragging_ = false;
+}
+
+void MouseInput::OnMouseMove(int x, int y)
+{
+	// The raw deltas move the position during a drag
+	if (raw_input_ && dragging_)
+		return;
+
+	x_ = x;
+	y_ = y;
+	move_pending_ = true;
+}
+
+void MouseInput::OnRawInput(LPARAM lParam)
+{
+	if (!raw_input_ || !dragging_)
+		return;
+
+	RAWINPUT raw;
+	UINT size = sizeof(raw);
+	if (GetRawInputData((HRAWINPUT)lParam, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == (UINT)-1)
+		return;
+
+	// Tablets report absolute positions, WM_MOUSEMOVE has them already
+	if (raw.header.dwType != RIM_TYPEMOUSE || (raw.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE) != 0)
+		return;
+
+	if (raw.data.mouse.lLastX == 0 && raw.data.mouse.lLastY == 0)
+		return;
+
+	x_ += raw.data.mouse.lLastX;
+	y_ += raw.data.mouse.lLastY;
+	move_pending_ = true;
+}
+
+bool MouseInput::GetMove(int* x, int* y)
+{
+	if (!move_pending_)
+		return false;
+
+	*x = x_;
+	*y = y_;
+	move_pending_ = false;
+	return true;
+}
@@ -0,0 +1,36 @@
+#ifndef __MOUSE_INPUT_H__
+#define __MOUSE_INPUT_H__
+
+#include <windows.h>
+
+// Mouse moves collected between frames. The mouse messages only record the position, the frame
+// takes the latest one with GetMove, so a 1000 Hz mouse costs no more work per frame than a 125 Hz one.
+// With raw input the position during a drag is the button down point moved by the WM_INPUT deltas,
+// which are not stopped at the screen edges and not changed by the pointer acceleration.
+class MouseInput
+{
+public:
+	MouseInput(void);
+	~MouseInput(void);
+
+	// Register the window for WM_INPUT from the mouse, return false if raw input is not available
+	bool EnableRawInput(HWND hWnd);
+	bool IsRawInputEnabled() const;
+
+	void OnButtonDown(int x, int y);	// Start a drag at the client point
+	void OnButtonUp();
+	void OnMouseMove(int x, int y);		// WM_MOUSEMOVE, client coordinates
+	void OnRawInput(LPARAM lParam);		// WM_INPUT
+
+	// The latest position since the last call, false if the mouse did not move
+	bool GetMove(int* x, int* y);
+
+private:
+	bool raw_input_;		// Raw input was registered
+	bool dragging_;			// A button is down, raw input moves the position
+	bool move_pending_;		// The position changed since the last GetMove
+	int x_;					// Latest position in client coordinates
+	int y_;
+};
+
+#endif // end __MOUSE_INPUT_H__
@@ -0,0 +1,151 @@
+#include "MoveHistory.h"
+
+#include <algorithm>
+
+// A checkpoint takes 4 bytes per cube, one every num_cubes / 16 turns costs 64 bytes per turn at most
+static const int kMinCheckpointInterval = 256;
+static const int kCubesPerCheckpointTurn = 16;
+
+MoveHistory::MoveHistory(int num_layers)
+	: num_cubes_(num_layers * num_layers * num_layers),
+	  checkpoint_interval_(0),
+	  position_(0),
+	  placement_(num_layers)
+{
+	checkpoint_interval_ = (std::max)(kMinCheckpointInterval, num_cubes_ / kCubesPerCheckpointTurn);
+	Clear();
+}
+
+MoveHistory::~MoveHistory(void)
+{
+}
+
+void MoveHistory::Clear()
+{
+	placement_.Reset();
+	DropTurns();
+}
+
+void MoveHistory::Clear(const CubePlacement& start)
+{
+	placement_ = start;
+	DropTurns();
+}
+
+void MoveHistory::DropTurns()
+{
+	moves_.clear();
+	position_ = 0;
+
+	checkpoints_.resize(num_cubes_);
+	placement_.Pack(&checkpoints_[0]);
+}
+
+void MoveHistory::Record(int layer_id, int quarter_turns)
+{
+	quarter_turns = ((quarter_turns % 4) + 4) % 4;
+	if (layer_id < 0 || quarter_turns == 0)
+		return;
+
+	// Keep the checkpoints up to the current position
+	if (position_ < GetLength())
+	{
+		moves_.resize(position_);
+		checkpoints_.resize((position_ / checkpoint_interval_ + 1) * num_cubes_);
+	}
+
+	moves_.push_back((unsigned int)(layer_id * 4 + quarter_turns));
+	placement_.RotateLayer(layer_id, quarter_turns);
+	++position_;
+
+	if (position_ % checkpoint_interval_ == 0)
+	{
+		checkpoints_.resize(checkpoints_.size() + num_cubes_);
+		placement_.Pack(&checkpoints_[checkpoints_.size() - num_cubes_]);
+	}
+}
+
+bool MoveHistory::Undo(int* layer_id, int* quarter_turns)
+{
+	if (position_ == 0)
+		return false;
+
+	--position_;
+	*layer_id = moves_[position_] / 4;
+	*quarter_turns = 4 - moves_[position_] % 4;
+	placement_.RotateLayer(*layer_id, *quarter_turns);
+
+	return true;
+}
+
+bool MoveHistory::Redo(int* layer_id, int* quarter_turns)
+{
+	if (position_ == GetLength())
+		return false;
+
+	*layer_id = moves_[position_] / 4;
+	*quarter_turns = moves_[position_] % 4;
+	placement_.RotateLayer(*layer_id, *quarter_turns);
+	++position_;
+
+	return true;
+}
+
+// The checkpoint is found from the position directly, a jump forward within one interval replays from the current position
+void MoveHistory::Seek(int position)
+{
+	position = (std::max)(0, (std::min)(position, GetLength()));
+
+	int checkpoint = position / checkpoint_interval_;
+	int checkpoint_position = checkpoint * checkpoint_interval_;
+
+	if (position >= position_ && position_ > checkpoint_position)
+	{
+		Replay(position_, position);
+	}
+	else
+	{
+		placement_.Unpack(&checkpoints_[checkpoint * num_cubes_]);
+		Replay(checkpoint_position, position);
+	}
+
+	position_ = position;
+}
+
+void MoveHistory::Replay(int from, int to)
+{
+	for (int i = from; i < to; ++i)
+	{
+		placement_.RotateLayer(moves_[i] / 4, moves_[i] % 4);
+	}
+}
+
+int MoveHistory::GetPosition() const
+{
+	return position_;
+}
+
+int MoveHistory::GetLength() const
+{
+	return (int)moves_.size();
+}
+
+int MoveHistory::GetCheckpointInterval() const
+{
+	return checkpoint_interval_;
+}
+
+const CubePlacement& MoveHistory::GetPlacement() const
+{
+	return placement_;
+}
+
+void MoveHistory::GetStart(CubePlacement* placement) const
+{
+	placement->Unpack(&checkpoints_[0]);
+}
+
+void MoveHistory::GetTurns(std::vector<unsigned int>* turns) const
+{
+	turns->assign(moves_.begin(), moves_.begin() + position_);
+}
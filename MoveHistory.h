@@ -0,0 +1,60 @@
+#ifndef __MOVE_HISTORY_H__
+#define __MOVE_HISTORY_H__
+
+#include "CubePlacement.h"
+#include <vector>
+
+// The committed turns of a session, for undo, redo and jumping to any point of the history.
+// The position is the number of turns applied, position 0 is the solved cube or a loaded puzzle.
+// A turn is recorded in one unsigned int, layer_id * 4 + quarter_turns. Each checkpoint interval turns
+// the whole placement of the cubes is stored too, a jump loads the last checkpoint before its target
+// and replays the turns after it, at most interval - 1. The interval grows with the number of cubes,
+// so the checkpoints add a few bytes per turn at most, whatever the size of the Rubik Cube is.
+class MoveHistory
+{
+public:
+	explicit MoveHistory(int num_layers);
+	~MoveHistory(void);
+
+	// Drop all the turns, back to position 0 at the solved cube or at the start placement
+	void Clear();
+	void Clear(const CubePlacement& start);
+
+	// Add a turn of quarter_turns x 90 degrees around the positive axis of the layer at the
+	// current position, the turns which could have been redone are dropped
+	void Record(int layer_id, int quarter_turns);
+
+	// Step back one turn and get the turn which undoes it, false at position 0
+	bool Undo(int* layer_id, int* quarter_turns);
+
+	// Step forward one turn and get it, false at the end of the history
+	bool Redo(int* layer_id, int* quarter_turns);
+
+	// Jump to a position, clamped to 0 .. GetLength(), without going through the turns in between
+	void Seek(int position);
+
+	int GetPosition() const;
+	int GetLength() const;
+	int GetCheckpointInterval() const;
+
+	// Where the cubes are at the current position
+	const CubePlacement& GetPlacement() const;
+
+	// Where the cubes were at position 0 and the turns from there to the current position
+	void GetStart(CubePlacement* placement) const;
+	void GetTurns(std::vector<unsigned int>* turns) const;
+
+private:
+	void DropTurns();					// The placement is at position 0
+	void Replay(int from, int to);		// Apply the turns from .. to - 1 to the placement
+
+private:
+	int num_cubes_;
+	int checkpoint_interval_;
+	std::vector<unsigned int> moves_;
+	std::vector<unsigned int> checkpoints_;		// num_cubes_ values each, checkpoint c is at position c x interval
+	int position_;
+	CubePlacement placement_;					// The cubes at position_
+};
+
+#endif // end __MOVE_HISTORY_H__
@@ -0,0 +1,159 @@
+#include "MoveQueue.h"
+
+#include <algorithm>
+#include <float.h>
+
+MoveQueue::MoveQueue(int num_layers)
+	: num_layers_(num_layers),
+	  move_duration_(250),
+	  group_start_time_(0)
+{
+}
+
+MoveQueue::~MoveQueue(void)
+{
+}
+
+void MoveQueue::SetMoveDuration(double duration)
+{
+	move_duration_ = duration > 0 ? duration : 0;
+}
+
+double MoveQueue::GetMoveDuration() const
+{
+	return move_duration_;
+}
+
+void MoveQueue::Push(int layer, int quarter_turns)
+{
+	// 3 turns is the same as -1 turn, and the slerp takes the shorter way
+	quarter_turns = ((quarter_turns % 4) + 4) % 4;
+	if (quarter_turns == 0)
+		return;
+	if (quarter_turns == 3)
+		quarter_turns = -1;
+
+	Move move;
+	move.layer = layer;
+	move.quarter_turns = quarter_turns;
+
+	int axis = GetAxis(layer);
+	move.axis = Vector3(axis == 0 ? 1.0f : 0.0f, axis == 1 ? 1.0f : 0.0f, axis == 2 ? 1.0f : 0.0f);
+
+	QuaternionRotationAxis(&move.target, &move.axis, quarter_turns * kPi / 2);
+	QuaternionIdentity(&move.current);
+
+	pending_.push_back(move);
+}
+
+/*
+The rotation of a move at time t is slerp(identity, target, s), where s eases in and out of the
+turn, each step rotates the layer by the difference to the rotation of the last step. When the
+group ends, the next group starts at the end time of this group rather than at the current time,
+so a long frame does not slow down a sequence of moves.
+*/
+void MoveQueue::Update(double time, MoveListener* listener)
+{
+	for (;;)
+	{
+		if (active_.empty())
+		{
+			if (pending_.empty())
+				return;
+
+			StartGroup(time);
+		}
+
+		double t = move_duration_ > 0 ? (time - group_start_time_) / move_duration_ : 1;
+		if (t < 0)
+			t = 0;
+		if (t > 1)
+			t = 1;
+		float s = (float)(t * t * (3 - 2 * t));
+
+		Quaternion identity;
+		QuaternionIdentity(&identity);
+
+		for (size_t i = 0; i < active_.size(); ++i)
+		{
+			Move& move = active_[i];
+
+			Quaternion rotation;
+			QuaternionSlerp(&rotation, &identity, &move.target, s);
+
+			Quaternion inverse;
+			Quaternion step;
+			QuaternionInverse(&inverse, &move.current);
+			QuaternionMultiply(&step, &inverse, &rotation);
+			move.current = rotation;
+
+			listener->OnMoveStep(move.layer, step);
+		}
+
+		if (t < 1)
+			return;
+
+		for (size_t i = 0; i < active_.size(); ++i)
+		{
+			listener->OnMoveEnd(active_[i].layer, active_[i].axis, active_[i].quarter_turns);
+		}
+
+		double end_time = group_start_time_ + move_duration_;
+		active_.clear();
+
+		if (pending_.empty())
+			return;
+
+		StartGroup(end_time);
+	}
+}
+
+void MoveQueue::FastForward(MoveListener* listener)
+{
+	Update(DBL_MAX, listener);
+}
+
+void MoveQueue::Clear()
+{
+	pending_.clear();
+	active_.clear();
+}
+
+bool MoveQueue::IsIdle() const
+{
+	return active_.empty() && pending_.empty();
+}
+
+bool MoveQueue::GetRotatingLayers(int* first_layer, int* last_layer) const
+{
+	if (active_.empty())
+		return false;
+
+	*first_layer = active_[0].layer;
+	*last_layer  = active_[0].layer;
+	for (size_t i = 1; i < active_.size(); ++i)
+	{
+		*first_layer = (std::min)(*first_layer, active_[i].layer);
+		*last_layer  = (std::max)(*last_layer, active_[i].layer);
+	}
+
+	return true;
+}
+
+// Start the first pending move and the moves following it around the same axis
+void MoveQueue::StartGroup(double start_time)
+{
+	int axis = GetAxis(pending_.front().layer);
+	while (!pending_.empty() && GetAxis(pending_.front().layer) == axis)
+	{
+		active_.push_back(pending_.front());
+		pending_.pop_front();
+	}
+
+	group_start_time_ = start_time;
+}
+
+int MoveQueue::GetAxis(int layer) const
+{
+	return layer / num_layers_;
+}
@@ -0,0 +1,72 @@
+#ifndef __MOVE_QUEUE_H__
+#define __MOVE_QUEUE_H__
+
+#include "VectorMath.h"
+#include <deque>
+#include <vector>
+
+// Receives the rotations of the animated moves
+class MoveListener
+{
+public:
+	virtual ~MoveListener(void) {}
+
+	// Rotate the cubes of a layer further by rotation
+	virtual void OnMoveStep(int layer, const Quaternion& rotation) = 0;
+
+	// The layer finished its turn of quarter_turns x 90 degrees around the positive axis
+	virtual void OnMoveEnd(int layer, const Vector3& axis, int quarter_turns) = 0;
+};
+
+// Turns waiting to be animated. Each turn rotates its layer over the move duration by a slerp
+// from no rotation to the whole turn, driven by the time passed to Update, so the animation speed
+// does not depend on the frame rate. Consecutive turns around the same axis commute, they are
+// started together and animate concurrently, a turn around another axis waits for them to finish.
+class MoveQueue
+{
+public:
+	explicit MoveQueue(int num_layers);
+	~MoveQueue(void);
+
+	void SetMoveDuration(double duration);		// Milliseconds of one turn
+	double GetMoveDuration() const;
+
+	// Add a turn of quarter_turns x 90 degrees around the positive axis of the layer
+	void Push(int layer, int quarter_turns);
+
+	// Animate the moves to time(milliseconds), a group of moves starts when the previous group ends
+	void Update(double time, MoveListener* listener);
+
+	// Finish all the moves at once
+	void FastForward(MoveListener* listener);
+
+	// Drop all the moves, the rotations already applied stay
+	void Clear();
+
+	bool IsIdle() const;
+
+	// Range of the rotating layers, all on one axis, return false if no layer is rotating
+	bool GetRotatingLayers(int* first_layer, int* last_layer) const;
+
+private:
+	struct Move
+	{
+		int layer;
+		int quarter_turns;		// -1, 1 or 2, a slerp turns at most half a circle
+		Vector3 axis;
+		Quaternion target;	// Rotation of the whole turn
+		Quaternion current;	// Rotation applied so far
+	};
+
+	void StartGroup(double start_time);
+	int GetAxis(int layer) const;
+
+private:
+	int num_layers_;
+	double move_duration_;
+	std::deque<Move> pending_;
+	std::vector<Move> active_;		// The moves animating together
+	double group_start_time_;
+};
+
+#endif // end __MOVE_QUEUE_H__
@@ -0,0 +1,288 @@
+#include "PickingBenchmark.h"
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "GridPicker.h"
+#include "MathSIMD.h"
+
+static const int kNumLayers   = 32;		// Stickers per face edge of the benchmark cube
+static const int kNumRays     = 256;	// Rays against the stickers
+static const int kNumBoxRays  = 65536;	// Rays against one box
+static const int kRepeats     = 5;		// The fastest run is reported
+
+static double GetTime()
+{
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000.0 / frequency.QuadPart;
+}
+
+static float RandomFloat(float low, float high)
+{
+	return low + (high - low) * rand() / RAND_MAX;
+}
+
+// The sticker rects of a cube with edge length 2 centered at the origin, in the vertex order of
+// RubikCube's faces: top-left, top-right, bottom-right, bottom-left seen from outside.
+static void GetStickerRects(int num_layers, std::vector<Rect>* rects)
+{
+	float size = 2.0f / num_layers;
+	float gap  = size * 0.1f;
+
+	for (int face = 0; face < 6; ++face)
+	{
+		int axis = face / 2;
+		float side = face % 2 == 0 ? -1.0f : 1.0f;
+		int u_axis = (axis + 1) % 3;
+		int v_axis = (axis + 2) % 3;
+
+		for (int i = 0; i < num_layers; ++i)
+		{
+			for (int j = 0; j < num_layers; ++j)
+			{
+				float u0 = -1.0f + i * size + gap;
+				float u1 = u0 + size - 2 * gap;
+				float v0 = -1.0f + j * size + gap;
+				float v1 = v0 + size - 2 * gap;
+
+				Vector3 corners[4];
+				float us[4] = { u0, u1, u1, u0 };
+				float vs[4] = { v1, v1, v0, v0 };
+				for (int k = 0; k < 4; ++k)
+				{
+					corners[k][axis]   = side;
+					corners[k][u_axis] = us[k];
+					corners[k][v_axis] = vs[k];
+				}
+
+				rects->push_back(Rect(corners[0], corners[1], corners[2], corners[3]));
+			}
+		}
+	}
+}
+
+// Rays from a random eye point outside the cube toward a random point on the cube
+static void GetRays(int num_rays, std::vector<Ray>* rays)
+{
+	for (int i = 0; i < num_rays; ++i)
+	{
+		Vector3 eye(RandomFloat(-1, 1), RandomFloat(-1, 1), RandomFloat(-1, 1));
+		Vec3Normalize(&eye, &eye);
+		eye *= 6.0f;
+
+		Vector3 target(RandomFloat(-1.2f, 1.2f), RandomFloat(-1.2f, 1.2f), RandomFloat(-1.2f, 1.2f));
+		Vector3 direction = target - eye;
+		Vec3Normalize(&direction, &direction);
+
+		rays->push_back(Ray(eye, direction));
+	}
+}
+
+/*
+The grid walk of GridPicker against a slab test on every cubie of the puzzle, keeping the hit
+nearest to the ray origin. The cubies are laid out as in GridPicker, the puzzle spans -1 to 1.
+*/
+static void CompareGridPicking(const std::vector<Ray>& rays, FILE* file)
+{
+	float pitch = 2.0f / kNumLayers;
+	float gap = pitch * 0.1f;
+	float cube_length = pitch - gap;
+	float half_length = (kNumLayers * pitch - gap) / 2;
+
+	GridPicker picker;
+	picker.Init(kNumLayers, cube_length, gap);
+
+	std::vector<int> brute_hits(rays.size());
+	std::vector<int> grid_hits(rays.size());
+	std::vector<float> brute_t(rays.size());
+	std::vector<float> grid_t(rays.size());
+	double brute_time = 0;
+	double grid_time  = 0;
+
+	for (int repeat = 0; repeat < kRepeats; ++repeat)
+	{
+		double start = GetTime();
+		for (size_t i = 0; i < rays.size(); ++i)
+		{
+			brute_hits[i] = -1;
+			brute_t[i] = FLT_MAX;
+			for (int cubie = 0; cubie < kNumLayers * kNumLayers * kNumLayers; ++cubie)
+			{
+				int cell[3] = { cubie % kNumLayers, cubie / kNumLayers % kNumLayers, cubie / (kNumLayers * kNumLayers) };
+				Vector3 min_point(cell[0] * pitch - half_length, cell[1] * pitch - half_length, cell[2] * pitch - half_length);
+				Vector3 max_point = min_point + Vector3(cube_length, cube_length, cube_length);
+
+				float t;
+				if (RayBoxIntersection(rays[i], min_point, max_point, &t) && t < brute_t[i])
+				{
+					brute_t[i] = t;
+					brute_hits[i] = cubie;
+				}
+			}
+		}
+		double time = GetTime() - start;
+		brute_time = repeat == 0 ? time : min(brute_time, time);
+
+		start = GetTime();
+		for (size_t i = 0; i < rays.size(); ++i)
+		{
+			PickResult pick;
+			grid_hits[i] = -1;
+			if (picker.Pick(rays[i], &pick))
+			{
+				grid_hits[i] = pick.cell[0] + (pick.cell[1] + pick.cell[2] * kNumLayers) * kNumLayers;
+				grid_t[i] = pick.distance;
+			}
+		}
+		time = GetTime() - start;
+		grid_time = repeat == 0 ? time : min(grid_time, time);
+	}
+
+	int num_hits = 0;
+	int num_mismatches = 0;
+	for (size_t i = 0; i < rays.size(); ++i)
+	{
+		if (brute_hits[i] >= 0)
+			++num_hits;
+		if (brute_hits[i] != grid_hits[i] || (brute_hits[i] >= 0 && fabs(brute_t[i] - grid_t[i]) > 0.001f))
+			++num_mismatches;
+	}
+
+	fprintf(file, "Ray against cubies: %d rays, %d cubies, %d hits\n", (int)rays.size(), kNumLayers * kNumLayers * kNumLayers, num_hits);
+	fprintf(file, "  every cubie                  %9.3f ms\n", brute_time);
+	fprintf(file, "  GridPicker                   %9.3f ms  %.1fx\n", grid_time, grid_time > 0 ? brute_time / grid_time : 0);
+	fprintf(file, "  mismatches %d\n", num_mismatches);
+}
+
+/*
+The scalar picking is the way RubikCube::OnLeftButtonDown picks a face: RayRectIntersection on
+every rect, keeping the hit nearest to the ray origin. The batch version tests the same rects as
+2 triangles each, so the nearest triangle index / 2 is the rect.
+*/
+bool RunPickingBenchmark(const char* file_name)
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	srand(1);
+
+	std::vector<Rect> rects;
+	GetStickerRects(kNumLayers, &rects);
+
+	std::vector<Ray> rays;
+	GetRays(kNumRays, &rays);
+
+	TriangleBatch triangles;
+	for (size_t i = 0; i < rects.size(); ++i)
+		triangles.AddRect(rects[i]);
+
+	std::vector<int> scalar_hits(rays.size());
+	std::vector<int> batch_hits(rays.size());
+	double scalar_time = 0;
+	double batch_time  = 0;
+
+	for (int repeat = 0; repeat < kRepeats; ++repeat)
+	{
+		double start = GetTime();
+		for (size_t i = 0; i < rays.size(); ++i)
+		{
+			scalar_hits[i] = -1;
+			float nearest = FLT_MAX;
+			for (size_t j = 0; j < rects.size(); ++j)
+			{
+				Vector3 hit_point;
+				if (RayRectIntersection(rays[i], rects[j], hit_point))
+				{
+					float distance = SquareDistance(rays[i].origin, hit_point);
+					if (distance < nearest)
+					{
+						nearest = distance;
+						scalar_hits[i] = (int)j;
+					}
+				}
+			}
+		}
+		double time = GetTime() - start;
+		scalar_time = repeat == 0 ? time : min(scalar_time, time);
+
+		start = GetTime();
+		for (size_t i = 0; i < rays.size(); ++i)
+		{
+			float t;
+			int triangle = RayTriangleBatchIntersection(rays[i], triangles, &t);
+			batch_hits[i] = triangle >= 0 ? triangle / 2 : -1;
+		}
+		time = GetTime() - start;
+		batch_time = repeat == 0 ? time : min(batch_time, time);
+	}
+
+	int num_hits = 0;
+	int num_mismatches = 0;
+	for (size_t i = 0; i < rays.size(); ++i)
+	{
+		if (scalar_hits[i] >= 0)
+			++num_hits;
+		if (scalar_hits[i] != batch_hits[i])
+			++num_mismatches;
+	}
+
+	fprintf(file, "Ray against stickers: %d rays, %d rects, %d hits\n", (int)rays.size(), (int)rects.size(), num_hits);
+	fprintf(file, "  RayRectIntersection          %9.3f ms\n", scalar_time);
+	fprintf(file, "  RayTriangleBatchIntersection %9.3f ms  %.1fx\n", batch_time, batch_time > 0 ? scalar_time / batch_time : 0);
+	fprintf(file, "  mismatches %d\n", num_mismatches);
+
+	CompareGridPicking(rays, file);
+
+	// Many rays against the bounding box of the cube
+	Vector3 min_point(-1, -1, -1);
+	Vector3 max_point( 1,  1,  1);
+
+	rays.clear();
+	GetRays(kNumBoxRays, &rays);
+
+	RayBatch ray_batch;
+	for (size_t i = 0; i < rays.size(); ++i)
+		ray_batch.Add(rays[i]);
+
+	std::vector<float> scalar_t(rays.size());
+	std::vector<float> batch_t(rays.size());
+
+	for (int repeat = 0; repeat < kRepeats; ++repeat)
+	{
+		double start = GetTime();
+		for (size_t i = 0; i < rays.size(); ++i)
+		{
+			if (!RayBoxIntersection(rays[i], min_point, max_point, &scalar_t[i]))
+				scalar_t[i] = -1;
+		}
+		double time = GetTime() - start;
+		scalar_time = repeat == 0 ? time : min(scalar_time, time);
+
+		start = GetTime();
+		num_hits = RayBatchBoxIntersection(ray_batch, min_point, max_point, &batch_t[0]);
+		time = GetTime() - start;
+		batch_time = repeat == 0 ? time : min(batch_time, time);
+	}
+
+	// The entry distances may differ in the last bits
+	num_mismatches = 0;
+	for (size_t i = 0; i < rays.size(); ++i)
+	{
+		if ((scalar_t[i] >= 0) != (batch_t[i] >= 0) || fabs(scalar_t[i] - batch_t[i]) > 0.001f)
+			++num_mismatches;
+	}
+
+	fprintf(file, "Rays against box: %d rays, %d hits\n", (int)rays.size(), num_hits);
+	fprintf(file, "  RayBoxIntersection           %9.3f ms\n", scalar_time);
+	fprintf(file, "  RayBatchBoxIntersection      %9.3f ms  %.1fx\n", batch_time, batch_time > 0 ? scalar_time / batch_time : 0);
+	fprintf(file, "  mismatches %d\n", num_mismatches);
+
+	fclose(file);
+	return true;
+}
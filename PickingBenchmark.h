@@ -0,0 +1,9 @@
+#ifndef __PICKING_BENCHMARK_H__
+#define __PICKING_BENCHMARK_H__
+
+// Times the scalar intersection tests of Math.h against the batch versions of MathSIMD.h on the
+// stickers of a large cube, checks that both find the same hits, and writes the results as text.
+// Return false if the file could not be written.
+bool RunPickingBenchmark(const char* file_name);
+
+#endif // end __PICKING_BENCHMARK_H__
@@ -0,0 +1,312 @@
+#include "PuzzleFile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char kBinaryMagic[4] = { 'R', 'B', 'K', 'P' };
+static const char kTextMagic[] = "RubikCube puzzle";
+static const unsigned int kVersion = 1;
+
+// The slot * 24 + orientation of the last cube must fit in an unsigned int
+static const int kMaxLayers = 512;
+
+struct PuzzleFileHeader
+{
+	char magic[4];
+	unsigned int version;
+	int num_layers;
+	float camera_radius;
+	float view_rotation[4];		// x, y, z, w
+};
+
+// Bit 2 * axis of the result is set if the slot is on the negative side of the puzzle on that axis,
+// bit 2 * axis + 1 if on the positive side, a cube in the slot has a sticker on each of these faces
+static unsigned int GetOuterFaces(unsigned int slot, int num_layers)
+{
+	unsigned int faces = 0;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		int position = slot % num_layers;
+		slot /= num_layers;
+
+		if (position == 0)
+			faces |= 1 << (2 * axis);
+		if (position == num_layers - 1)
+			faces |= 2 << (2 * axis);
+	}
+
+	return faces;
+}
+
+/*
+Every slot is taken by one cube, and each cube with stickers sits in a slot with its stickers on
+the outer faces of that slot, which a placement made by turns always does. Unpack trusts the slots,
+and a cube turned away from the surface would show its stickers inside the puzzle.
+*/
+static bool IsValidPlacement(const unsigned int* placement, int num_layers)
+{
+	// The outer face each face goes to, for the rotation of each orientation(rows are the images of the axes)
+	int turned_faces[CubePlacement::kNumOrientations][6];
+	for (int orientation = 0; orientation < CubePlacement::kNumOrientations; ++orientation)
+	{
+		Matrix rotation;
+		MatrixRotationQuaternion(&rotation, &CubePlacement::GetOrientationQuaternion(orientation));
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			for (int target = 0; target < 3; ++target)
+			{
+				if (rotation.m[axis][target] > 0.5f)
+				{
+					turned_faces[orientation][2 * axis]     = 2 * target;
+					turned_faces[orientation][2 * axis + 1] = 2 * target + 1;
+				}
+				else if (rotation.m[axis][target] < -0.5f)
+				{
+					turned_faces[orientation][2 * axis]     = 2 * target + 1;
+					turned_faces[orientation][2 * axis + 1] = 2 * target;
+				}
+			}
+		}
+	}
+
+	int num_cubes = num_layers * num_layers * num_layers;
+	std::vector<bool> used(num_cubes, false);
+	for (int i = 0; i < num_cubes; ++i)
+	{
+		unsigned int slot = placement[i] / CubePlacement::kNumOrientations;
+		if (slot >= (unsigned int)num_cubes || used[slot])
+			return false;
+		used[slot] = true;
+
+		// A cube starts in the slot of its own number, so its stickers are the outer faces of that slot
+		unsigned int stickers = GetOuterFaces(i, num_layers);
+		unsigned int outer_faces = GetOuterFaces(slot, num_layers);
+
+		const int* turned = turned_faces[placement[i] % CubePlacement::kNumOrientations];
+		unsigned int turned_stickers = 0;
+		for (int face = 0; face < 6; ++face)
+		{
+			if (stickers & (1 << face))
+				turned_stickers |= 1 << turned[face];
+		}
+
+		if (turned_stickers != outer_faces)
+			return false;
+	}
+
+	return true;
+}
+
+PuzzleFile::PuzzleFile(void)
+	: num_layers_(0),
+	  placement_(NULL),
+	  file_(INVALID_HANDLE_VALUE),
+	  mapping_(NULL),
+	  mapped_data_(NULL)
+{
+	view_.camera_radius = 0;
+	QuaternionIdentity(&view_.view_rotation);
+}
+
+PuzzleFile::~PuzzleFile(void)
+{
+	Close();
+}
+
+bool PuzzleFile::Open(const char* file_name)
+{
+	Close();
+
+	FILE* file = fopen(file_name, "rb");
+	if (file == NULL)
+		return false;
+
+	char magic[4] = { 0 };
+	size_t read = fread(magic, 1, sizeof(magic), file);
+	fclose(file);
+
+	bool opened = false;
+	if (read == sizeof(magic) && memcmp(magic, kBinaryMagic, sizeof(magic)) == 0)
+		opened = OpenBinary(file_name);
+	else
+		opened = OpenText(file_name);
+
+	if (!opened)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool PuzzleFile::OpenBinary(const char* file_name)
+{
+	file_ = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file_ == INVALID_HANDLE_VALUE)
+		return false;
+
+	DWORD size_high = 0;
+	DWORD size = GetFileSize(file_, &size_high);
+	if (size == INVALID_FILE_SIZE || size_high != 0 || size < sizeof(PuzzleFileHeader))
+		return false;
+
+	mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping_ == NULL)
+		return false;
+
+	mapped_data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+	if (mapped_data_ == NULL)
+		return false;
+
+	const PuzzleFileHeader* header = (const PuzzleFileHeader*)mapped_data_;
+	if (header->version != kVersion || header->num_layers < 1 || header->num_layers > kMaxLayers)
+		return false;
+
+	int num_cubes = header->num_layers * header->num_layers * header->num_layers;
+	if (size != sizeof(PuzzleFileHeader) + num_cubes * sizeof(unsigned int))
+		return false;
+
+	const unsigned int* placement = (const unsigned int*)(header + 1);
+	if (!IsValidPlacement(placement, header->num_layers))
+		return false;
+
+	num_layers_ = header->num_layers;
+	view_.camera_radius = header->camera_radius;
+	view_.view_rotation = Quaternion(header->view_rotation[0], header->view_rotation[1], header->view_rotation[2], header->view_rotation[3]);
+	placement_ = placement;
+
+	return true;
+}
+
+bool PuzzleFile::OpenText(const char* file_name)
+{
+	FILE* file = fopen(file_name, "r");
+	if (file == NULL)
+		return false;
+
+	char magic[32] = { 0 };
+	char section[16] = { 0 };
+	unsigned int version = 0;
+	int num_layers = 0;
+	PuzzleView view;
+	Quaternion& q = view.view_rotation;
+
+	bool valid = fscanf(file, "%31[^0-9\n] %u\n", magic, &version) == 2
+			  && strncmp(magic, kTextMagic, strlen(kTextMagic)) == 0 && version == kVersion
+			  && fscanf(file, " layers %d", &num_layers) == 1 && num_layers >= 1 && num_layers <= kMaxLayers
+			  && fscanf(file, " camera_radius %f", &view.camera_radius) == 1
+			  && fscanf(file, " view_rotation %f %f %f %f", &q.x, &q.y, &q.z, &q.w) == 4
+			  && fscanf(file, " %15s", section) == 1 && strcmp(section, "cubes") == 0;
+
+	int num_cubes = num_layers * num_layers * num_layers;
+	if (valid)
+	{
+		text_placement_.resize(num_cubes);
+		for (int i = 0; i < num_cubes && valid; ++i)
+		{
+			unsigned int slot, orientation;
+			valid = fscanf(file, "%u %u", &slot, &orientation) == 2
+				 && slot < (unsigned int)num_cubes && orientation < CubePlacement::kNumOrientations;
+			text_placement_[i] = slot * CubePlacement::kNumOrientations + orientation;
+		}
+	}
+
+	fclose(file);
+
+	if (!valid || !IsValidPlacement(&text_placement_[0], num_layers))
+		return false;
+
+	num_layers_ = num_layers;
+	view_ = view;
+	placement_ = &text_placement_[0];
+
+	return true;
+}
+
+void PuzzleFile::Close()
+{
+	if (mapped_data_ != NULL)
+	{
+		UnmapViewOfFile(mapped_data_);
+		mapped_data_ = NULL;
+	}
+
+	if (mapping_ != NULL)
+	{
+		CloseHandle(mapping_);
+		mapping_ = NULL;
+	}
+
+	if (file_ != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_);
+		file_ = INVALID_HANDLE_VALUE;
+	}
+
+	text_placement_.clear();
+	placement_ = NULL;
+	num_layers_ = 0;
+}
+
+int PuzzleFile::GetNumLayers() const
+{
+	return num_layers_;
+}
+
+const PuzzleView& PuzzleFile::GetView() const
+{
+	return view_;
+}
+
+const unsigned int* PuzzleFile::GetPlacement() const
+{
+	return placement_;
+}
+
+bool PuzzleFile::Save(const char* file_name, const CubePlacement& placement, const PuzzleView& view)
+{
+	FILE* file = fopen(file_name, "wb");
+	if (file == NULL)
+		return false;
+
+	PuzzleFileHeader header;
+	memcpy(header.magic, kBinaryMagic, sizeof(header.magic));
+	header.version = kVersion;
+	header.num_layers = placement.GetNumLayers();
+	header.camera_radius = view.camera_radius;
+	header.view_rotation[0] = view.view_rotation.x;
+	header.view_rotation[1] = view.view_rotation.y;
+	header.view_rotation[2] = view.view_rotation.z;
+	header.view_rotation[3] = view.view_rotation.w;
+
+	std::vector<unsigned int> packed(placement.GetNumCubes());
+	placement.Pack(&packed[0]);
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+				&& fwrite(&packed[0], sizeof(unsigned int), packed.size(), file) == packed.size();
+
+	return fclose(file) == 0 && written;
+}
+
+bool PuzzleFile::SaveText(const char* file_name, const CubePlacement& placement, const PuzzleView& view)
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	const Quaternion& q = view.view_rotation;
+	fprintf(file, "%s %u\n", kTextMagic, kVersion);
+	fprintf(file, "layers %d\n", placement.GetNumLayers());
+	fprintf(file, "camera_radius %.9g\n", view.camera_radius);
+	fprintf(file, "view_rotation %.9g %.9g %.9g %.9g\n", q.x, q.y, q.z, q.w);
+	fprintf(file, "cubes\n");
+
+	for (int i = 0; i < placement.GetNumCubes(); ++i)
+	{
+		fprintf(file, "%d %d\n", placement.GetSlot(i), placement.GetOrientation(i));
+	}
+
+	return fclose(file) == 0;
+}
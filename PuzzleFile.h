@@ -0,0 +1,62 @@
+#ifndef __PUZZLE_FILE_H__
+#define __PUZZLE_FILE_H__
+
+#include <windows.h>
+#include <vector>
+#include "CubePlacement.h"
+
+// The view saved with a puzzle
+struct PuzzleView
+{
+	float camera_radius;		// Distance from the camera to the Rubik Cube
+	Quaternion view_rotation;	// Rotation of the view arc ball
+};
+
+/*
+A saved puzzle: the number of layers, the slot and orientation of every cube(CubePlacement::Pack)
+and the view. The binary form is a 32 byte header followed by the packed placement, one unsigned int
+per cube, in the byte order of the machine. It is opened by mapping the file into memory, the
+placement is read in place, so a big cube starts with one file map and no parsing.
+The text form has the same content, one "name values" line for the header fields and one
+"slot orientation" line per cube, for reading and editing by hand. Open tells the forms apart by
+the first bytes of the file.
+*/
+class PuzzleFile
+{
+public:
+	PuzzleFile(void);
+	~PuzzleFile(void);
+
+	// Return false if the file can not be read or is not a puzzle file
+	bool Open(const char* file_name);
+	void Close();
+
+	int GetNumLayers() const;
+	const PuzzleView& GetView() const;
+
+	// GetNumLayers()^3 values, valid until Close
+	const unsigned int* GetPlacement() const;
+
+	static bool Save(const char* file_name, const CubePlacement& placement, const PuzzleView& view);
+	static bool SaveText(const char* file_name, const CubePlacement& placement, const PuzzleView& view);
+
+private:
+	bool OpenBinary(const char* file_name);
+	bool OpenText(const char* file_name);
+
+private:
+	PuzzleFile(const PuzzleFile&);
+	PuzzleFile& operator=(const PuzzleFile&);
+
+private:
+	int num_layers_;
+	PuzzleView view_;
+	const unsigned int* placement_;
+
+	HANDLE file_;						// The mapped binary file
+	HANDLE mapping_;
+	const void* mapped_data_;
+	std::vector<unsigned int> text_placement_;	// The placement read from a text file
+};
+
+#endif // end __PUZZLE_FILE_H__
@@ -0,0 +1,255 @@
+#include "RecordingRenderDevice.h"
+
+#include <string.h>
+
+RecordingRenderDevice::RecordingRenderDevice(void)
+	: record_commands_(false),
+	  texture_(kInvalidHandle),
+	  vertex_buffer_(kInvalidHandle),
+	  index_buffer_(kInvalidHandle),
+	  vertex_format_(-1)
+{
+	for (int i = 0; i < kNumTransformTypes; ++i)
+	{
+		transform_valid_[i] = false;
+	}
+
+	ResetStats();
+}
+
+RecordingRenderDevice::~RecordingRenderDevice(void)
+{
+}
+
+BufferHandle RecordingRenderDevice::CreateVertexBuffer(const void* vertices, int size, VertexFormat format)
+{
+	buffer_sizes_.push_back(size);
+	stats_.bytes_uploaded += size;
+	return (BufferHandle)(buffer_sizes_.size() - 1);
+}
+
+BufferHandle RecordingRenderDevice::CreateIndexBuffer(const unsigned short* indices, int num_indices)
+{
+	int size = num_indices * sizeof(unsigned short);
+	buffer_sizes_.push_back(size);
+	stats_.bytes_uploaded += size;
+	return (BufferHandle)(buffer_sizes_.size() - 1);
+}
+
+void RecordingRenderDevice::UpdateBuffer(BufferHandle buffer, const void* data, int offset, int size)
+{
+	stats_.bytes_uploaded += size;
+}
+
+void RecordingRenderDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	if (buffer != kInvalidHandle)
+		buffer_sizes_[buffer] = -1;
+}
+
+TextureHandle RecordingRenderDevice::CreateTexture(int width, int height, const unsigned int* pixels)
+{
+	int size = width * height * 4;
+	texture_sizes_.push_back(size);
+	stats_.bytes_uploaded += size;
+	return (TextureHandle)(texture_sizes_.size() - 1);
+}
+
+void RecordingRenderDevice::UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels)
+{
+	stats_.bytes_uploaded += width * height * 4;
+}
+
+void RecordingRenderDevice::ReleaseTexture(TextureHandle texture)
+{
+	if (texture != kInvalidHandle)
+		texture_sizes_[texture] = -1;
+}
+
+void RecordingRenderDevice::SetTransform(TransformType type, const float* matrix)
+{
+	bool redundant = transform_valid_[type] && memcmp(transforms_[type], matrix, sizeof(transforms_[type])) == 0;
+	memcpy(transforms_[type], matrix, sizeof(transforms_[type]));
+	transform_valid_[type] = true;
+
+	CountStateChange(redundant);
+	Record(kCommandSetTransform, type);
+}
+
+void RecordingRenderDevice::SetTexture(TextureHandle texture)
+{
+	CountStateChange(texture == texture_);
+	texture_ = texture;
+	Record(kCommandSetTexture, texture);
+}
+
+void RecordingRenderDevice::SetStreamSource(BufferHandle vertex_buffer, int stride)
+{
+	CountStateChange(vertex_buffer == vertex_buffer_);
+	vertex_buffer_ = vertex_buffer;
+	Record(kCommandSetStreamSource, vertex_buffer);
+}
+
+void RecordingRenderDevice::SetIndices(BufferHandle index_buffer)
+{
+	CountStateChange(index_buffer == index_buffer_);
+	index_buffer_ = index_buffer;
+	Record(kCommandSetIndices, index_buffer);
+}
+
+void RecordingRenderDevice::SetVertexFormat(VertexFormat format)
+{
+	CountStateChange(format == vertex_format_);
+	vertex_format_ = format;
+	Record(kCommandSetVertexFormat, format);
+}
+
+void RecordingRenderDevice::SetLight(int index, const Light& light)
+{
+	CountStateChange(false);
+	Record(kCommandSetLight, index);
+}
+
+void RecordingRenderDevice::SetMaterial(const Material& material)
+{
+	CountStateChange(false);
+	Record(kCommandSetMaterial, 0);
+}
+
+void RecordingRenderDevice::DrawIndexedPrimitive(PrimitiveType type, int num_vertices, int start_index, int primitive_count)
+{
+	++stats_.draw_calls;
+	stats_.primitives += primitive_count;
+	Record(kCommandDraw, primitive_count);
+}
+
+void RecordingRenderDevice::DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances)
+{
+	++stats_.draw_calls;
+
+	// Count the primitives of the quads in the face mask, assuming each quad has the same number of triangles
+	int num_quads = num_vertices / 4;
+	for (int i = 0; i < num_instances; ++i)
+	{
+		int num_visible_quads = 0;
+		for (int j = 0; j < num_quads; ++j)
+		{
+			if (instances[i].face_mask & (1 << j))
+				++num_visible_quads;
+		}
+
+		stats_.primitives += num_quads > 0 ? primitive_count * num_visible_quads / num_quads : primitive_count;
+	}
+
+	// The instance data is uploaded for every draw
+	stats_.bytes_uploaded += num_instances * sizeof(InstanceData);
+	Record(kCommandDraw, primitive_count * num_instances);
+}
+
+void RecordingRenderDevice::Clear(unsigned int color)
+{
+	Record(kCommandClear, (int)color);
+}
+
+bool RecordingRenderDevice::BeginScene()
+{
+	return true;
+}
+
+void RecordingRenderDevice::EndScene()
+{
+}
+
+bool RecordingRenderDevice::Present()
+{
+	++stats_.frames;
+	Record(kCommandPresent, stats_.frames);
+	return true;
+}
+
+const RenderStats& RecordingRenderDevice::GetStats() const
+{
+	return stats_;
+}
+
+void RecordingRenderDevice::ResetStats()
+{
+	memset(&stats_, 0, sizeof(stats_));
+}
+
+void RecordingRenderDevice::SetRecordCommands(bool record_commands)
+{
+	record_commands_ = record_commands;
+}
+
+const std::vector<RenderCommand>& RecordingRenderDevice::GetCommands() const
+{
+	return commands_;
+}
+
+void RecordingRenderDevice::ClearCommands()
+{
+	commands_.clear();
+}
+
+int RecordingRenderDevice::GetNumLiveBuffers() const
+{
+	int count = 0;
+	for (size_t i = 0; i < buffer_sizes_.size(); ++i)
+	{
+		if (buffer_sizes_[i] >= 0)
+			++count;
+	}
+	return count;
+}
+
+int RecordingRenderDevice::GetNumLiveTextures() const
+{
+	int count = 0;
+	for (size_t i = 0; i < texture_sizes_.size(); ++i)
+	{
+		if (texture_sizes_[i] >= 0)
+			++count;
+	}
+	return count;
+}
+
+int RecordingRenderDevice::GetBufferMemory() const
+{
+	int bytes = 0;
+	for (size_t i = 0; i < buffer_sizes_.size(); ++i)
+	{
+		if (buffer_sizes_[i] > 0)
+			bytes += buffer_sizes_[i];
+	}
+	return bytes;
+}
+
+int RecordingRenderDevice::GetTextureMemory() const
+{
+	int bytes = 0;
+	for (size_t i = 0; i < texture_sizes_.size(); ++i)
+	{
+		if (texture_sizes_[i] > 0)
+			bytes += texture_sizes_[i];
+	}
+	return bytes;
+}
+
+void RecordingRenderDevice::Record(RenderCommandType type, int value)
+{
+	if (!record_commands_)
+		return;
+
+	RenderCommand command;
+	command.type  = type;
+	command.value = value;
+	commands_.push_back(command);
+}
+
+void RecordingRenderDevice::CountStateChange(bool redundant)
+{
+	++stats_.state_changes;
+	if (redundant)
+		++stats_.redundant_state_changes;
+}
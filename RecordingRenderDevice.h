@@ -0,0 +1,107 @@
+#ifndef __RECORDING_RENDER_DEVICE_H__
+#define __RECORDING_RENDER_DEVICE_H__
+
+#include <vector>
+
+#include "RenderDevice.h"
+
+// Counters collected by the recording device, reset by ResetStats
+struct RenderStats
+{
+	int frames;						// Number of Present calls
+	int draw_calls;					// Number of draw calls
+	int primitives;					// Number of primitives(triangles) drawn
+	int state_changes;				// Number of Set* calls
+	int redundant_state_changes;	// Set* calls which set the value already bound
+	int bytes_uploaded;				// Bytes copied into buffers and textures
+};
+
+enum RenderCommandType
+{
+	kCommandSetTransform = 0,
+	kCommandSetTexture,
+	kCommandSetStreamSource,
+	kCommandSetIndices,
+	kCommandSetVertexFormat,
+	kCommandSetLight,
+	kCommandSetMaterial,
+	kCommandDraw,
+	kCommandClear,
+	kCommandPresent
+};
+
+// One recorded call, value is the handle/format/primitive count depends on the type
+struct RenderCommand
+{
+	RenderCommandType type;
+	int value;
+};
+
+// A render device which draws nothing, it only counts the calls and records them in order,
+// so the number of draw calls and state changes of a frame can be measured without a GPU.
+class RecordingRenderDevice : public RenderDevice
+{
+public:
+	RecordingRenderDevice(void);
+	~RecordingRenderDevice(void);
+
+	BufferHandle CreateVertexBuffer(const void* vertices, int size, VertexFormat format);
+	BufferHandle CreateIndexBuffer(const unsigned short* indices, int num_indices);
+	void UpdateBuffer(BufferHandle buffer, const void* data, int offset, int size);
+	void ReleaseBuffer(BufferHandle buffer);
+
+	TextureHandle CreateTexture(int width, int height, const unsigned int* pixels);
+	void UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels);
+	void ReleaseTexture(TextureHandle texture);
+
+	void SetTransform(TransformType type, const float* matrix);
+	void SetTexture(TextureHandle texture);
+	void SetStreamSource(BufferHandle vertex_buffer, int stride);
+	void SetIndices(BufferHandle index_buffer);
+	void SetVertexFormat(VertexFormat format);
+	void SetLight(int index, const Light& light);
+	void SetMaterial(const Material& material);
+
+	void DrawIndexedPrimitive(PrimitiveType type, int num_vertices, int start_index, int primitive_count);
+	void DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances);
+
+	void Clear(unsigned int color);
+	bool BeginScene();
+	void EndScene();
+	bool Present();
+
+	const RenderStats& GetStats() const;
+	void ResetStats();
+
+	// Record every call into the command list, off by default.
+	void SetRecordCommands(bool record_commands);
+	const std::vector<RenderCommand>& GetCommands() const;
+	void ClearCommands();
+
+	int GetNumLiveBuffers() const;
+	int GetNumLiveTextures() const;
+	int GetBufferMemory() const;		// Bytes hold by live buffers
+	int GetTextureMemory() const;		// Bytes hold by live textures
+
+private:
+	void Record(RenderCommandType type, int value);
+	void CountStateChange(bool redundant);
+
+private:
+	RenderStats stats_;
+	bool record_commands_;
+	std::vector<RenderCommand> commands_;
+
+	std::vector<int> buffer_sizes_;		// Indexed by BufferHandle, -1 for released buffer
+	std::vector<int> texture_sizes_;	// Indexed by TextureHandle, -1 for released texture
+
+	// Currently bound states, used to detect redundant state changes
+	float transforms_[kNumTransformTypes][16];
+	bool transform_valid_[kNumTransformTypes];
+	TextureHandle texture_;
+	BufferHandle vertex_buffer_;
+	BufferHandle index_buffer_;
+	int vertex_format_;
+};
+
+#endif // end __RECORDING_RENDER_DEVICE_H__
@@ -0,0 +1,139 @@
+#ifndef __RENDER_DEVICE_H__
+#define __RENDER_DEVICE_H__
+
+// Backend-neutral render device interface.
+// The drawing code (Cube, RubikCube) only talks to this interface, so it can run against
+// Direct3D 9 (D3D9RenderDevice) or against a recording backend (RecordingRenderDevice)
+// which needs no GPU and no Windows headers.
+// Matrices are passed as 16 floats in row-major order, the same memory layout as Matrix,
+// colors are 32-bit ARGB values, the same as D3DCOLOR.
+
+typedef int BufferHandle;
+typedef int TextureHandle;
+
+const int kInvalidHandle = -1;
+
+enum TransformType
+{
+	kWorldTransform      = 0,
+	kViewTransform       = 1,
+	kProjectionTransform = 2,
+
+	kNumTransformTypes   = 3
+};
+
+enum PrimitiveType
+{
+	kTriangleList  = 0,
+	kTriangleStrip = 1
+};
+
+enum VertexFormat
+{
+	kVertexPositionNormalTexture = 0,	// Vertex: position, normal, one set of texture coordinates
+
+	kNumVertexFormats = 1
+};
+
+// Vertex layout for kVertexPositionNormalTexture
+struct Vertex
+{
+	float  x,  y,  z; // position
+	float nx, ny, nz; // normal
+	float  u,  v;     // texture
+};
+
+// Size in bytes of one vertex of the given format
+inline int GetVertexStride(VertexFormat format)
+{
+	switch (format)
+	{
+	case kVertexPositionNormalTexture:
+		return sizeof(Vertex);
+	default:
+		return 0;
+	}
+}
+
+// Per-instance data for DrawIndexedInstanced.
+// The mesh vertices are grouped in quads, vertex i takes the color colors[i / 4] and the texture
+// rectangle uv_rects[i / 4], so for the unit cube mesh(24 vertices, 4 for each face) there is one
+// color and one texture rectangle per face. A triangle is only drawn when the bit of its quad
+// (the quad of its first vertex) is set in face_mask.
+const int kMaxInstanceColors = 6;
+const unsigned int kAllQuads = (1 << kMaxInstanceColors) - 1;	// face_mask to draw the whole mesh
+
+struct InstanceData
+{
+	float world[16];						// World matrix of the instance, applied before the world transform
+	unsigned int colors[kMaxInstanceColors];	// ARGB color of each quad, modulated with the texture
+	float uv_rects[kMaxInstanceColors][4];	// Texture rectangle(u, v, width, height) of each quad, the mesh
+											// texture coordinates in [0, 1] are mapped into it
+	unsigned int face_mask;					// Bit i set to draw quad i
+};
+
+// Point light
+struct Light
+{
+	float position[3];
+	float ambient[4];	// r, g, b, a
+	float diffuse[4];
+	float specular[4];
+	float range;
+	float attenuation[3];	// constant, linear, quadratic
+};
+
+// Surface material
+struct Material
+{
+	float ambient[4];	// r, g, b, a
+	float diffuse[4];
+	float specular[4];
+	float emissive[4];
+	float power;
+};
+
+class RenderDevice
+{
+public:
+	virtual ~RenderDevice(void) {}
+
+	// Buffers, the data was copied into the buffer when created.
+	virtual BufferHandle CreateVertexBuffer(const void* vertices, int size, VertexFormat format) = 0;
+	virtual BufferHandle CreateIndexBuffer(const unsigned short* indices, int num_indices) = 0;
+	virtual void UpdateBuffer(BufferHandle buffer, const void* data, int offset, int size) = 0;
+	virtual void ReleaseBuffer(BufferHandle buffer) = 0;
+
+	// Textures, pixels are ARGB and tightly packed(width pixels per row).
+	virtual TextureHandle CreateTexture(int width, int height, const unsigned int* pixels) = 0;
+
+	// Copy width x height pixels into the rectangle at (x, y) of a texture. Update a texture before
+	// the draws of the frame which use it, the draws may be rasterized when the frame is presented.
+	virtual void UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels) = 0;
+	virtual void ReleaseTexture(TextureHandle texture) = 0;
+
+	// States
+	virtual void SetTransform(TransformType type, const float* matrix) = 0;
+	virtual void SetTexture(TextureHandle texture) = 0;
+	virtual void SetStreamSource(BufferHandle vertex_buffer, int stride) = 0;
+	virtual void SetIndices(BufferHandle index_buffer) = 0;
+	virtual void SetVertexFormat(VertexFormat format) = 0;
+	virtual void SetLight(int index, const Light& light) = 0;
+	virtual void SetMaterial(const Material& material) = 0;
+
+	// Draw with the current stream source and indices
+	virtual void DrawIndexedPrimitive(PrimitiveType type, int num_vertices, int start_index, int primitive_count) = 0;
+
+	// Draw the current mesh once for each instance in one call, the mesh must be a triangle list
+	// of at most 4 * kMaxInstanceColors vertices in kVertexPositionNormalTexture format.
+	// The states set before the call are still bound after it.
+	virtual void DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances) = 0;
+
+	// Frame
+	virtual void Clear(unsigned int color) = 0;
+	virtual bool BeginScene() = 0;
+	virtual void EndScene() = 0;
+	virtual bool Present() = 0;	// return false if the device was lost
+};
+
+#endif // end __RENDER_DEVICE_H__
@@ -1,7 +1,31 @@
 #include "RubikCube.h"
 #include "DXErr.h"
+#include "FrameRecorder.h"
+#include "StickerAtlas.h"
+#include <limits.h>
 #include <time.h>
 
+// An inactive window draws at most one frame in this time, in milliseconds
+static const double kInactiveFrameTime = 25;
+
+// Sent by the simulation thread when a new snapshot was published
+static const UINT WM_SNAPSHOT = WM_APP + 1;
+
+// Sent by the atlas thread when the full sticker atlas is ready
+static const UINT WM_ATLAS_READY = WM_APP + 2;
+
+// Sent by the solver thread when a solve finished
+static const UINT WM_SOLUTION = WM_APP + 3;
+
+// The sticker atlas, the placeholder drawn until the full atlas is ready has small tiles with the same layout
+static const char* kAtlasFile = "StickerAtlas.cache";
+static const int kAtlasBorderWidth = 10;
+static const unsigned int kAtlasBorderColor = 0xff000000;
+static const int kPlaceholderTileSize = 16;
+
+// The simulation runs at 120 ticks per second, in milliseconds
+static const double kTickTime = 1000.0 / 120;
+
 RubikCube::RubikCube(void)
 	: kNumLayers(3),
       kNumCubes(kNumLayers * kNumLayers * kNumLayers),
@@ -24,19 +48,40 @@ RubikCube::RubikCube(void)
 	  last_window_height_(current_window_height_),
 	  texture_width_(128),
 	  texture_height_(128),
-	  inner_textures_(NULL)
+	  sticker_texture_(kInvalidHandle),
+	  full_atlas_(NULL),
+	  show_profiler_(false),
+	  record_frame_(false),
+	  move_queue_(kNumLayers),
+	  history_(kNumLayers),
+	  posted_commands_(0),
+	  executed_commands_(0),
+	  mouse_rotating_layer_(-1),
+	  snapshot_posted_(false),
+	  solve_requests_(0),
+	  solve_animate_(false)
 {
+	hint_text_[0] = 0;
+
 	d3d9 = new D3D9();
 
 	world_arcball_ = new ArcBall();
 
 	camera_ = new Camera();
 
+	// All the data which lives as long as the puzzle comes from one arena sized from the number of layers,
+	// so a Rubik Cube of any size is one allocation
+	size_t arena_size = Arena::GetArraySize<Cube>(kNumCubes)
+					  + Arena::GetArraySize<Rect>(kNumFaces)
+					  + Arena::GetArraySize<int>(kNumFaces)
+					  + CubeTransforms::GetStorageSize(kNumLayers);
+	puzzle_arena_.Init(arena_size);
+
 	// Create 27 unit cubes
-	cubes = new Cube[kNumCubes];
+	cubes = puzzle_arena_.NewArray<Cube>(kNumCubes);
 
 	// Create 6 faces
-	faces = new Rect[kNumFaces];
+	faces = puzzle_arena_.NewArray<Rect>(kNumFaces);
 
 	// Calculate face length and half face length which will used later to determine unit cube layer.
 	float cube_length = cubes[0].GetLength();
@@ -48,15 +93,15 @@ RubikCube::RubikCube(void)
 	float gap = gap_between_layers_;
 
 	// Calculate the coordinates of the 8 corner points on Rubik Cube, we use them to mark the Face coordinates later.
-	D3DXVECTOR3 A(-half_face_length,  half_face_length, -half_face_length); // The front-top-left corner
-	D3DXVECTOR3 B( half_face_length,  half_face_length, -half_face_length);
-	D3DXVECTOR3 C( half_face_length, -half_face_length, -half_face_length);
-	D3DXVECTOR3 D(-half_face_length, -half_face_length, -half_face_length);
+	Vector3 A(-half_face_length,  half_face_length, -half_face_length); // The front-top-left corner
+	Vector3 B( half_face_length,  half_face_length, -half_face_length);
+	Vector3 C( half_face_length, -half_face_length, -half_face_length);
+	Vector3 D(-half_face_length, -half_face_length, -half_face_length);
 
-	D3DXVECTOR3 E(-half_face_length,  half_face_length,  half_face_length); // The back-top-left corner
-	D3DXVECTOR3 F( half_face_length,  half_face_length,  half_face_length);
-	D3DXVECTOR3 G( half_face_length, -half_face_length,  half_face_length);
-	D3DXVECTOR3 H(-half_face_length, -half_face_length,  half_face_length);
+	Vector3 E(-half_face_length,  half_face_length,  half_face_length); // The back-top-left corner
+	Vector3 F( half_face_length,  half_face_length,  half_face_length);
+	Vector3 G( half_face_length, -half_face_length,  half_face_length);
+	Vector3 H(-half_face_length, -half_face_length,  half_face_length);
 
 	// Initialize the 6 faces of Rubik Cube, faces used later in Ray-Cube hit test.
 	Rect  FrontFace(A, B, C, D) ; 
@@ -73,18 +118,49 @@ RubikCube::RubikCube(void)
 	faces[4] = TopFace;
 	faces[5] = BottomFace;
 
-	texture_id_ = new int[kNumFaces];
-	face_textures_ = new IDirect3DTexture9*[kNumFaces];
+	picker_.Init(kNumLayers, cube_length, gap_between_layers_);
+	transforms_.Init(kNumLayers, cube_length, gap_between_layers_, &puzzle_arena_);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		hit_cell_[i] = 0;
+	}
+
+	texture_id_ = puzzle_arena_.NewArray<int>(kNumFaces);
 
 	for(int i = 0; i < kNumFaces; ++i)
 	{
 		texture_id_[i] = -1;
-		face_textures_[i] = NULL;
 	}
 }
 
 RubikCube::~RubikCube(void)
 {
+	// The simulation thread uses the cubes
+	simulation_.Stop();
+
+	if (atlas_thread_.joinable())
+		atlas_thread_.join();
+	delete full_atlas_;
+	full_atlas_ = NULL;
+
+	// The cubes, faces and texture ids go with the puzzle arena
+	cubes = NULL;
+	faces = NULL;
+	texture_id_ = NULL;
+	puzzle_arena_.Release();
+
+	// The mesh and textures are released through the render device,
+	// so they must be released before the d3d9 objects.
+	Cube::ReleaseMesh();
+
+	// Release sticker texture
+	if (sticker_texture_ != kInvalidHandle)
+	{
+		d3d9->GetRenderDevice()->ReleaseTexture(sticker_texture_);
+		sticker_texture_ = kInvalidHandle;
+	}
+
 	// Delete d3d9 objects;
 	delete d3d9;
 	d3d9 = NULL;
@@ -95,130 +171,98 @@ RubikCube::~RubikCube(void)
 	// Delete camera
 	delete camera_;
 	camera_ = NULL;
-
-	// Delete cubes
-	delete []cubes;
-	cubes = NULL;
-
-	// Delete faces
-	delete []faces;
-	faces = NULL;
-
-	delete []texture_id_;
-	texture_id_ = NULL;
-
-	// Release face textures
-	for(int i = 0; i < kNumFaces; ++i)
-	{
-		if(face_textures_[i] != NULL)
-		{
-			face_textures_[i]->Release();
-			face_textures_[i] = NULL;
-		}
-	}
-
-	// Release inner texture
-	if (inner_textures_ != NULL)
-	{
-		inner_textures_->Release();
-		inner_textures_ = NULL;
-	}
 }
 
-void RubikCube::Initialize(HWND hWnd)
+/*
+Only what the first frame shows is made before it: the device, a placeholder sticker atlas, the
+unit meshes and the cube placement. The full sticker atlas is loaded or generated by a background
+thread and replaces the placeholder when it is ready, the overlay font is created when the profiler
+overlay is first shown. The phases are timed by the startup profiler, 'E' writes them out.
+*/
+void RubikCube::Initialize(HWND hWnd, const char* puzzle_file)
 {
+	startup_profiler_.BeginPhase(kStartupDevice);
 	d3d9->InitD3D9(hWnd);
 	hWnd_ = hWnd;
 
+	startup_profiler_.BeginPhase(kStartupTextures);
 	InitTextures();
 
-	InitCubes();
+	startup_profiler_.BeginPhase(kStartupMeshes);
+	Cube::InitMesh(d3d9->GetRenderDevice());
 
-	ResetTextures();
+	startup_profiler_.BeginPhase(kStartupPuzzle);
 
-	ResetLayerIds();
-}
-
-/*
-The layer id was count from X-axis first, from left to right, 0, 1, 2, ...
-Then from Y-axis, kNumLayers, kNumLayers + 1, ...
-Then from Z-axis, 2 * kNumLayers, 2 * kNumLayers + 1, ....
-*/
-void RubikCube::ResetLayerIds()
-{
-	float length = cubes[0].GetLength();
-	float gap    = gap_between_layers_;
-	float half_face_length = face_length_ / 2;
-
-	for (int i = 0; i < kNumCubes; ++i)
+	// A saved puzzle puts the cubes straight where they were, the history starts there
+	CubePlacement placement(kNumLayers);
+	if (puzzle_file != NULL && OpenPuzzle(puzzle_file, &placement))
 	{
-		float center_x = cubes[i].GetCenter().x + half_face_length;
-		float center_y = cubes[i].GetCenter().y + half_face_length;
-		float center_z = cubes[i].GetCenter().z + half_face_length;
+		history_.Clear(placement);
+		transforms_.SetPlacement(placement);
+	}
+	else
+	{
+		if (puzzle_file != NULL)
+			MessageBox(hWnd, L"Load puzzle file failed!", L"error!", 0) ;
 
-		for (int j = 0; j < kNumLayers; ++j)
-		{
-			if (center_x >= j * (length + gap) 
-				&& center_x <= (j + 1) * (length + gap) - gap)
-			{
-				cubes[i].SetLayerIdX(j);
-			}
+		InitCubes();
+	}
 
-			if (center_y >= j * (length + gap)
-				&& center_y <= (j + 1) * (length + gap) - gap)
-			{
-				cubes[i].SetLayerIdY(j + kNumLayers);
-			}
+	ResetTextures();
 
-			if (center_z >= j * (length + gap)
-				&& center_z <= (j + 1) * (length + gap) - gap)
-			{
-				cubes[i].SetLayerIdZ(j + 2 * kNumLayers);
-			}
-		}
-	}
+	// The first snapshot is published before the first frame
+	startup_profiler_.BeginPhase(kStartupSimulation);
+	Tick(0);
+	simulation_.Start(this, kTickTime);
+
+	startup_profiler_.BeginPhase(kStartupFirstFrame);
 }
 
+// The faces of the cubes on the surface of the Rubik Cube get the sticker of that face
 void RubikCube::ResetTextures()
 {
-	float half_face_length = face_length_ / 2;
-	float float_epsilon = 0.0001f; 
+	int last = kNumLayers - 1;
 
 	// Set texture for each face of Rubik Cube
 	for (int i = 0; i < kNumCubes; ++i)
 	{
+		// The layers the cube started in, the stickers stay with the cube wherever it is now
+		int x = i % kNumLayers;
+		int y = (i / kNumLayers) % kNumLayers;
+		int z = i / (kNumLayers * kNumLayers);
+
 		//Front face
-		if (fabs(cubes[i].GetMinPoint().z + half_face_length) < float_epsilon)
+		if (z == 0)
 		{
 			cubes[i].SetTextureId(0, 0);
 		}
 
 		// Back face
-		if (fabs(cubes[i].GetMaxPoint().z - half_face_length) < float_epsilon)
+		if (z == last)
 		{
 			cubes[i].SetTextureId(1, 1);
 		}
 
 		// Left face
-		if (fabs(cubes[i].GetMinPoint().x + half_face_length) < float_epsilon)
+		if (x == 0)
 		{
 			cubes[i].SetTextureId(2, 2);
 		}
 
 		// Right face
-		if (fabs(cubes[i].GetMaxPoint().x - half_face_length) < float_epsilon)
+		if (x == last)
 		{
 			cubes[i].SetTextureId(3, 3);
 		}
 
 		// Top face
-		if (fabs(cubes[i].GetMaxPoint().y - half_face_length) < float_epsilon)
+		if (y == last)
 		{
 			cubes[i].SetTextureId(4, 4);
 		}
 
 		// Bottom face
-		if (fabs(cubes[i].GetMinPoint().y + half_face_length) < float_epsilon)
+		if (y == 0)
 		{
 			cubes[i].SetTextureId(5, 5);
 		}
@@ -227,47 +271,147 @@ void RubikCube::ResetTextures()
 
 void RubikCube::Render()
 {
-	// Window was inactive(minimized or hidden by other apps), yields 25ms to other program
-	if(!window_active_)
-	{
-		Sleep(25) ;
-	}
+	frame_scheduler_.OnFrameBegin();
+	profiler_.BeginFrame();
 
 	// Update frame
+	profiler_.BeginPhase(kPhaseFrameMove);
+	ProcessMouseMove();
 	d3d9->FrameMove() ;
+	snapshots_.Update();
 
+	profiler_.BeginPhase(kPhaseSetupMatrix);
 	d3d9->SetupMatrix();
 
+	profiler_.BeginPhase(kPhaseSetupLight);
 	d3d9->SetupLight();
 
-	LPDIRECT3DDEVICE9 d3ddevice_ = d3d9->GetD3DDevice();
+	profiler_.BeginPhase(kPhaseDraw);
+	RenderDevice* render_device = d3d9->GetRenderDevice();
 
 	// Clear the back buffer to a black color
-	d3ddevice_->Clear(0, NULL, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, 0x4F94CD, 1.0f, 0);
+	render_device->Clear(0x4F94CD);
 
-	if( SUCCEEDED(d3ddevice_->BeginScene()))
+	if(render_device->BeginScene())
 	{
-		//draw all unit cubes to build the Rubik cube
-		for(int i = 0; i < kNumCubes; i++)
+		// Record the draws, then submit them sorted by their states
+		draw_list_.Clear();
+
+		//draw all unit cubes to build the Rubik cube, the cube instances are placed relative to the world matrix
+		Matrix matWorld = camera_->GetWorldMatrix() ;
+		const CubeSnapshot& snapshot = snapshots_.GetFront();
+		Cube::DrawInstances(&draw_list_, matWorld, snapshot.instances.data(), (int)snapshot.instances.size());
+
+		draw_list_.Sort();
+		draw_list_.Submit(render_device);
+
+		if (record_frame_)
 		{
-			cubes[i].Draw();
+			RecordFrame(draw_list_, "FrameRecording.txt");
+			record_frame_ = false;
 		}
 
-		// Restore world matrix since the Draw function in class Cube has set the world matrix for each cube
-		D3DXMATRIX matWorld = camera_->GetWorldMatrix() ;
-		d3ddevice_->SetTransform(D3DTS_WORLD, &matWorld) ;
+		if (show_profiler_)
+			DrawProfilerOverlay();
 
-		d3ddevice_->EndScene();
+		if (hint_text_[0] != 0)
+			d3d9->DrawOverlayText(hint_text_, 8, current_window_height_ - 28, 0xffffffff);
+
+		render_device->EndScene();
 	}
 
 	// Present the back buffer contents to the display
-	HRESULT hr = d3ddevice_->Present(NULL, NULL, NULL, NULL);
-
 	// Render failed, try to reset device
-	if(FAILED(hr))
+	profiler_.BeginPhase(kPhasePresent);
+	if(!render_device->Present())
 	{
 		d3d9->ResetDevice() ;
+
+		// Draw again when the device was restored
+		frame_scheduler_.Invalidate();
+	}
+	else if (startup_profiler_.GetFirstFrameTime() == 0)
+	{
+		startup_profiler_.EndPhase();
 	}
+
+	profiler_.EndFrame(draw_list_.GetNumDraws());
+}
+
+// Frame rate, frame times of the recent frames, the startup time and the phase times of the last frame
+void RubikCube::DrawProfilerOverlay()
+{
+	FrameStats stats = profiler_.GetStats();
+
+	WCHAR text[256];
+	swprintf(text, 256, L"%.1f fps  p50 %.2f ms  p99 %.2f ms  %d draws  %d mesh bytes",
+		stats.fps, stats.p50_frame_time, stats.p99_frame_time, stats.draw_calls, GeometryPool::GetMemoryUsage());
+	d3d9->DrawOverlayText(text, 8, 8, 0xffffffff);
+
+	// The atlas thread writes its phase time, it is read once the thread was joined
+	double atlas_time = atlas_thread_.joinable() ? 0 : startup_profiler_.GetPhaseTime(kStartupStickerAtlas);
+	swprintf(text, 256, L"first frame %.1f ms of %d ms  sticker atlas %.1f ms",
+		startup_profiler_.GetFirstFrameTime(), StartupProfiler::kFirstFrameBudget, atlas_time);
+	d3d9->DrawOverlayText(text, 8, 28, 0xffffffff);
+
+	std::vector<FrameRecord> records;
+	profiler_.GetRecords(&records);
+	if (records.empty())
+		return;
+
+	const FrameRecord& last = records.back();
+	for (int i = 0; i < kNumFramePhases; ++i)
+	{
+		swprintf(text, 256, L"%-12hs %6.2f ms", FrameProfiler::GetPhaseName((FramePhase)i), last.phase_times[i]);
+		d3d9->DrawOverlayText(text, 8, 48 + i * 18, 0xffffffff);
+	}
+}
+
+void RubikCube::ExportProfile()
+{
+	profiler_.WriteCSV("FrameProfile.csv");
+	profiler_.WriteTrace("FrameProfile.json");
+	if (!atlas_thread_.joinable())
+		startup_profiler_.WriteReport("StartupProfile.csv");
+}
+
+// The scene changes when a layer rotates, the camera moves or the window is resized/activated, all
+// these come from messages, so the main loop can sleep until the next message when nothing changed.
+// The simulation thread sends WM_SNAPSHOT for every snapshot, so the rotations come as messages too.
+// The window was inactive(minimized or hidden by other apps), yields kInactiveFrameTime to other programs.
+DWORD RubikCube::GetRenderWaitTime()
+{
+	// Nothing is visible when minimized, WM_SIZE invalidates the frame when restored
+	if (IsIconic(hWnd_))
+		return INFINITE;
+
+	if (d3d9->NeedFrameMove())
+		frame_scheduler_.Invalidate();
+
+	return frame_scheduler_.GetWaitTime(window_active_ ? 0 : kInactiveFrameTime);
+}
+
+void RubikCube::SetTargetFps(int fps)
+{
+	frame_scheduler_.SetTargetFps(fps);
+}
+
+bool RubikCube::EnableRawInput()
+{
+	return mouse_input_.EnableRawInput(hWnd_);
+}
+
+/*
+The mouse messages only record the position, all the messages are handled before a frame is drawn,
+so the frame sees the latest position and the layer turns by the whole way since the last frame,
+the arc ball, picking and layer rotation run once per frame whatever the mouse rate is.
+*/
+void RubikCube::ProcessMouseMove()
+{
+	int x;
+	int y;
+	if (mouse_input_.GetMove(&x, &y))
+		OnMouseMove(x, y);
 }
 
 void RubikCube::Shuffle()
@@ -277,54 +421,285 @@ void RubikCube::Shuffle()
 	if(!rotate_finish_)
 		return ;
 
-	// Block other rotations 
-	rotate_finish_ = false ;
-
 	// Set the random seed
 	srand((unsigned int)time(0));
 
 	// Calculate total layers, a n x n x n Rubik Cube has 3 x n layers totally.
 	int total_layers = kNumLayers * 3;
 
-	// Rotate 20 times
-	for (int i = 0; i < 20; ++i)
+	// Queue 20 random turns, they are animated by the simulation thread, the mouse can not rotate until they finish
+	std::vector<int> layers(20);
+	for (size_t i = 0; i < layers.size(); ++i)
+	{
+		layers[i] = rand() % total_layers;
+	}
+
+	PostTurnCommand([this, layers]()
+	{
+		for (size_t i = 0; i < layers.size(); ++i)
+		{
+			move_queue_.Push(layers[i], 1);
+			history_.Record(layers[i], 1);
+		}
+	});
+}
+
+/*
+The commands are counted on both sides, a snapshot carries the number of commands run before it,
+so the message thread knows when the snapshot it draws shows all the changes it asked for.
+*/
+void RubikCube::PostCommand(const std::function<void()>& command)
+{
+	++posted_commands_;
+	simulation_.Post([this, command]()
+	{
+		command();
+		++executed_commands_;
+	});
+}
+
+/*
+A command which turns the cubes makes the hint and a running solve out of date, the solve is
+cancelled and its result will not match the request number any more.
+*/
+void RubikCube::PostTurnCommand(const std::function<void()>& command)
+{
+	CancelSolve();
+	PostCommand(command);
+}
+
+void RubikCube::CancelSolve()
+{
+	++solve_requests_;
+	solver_.Cancel();
+
+	if (hint_text_[0] != 0)
+	{
+		hint_text_[0] = 0;
+		frame_scheduler_.Invalidate();
+	}
+}
+
+/*
+The solve starts from the history on the simulation thread, so it sees the turns still queued,
+then runs on the solver thread. The message loop never waits for it, WM_SOLUTION brings the result.
+*/
+void RubikCube::RequestSolve(bool animate)
+{
+	if(!rotate_finish_)
+		return ;
+
+	int request = ++solve_requests_;
+	solve_animate_ = animate;
+
+	swprintf(hint_text_, 128, L"Solving...");
+	frame_scheduler_.Invalidate();
+
+	PostCommand([this, request]()
 	{
-		// Generate a random layer
-		int layer_id = rand() % total_layers;
+		CubePlacement start(kNumLayers);
+		std::vector<unsigned int> turns;
+		history_.GetStart(&start);
+		history_.GetTurns(&turns);
 
-		// Generate rotate axis based on rotate layer
-		D3DXVECTOR3 axis;
+		solver_.Start(request, start, turns, hWnd_, WM_SOLUTION);
+	});
+}
 
-		if (layer_id >= 0 && layer_id <= kNumLayers - 1)
-			axis = D3DXVECTOR3(1, 0, 0);
-		else if (layer_id >= kNumLayers && layer_id <= 2 * kNumLayers - 1)
-			axis = D3DXVECTOR3(0, 1, 0);
-		else // layer_id >= 2 * kNumLayers && layer_id <= 3 * kNumLayers - 1
-			axis = D3DXVECTOR3(0, 0, 1);
+// Show the next turn of the solution, or queue all of it
+void RubikCube::OnSolution()
+{
+	SolverResult result;
+	if (!solver_.GetResult(&result) || result.request != solve_requests_)
+		return;
 
-		RotateLayer(layer_id, axis, D3DX_PI / 2);
+	if (!result.solved)
+	{
+		swprintf(hint_text_, 128, L"No solution, the turn history does not start at a solved cube");
+	}
+	else if (result.turns.empty())
+	{
+		swprintf(hint_text_, 128, L"Solved");
+	}
+	else if (solve_animate_)
+	{
+		std::vector<unsigned int> turns;
+		turns.swap(result.turns);
 
-		for (int i = 0; i < kNumCubes; ++i)
+		PostTurnCommand([this, turns]()
 		{
-			if (cubes[i].InLayer(layer_id))
+			for (size_t i = 0; i < turns.size(); ++i)
 			{
-				cubes[i].UpdateMinMaxPoints(axis, 1);
-				cubes[i].UpdateCenter();
+				move_queue_.Push(turns[i] / 4, turns[i] % 4);
+				history_.Record(turns[i] / 4, turns[i] % 4);
 			}
-		}
+		});
+	}
+	else
+	{
+		int layer = result.turns[0] / 4;
+		int quarter_turns = result.turns[0] % 4;
+		const WCHAR* angles[4] = { L"0", L"+90", L"180", L"-90" };
 
-		ResetLayerIds();
+		swprintf(hint_text_, 128, L"Next turn: %c layer %d %s degrees, %d turns to solve",
+			L'X' + layer / kNumLayers, layer % kNumLayers + 1, angles[quarter_turns], (int)result.turns.size());
 	}
 
-	// Release other rotations
-	rotate_finish_ = true ;
+	frame_scheduler_.Invalidate();
+}
+
+bool RubikCube::IsSettled()
+{
+	snapshots_.Update();
+
+	const CubeSnapshot& snapshot = snapshots_.GetFront();
+	return !snapshot.animating && snapshot.num_commands == posted_commands_;
+}
+
+/*
+Each tick runs the queued turns up to time, then the instances of the cubes are copied to the back
+buffer and published, the message thread is woken by WM_SNAPSHOT to draw them. Only one
+WM_SNAPSHOT is in the message queue at a time, the frame draws the latest snapshot anyway.
+*/
+bool RubikCube::Tick(double time)
+{
+	move_queue_.Update(time, this);
+
+	int first_rotating_layer = mouse_rotating_layer_;
+	int last_rotating_layer  = mouse_rotating_layer_;
+	if (mouse_rotating_layer_ < 0)
+		move_queue_.GetRotatingLayers(&first_rotating_layer, &last_rotating_layer);
+
+	bool animating = !move_queue_.IsIdle();
+
+	CubeSnapshot& snapshot = snapshots_.GetBack();
+	Cube::GetInstances(cubes, transforms_, kNumLayers, first_rotating_layer, last_rotating_layer, &snapshot.instances);
+	snapshot.animating = animating;
+	snapshot.num_commands = executed_commands_;
+	snapshots_.Publish();
+
+	if (!snapshot_posted_.exchange(true))
+		PostMessage(hWnd_, WM_SNAPSHOT, 0, 0);
+
+	return animating;
+}
+
+void RubikCube::OnMoveStep(int layer, const Quaternion& rotation)
+{
+	transforms_.RotateLayer(layer, rotation);
+}
+
+// The other turns of the group are around the same axis, so they still find their cubes
+void RubikCube::OnMoveEnd(int layer, const Vector3& axis, int quarter_turns)
+{
+	transforms_.SnapLayer(layer);
 }
 
 // Restore Rubik Cube,make it in complete state
 void RubikCube::Restore()
 {
-	InitCubes();
-	ResetLayerIds();
+	PostTurnCommand([this]()
+	{
+		move_queue_.Clear();
+		history_.Clear();
+		InitCubes();
+	});
+}
+
+// The turns are recorded when they are queued, so undo and redo step the history at once and animate behind it
+void RubikCube::Undo()
+{
+	if(!rotate_finish_)
+		return ;
+
+	PostTurnCommand([this]()
+	{
+		int layer, quarter_turns;
+		if (history_.Undo(&layer, &quarter_turns))
+			move_queue_.Push(layer, quarter_turns);
+	});
+}
+
+void RubikCube::Redo()
+{
+	if(!rotate_finish_)
+		return ;
+
+	PostTurnCommand([this]()
+	{
+		int layer, quarter_turns;
+		if (history_.Redo(&layer, &quarter_turns))
+			move_queue_.Push(layer, quarter_turns);
+	});
+}
+
+// The queued turns are dropped half way, the placement puts every cube back on the grid
+void RubikCube::SeekHistory(int position)
+{
+	if(!rotate_finish_)
+		return ;
+
+	PostTurnCommand([this, position]()
+	{
+		move_queue_.Clear();
+		history_.Seek(position);
+		transforms_.SetPlacement(history_.GetPlacement());
+	});
+}
+
+/*
+The placement is the history's, so the turns still queued are saved as done. The files are
+written by the simulation thread, which owns the history, the view is taken here.
+*/
+void RubikCube::SavePuzzle()
+{
+	Camera* camera = d3d9->GetCamera();
+
+	PuzzleView view;
+	view.camera_radius = camera->GetRadius();
+	view.view_rotation = camera->GetViewRotation();
+
+	PostCommand([this, view]()
+	{
+		PuzzleFile::Save("RubikCube.puzzle", history_.GetPlacement(), view);
+		PuzzleFile::SaveText("RubikCube.puzzle.txt", history_.GetPlacement(), view);
+	});
+}
+
+bool RubikCube::LoadPuzzle(const char* file_name)
+{
+	if(!rotate_finish_)
+		return false;
+
+	CubePlacement placement(kNumLayers);
+	if (!OpenPuzzle(file_name, &placement))
+		return false;
+
+	PostTurnCommand([this, placement]()
+	{
+		move_queue_.Clear();
+		history_.Clear(placement);
+		transforms_.SetPlacement(placement);
+	});
+
+	return true;
+}
+
+// Read the placement and set the view of a puzzle file, which must have the layers of this Rubik Cube
+bool RubikCube::OpenPuzzle(const char* file_name, CubePlacement* placement)
+{
+	PuzzleFile file;
+	if (!file.Open(file_name) || file.GetNumLayers() != kNumLayers)
+		return false;
+
+	placement->Unpack(file.GetPlacement());
+
+	Camera* camera = d3d9->GetCamera();
+	camera->SetRadius(file.GetView().camera_radius);
+	camera->SetViewRotation(file.GetView().view_rotation);
+	frame_scheduler_.Invalidate();
+
+	return true;
 }
 
 // Switch from window mode and full-screen mode
@@ -363,6 +738,7 @@ void RubikCube::ToggleFullScreen()
 
 	// Display mode changed, we need to reset device
 	d3d9->ResetDevice() ;
+	frame_scheduler_.Invalidate();
 }
 
 void RubikCube::OnLeftButtonDown(int x, int y)
@@ -371,38 +747,35 @@ void RubikCube::OnLeftButtonDown(int x, int y)
 		return ;
 	rotate_finish_ = false ; // Prevent the other rotation during this rotate
 
-	// Clear total angle
+	// Clear total angle and the layer of the last drag, a press which starts no drag turns nothing
 	total_rotate_angle_ = 0;
+	hit_layer_ = -1;
+
+	// The queued turns are animating, no rotation by mouse until they finish
+	if(!IsSettled())
+		return ;
 
 	Ray ray = d3d9->CalculatePickingRay(x, y) ;
 
 	previous_vector_ = d3d9->ScreenToVector3(x, y);
 
-	D3DXVECTOR3 currentHitPoint;	// hit point on the face
-	float maxDist = 100000.0f ;
-
-	// Select the face nearest to the camera
-	for(int i = 0; i < kNumFaces; i++)
+	// Select the sticker nearest to the camera, the gaps between the stickers hit nothing
+	PickResult pick;
+	if(picker_.Pick(ray, &pick) && pick.sticker)
 	{
-		if(RayRectIntersection(ray, faces[i], currentHitPoint))
-		{
-			is_hit_ = true ;
-
-			// distance from the origin of the ray and to the hit point
-			float distance = SquareDistance(ray.origin, currentHitPoint);
-
-			if(distance < maxDist)
-			{
-				maxDist = distance ;
-				previous_hitpoint_ = currentHitPoint ;
-			}
-		}
+		is_hit_ = true ;
+		previous_hitpoint_ = pick.point ;
+		for (int i = 0; i < 3; ++i)
+			hit_cell_[i] = pick.cell[i];
 	}
 
 	// no action if the picking ray is not intersection with cube 
 	if(!is_hit_)
 		return ;
 
+	// The drag may turn a layer, a solution arriving meanwhile would be queued behind it
+	CancelSolve();
+
 	// if the ray intersect with either of the two triangles, then it intersect with the rectangle
 	world_arcball_->OnBegin(x, y) ;
 }
@@ -422,7 +795,7 @@ void RubikCube::OnMouseMove(int x, int y)
 	Ray picking_ray = d3d9->CalculatePickingRay(x, y);
 	RayRectIntersection(picking_ray, faces[face], current_hitpoint_);
 
-	D3DXPLANE plane;
+	Plane plane;
 	
 	int layer = -1;
 
@@ -434,7 +807,7 @@ void RubikCube::OnMouseMove(int x, int y)
 		plane = GeneratePlane(face, previous_hitpoint_, current_hitpoint_);
 	
 		rotate_axis_ = GetRotateAxis(face, previous_hitpoint_, current_hitpoint_);
-		hit_layer_ = GetHitLayer(face, rotate_axis_, previous_hitpoint_);
+		hit_layer_ = GetHitLayer(face, rotate_axis_);
 	}
 
 	float angle = CalculateRotateAngle();
@@ -448,7 +821,13 @@ void RubikCube::OnMouseMove(int x, int y)
 	total_rotate_angle_ += angle;
 
 	// Rotate
-	RotateLayer(hit_layer_, rotate_axis_, angle);
+	layer = hit_layer_;
+	Vector3 axis = rotate_axis_;
+	PostCommand([=]() mutable
+	{
+		mouse_rotating_layer_ = layer;
+		RotateLayer(layer, axis, angle);
+	});
 
 	// Update previous_hitpoint_
 	previous_vector_ = current_vector_;
@@ -457,76 +836,77 @@ void RubikCube::OnMouseMove(int x, int y)
 // When Left button up, complete the rotation of the left angle to align the cube and update the layer info
 void RubikCube::OnLeftButtonUp()
 {
+	// Only a drag which selected a layer has a turn to finish, the press may have hit nothing
+	// or have come while queued turns were animating
+	bool dragged = is_hit_ && is_cubes_selected_ && hit_layer_ >= 0;
 	is_hit_ = false ;
+	is_cubes_selected_ = false;
 
 	world_arcball_->OnEnd();
 
+	if (!dragged)
+	{
+		rotate_finish_ = true ;
+		return ;
+	}
+
+	// Turn on to the nearest quarter turn, the layer is snapped to the grid there
 	float left_angle = 0.0f ;	// the angle need to rotate when mouse is up
-	int   num_half_PI = 0;
+	float total_angle = total_rotate_angle_;
 
 	if (total_rotate_angle_ > 0)
 	{
-		while (total_rotate_angle_ >= D3DX_PI / 2)
+		while (total_rotate_angle_ >= kPi / 2)
 		{
-			total_rotate_angle_ -= D3DX_PI / 2;
-			++num_half_PI;
+			total_rotate_angle_ -= kPi / 2;
 		}
 
-		if ((total_rotate_angle_ >= 0) && (total_rotate_angle_ <= D3DX_PI / 4))
+		if ((total_rotate_angle_ >= 0) && (total_rotate_angle_ <= kPi / 4))
 		{
 			left_angle = -total_rotate_angle_;
 		}
 
-		else // ((total_rotate_angle_ > D3DX_PI / 4) && (total_rotate_angle_ < D3DX_PI / 2))
+		else // ((total_rotate_angle_ > kPi / 4) && (total_rotate_angle_ < kPi / 2))
 		{
-			++num_half_PI;
-			left_angle = D3DX_PI / 2 - total_rotate_angle_;
+			left_angle = kPi / 2 - total_rotate_angle_;
 		}
 
 	}
 	else // total_rotate_angle_ < 0
 	{
-		while (total_rotate_angle_ <= -D3DX_PI / 2)
+		while (total_rotate_angle_ <= -kPi / 2)
 		{
-			total_rotate_angle_ += D3DX_PI / 2;
-			--num_half_PI;
+			total_rotate_angle_ += kPi / 2;
 		}
 
-		if ((total_rotate_angle_ >= -D3DX_PI / 4) && (total_rotate_angle_ <= 0))
+		if ((total_rotate_angle_ >= -kPi / 4) && (total_rotate_angle_ <= 0))
 		{
 			left_angle = -total_rotate_angle_;
 		}
 
-		else // ((total_rotate_angle_ > -D3DX_PI / 2) && (total_rotate_angle_ < -D3DX_PI / 4))
+		else // ((total_rotate_angle_ > -kPi / 2) && (total_rotate_angle_ < -kPi / 4))
 		{
-			--num_half_PI;
-			left_angle = -D3DX_PI / 2 - total_rotate_angle_;
+			left_angle = -kPi / 2 - total_rotate_angle_;
 		}
 	}
 
-	RotateLayer(hit_layer_, rotate_axis_, left_angle);
-
-	// Make num_rotate_half_PI > 0, since we will mode 4 later
-	// so add it 4 each time, -1 = 3, -2 = 2, -3 = 1
-	// because - (pi / 2) = 3 * pi /2, -pi / 2 = pi / 2, - 3 * pi / 2 = pi / 2
-	while (num_half_PI < 0)
-		num_half_PI += 4;
-
-	num_half_PI %= 4;
-
-	for (int i = 0; i < kNumCubes; ++i)
+	// The rotate axis is always a positive axis, the whole turn goes to the history
+	int layer = hit_layer_;
+	Vector3 axis = rotate_axis_;
+	int quarter_turns = (int)floorf((total_angle + left_angle) / (kPi / 2) + 0.5f);
+	std::function<void()> command = [=]() mutable
 	{
-		if (cubes[i].InLayer(hit_layer_))
-		{
-			cubes[i].UpdateMinMaxPoints(rotate_axis_, num_half_PI);
-			cubes[i].UpdateCenter();
-		}
-	}
-
-	ResetLayerIds();
+		RotateLayer(layer, axis, left_angle);
+		transforms_.SnapLayer(layer);
+		mouse_rotating_layer_ = -1;
+		history_.Record(layer, quarter_turns);
+	};
 
-	// When mouse up, one rotation was finished, no cube was selected
-	is_cubes_selected_ = false;
+	// A drag which ends where it started is no move, the solve and the hint stay
+	if (quarter_turns % 4 != 0)
+		PostTurnCommand(command);
+	else
+		PostCommand(command);
 
 	// Enable next rotation.
 	rotate_finish_ = true ;
@@ -542,6 +922,9 @@ LRESULT RubikCube::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lP
 	case WM_ACTIVATE:
 		if(LOWORD(wParam) == WA_INACTIVE)
 			window_active_ = false ;
+		else if(HIWORD(wParam) == 0) // Activated and not minimized
+			window_active_ = true ;
+		frame_scheduler_.Invalidate();
 		break ;
 
 	case WM_LBUTTONDOWN:
@@ -551,6 +934,7 @@ LRESULT RubikCube::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lP
 			SetCapture(hWnd) ;
 			int iMouseX = ( short )LOWORD( lParam );
 			int iMouseY = ( short )HIWORD( lParam );
+			mouse_input_.OnButtonDown(iMouseX, iMouseY);
 			OnLeftButtonDown(iMouseX, iMouseY);
 		}
 		break ;
@@ -562,6 +946,9 @@ LRESULT RubikCube::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lP
 
 	case WM_LBUTTONUP:
 		{
+			// The last moves turn the layer before it is aligned
+			ProcessMouseMove();
+			mouse_input_.OnButtonUp();
 			OnLeftButtonUp();
 			ReleaseCapture();
 		}
@@ -571,14 +958,37 @@ LRESULT RubikCube::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lP
 		{
 			int iMouseX = ( short )LOWORD( lParam );
 			int iMouseY = ( short )HIWORD( lParam );
-			OnMouseMove(iMouseX, iMouseY) ;
+			mouse_input_.OnMouseMove(iMouseX, iMouseY) ;
+
+			// Only a drag on the cube needs a frame
+			if (is_hit_)
+				frame_scheduler_.Invalidate();
 		}
 		break ;
 
+	case WM_INPUT:
+		mouse_input_.OnRawInput(lParam);
+		if (is_hit_)
+			frame_scheduler_.Invalidate();
+		break ;
+
 	case WM_PAINT: 
 		Render();
 		break ;
 
+	case WM_SNAPSHOT:
+		snapshot_posted_ = false;
+		frame_scheduler_.Invalidate();
+		return 0;
+
+	case WM_ATLAS_READY:
+		OnAtlasReady();
+		return 0;
+
+	case WM_SOLUTION:
+		OnSolution();
+		return 0;
+
 	case WM_KEYDOWN:
 		{
 			switch( wParam )
@@ -589,9 +999,50 @@ LRESULT RubikCube::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lP
 			case 'S':
 				Shuffle();
 				break;
+			case 'Z':
+				Undo();
+				break;
+			case 'Y':
+				Redo();
+				break;
+			case 'H': // Show the next turn of a solution
+				RequestSolve(false);
+				break;
+			case 'G': // Animate a whole solution
+				RequestSolve(true);
+				break;
+			case VK_F2:
+				SavePuzzle();
+				break;
+			case VK_F3:
+				LoadPuzzle("RubikCube.puzzle");
+				break;
+			case VK_HOME: // Back to the solved cube at the start of the history
+				SeekHistory(0);
+				break;
+			case VK_END:
+				SeekHistory(INT_MAX);
+				break;
 			case 'F':
 				ToggleFullScreen() ;
 				break;
+			case 'P':
+				show_profiler_ = !show_profiler_;
+				frame_scheduler_.Invalidate();
+				break;
+			case 'E':
+				ExportProfile();
+				break;
+			case 'B': // Record the draws of the next frame, the benchmarks run with -benchmark
+				record_frame_ = true;
+				frame_scheduler_.Invalidate();
+				break;
+			case VK_SPACE: // Finish the queued turns at once
+				PostCommand([this]()
+				{
+					move_queue_.FastForward(this);
+				});
+				break;
 			case VK_ESCAPE:
 				SendMessage(hWnd, WM_CLOSE, 0, 0);
 				break ;
@@ -603,6 +1054,8 @@ LRESULT RubikCube::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lP
 
 	case WM_SIZE: // why not use WM_EXITSIZEMOVE?
 		{
+			frame_scheduler_.Invalidate();
+
 			// inactive the app when window is minimized
 			if(wParam == SIZE_MINIMIZED)
 				window_active_ = false ;
@@ -667,7 +1120,7 @@ LRESULT RubikCube::HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lP
 
 void RubikCube::InitTextures()
 {
-	DWORD colors[] = 
+	unsigned int colors[] = 
 	{
 		0xffffffff, // White,   front face
 		0xffffff00, // Yellow,	back face
@@ -677,73 +1130,74 @@ void RubikCube::InitTextures()
 		0xff0000ff, // Blue,	bottom face
 	};
 
-	// Create face textures
-	for(int i = 0; i < kNumFaces; ++i)
+	// One sticker atlas for all faces, the face color is applied as the instance color.
+	// The first frames use a placeholder atlas with small tiles, its border is scaled down with the tiles.
+	int placeholder_border = max(1, kAtlasBorderWidth * kPlaceholderTileSize / texture_width_);
+
+	StickerAtlas placeholder;
+	placeholder.Generate(kPlaceholderTileSize, kPlaceholderTileSize, placeholder_border, kAtlasBorderColor);
+	sticker_texture_ = d3d9->GetRenderDevice()->CreateTexture(placeholder.GetWidth(), placeholder.GetHeight(), placeholder.GetPixels());
+
+	// The tile rectangles are those of the full atlas, it has the same layout, so the rectangles in
+	// the instances stay valid when it replaces the placeholder
+	float sticker_rect[4];
+	float inner_rect[4];
+	StickerAtlas::GetTileRect(StickerAtlas::kStickerTile, texture_width_, texture_height_, sticker_rect);
+	StickerAtlas::GetTileRect(StickerAtlas::kInnerTile, texture_width_, texture_height_, inner_rect);
+
+	Cube::SetStickerTexture(sticker_texture_, sticker_rect, inner_rect);
+	Cube::SetFaceColors(colors, kNumFaces);
+	Cube::SetInnerColor(0xff121212);
+
+	// The full atlas is loaded from the cache file, it is generated and cached again when the file
+	// is missing or was generated with other parameters.
+	full_atlas_ = new StickerAtlas();
+	int tile_width = texture_width_;
+	int tile_height = texture_height_;
+	atlas_thread_ = std::thread([this, tile_width, tile_height]()
 	{
-		face_textures_[i] = d3d9->CreateTexture(texture_width_, texture_height_, colors[i]);
-	}
+		double start_time = startup_profiler_.GetTime();
 
-	// Create inner texture
-	inner_textures_ = d3d9->CreateInnerTexture(texture_width_, texture_height_, 0xffffffff);
+		if (!full_atlas_->Load(kAtlasFile, tile_width, tile_height, kAtlasBorderWidth, kAtlasBorderColor))
+		{
+			full_atlas_->Generate(tile_width, tile_height, kAtlasBorderWidth, kAtlasBorderColor);
+			full_atlas_->Save(kAtlasFile);
+		}
 
-	Cube::SetFaceTexture(face_textures_, kNumFaces);
-	Cube::SetInnerTexture(inner_textures_);
+		startup_profiler_.RecordPhase(kStartupStickerAtlas, start_time, startup_profiler_.GetTime());
+		PostMessage(hWnd_, WM_ATLAS_READY, 0, 0);
+	});
 }
 
-void RubikCube::InitCubes()
+// The full atlas replaces the placeholder, the device calls are made here on the message thread
+void RubikCube::OnAtlasReady()
 {
-	// Set device for unit cubes
-	for (int i = 0; i < kNumCubes; ++i)
-	{
-		cubes[i].SetDevice(d3d9->GetD3DDevice());
-	}
+	if (!atlas_thread_.joinable())
+		return;
+	atlas_thread_.join();
 
-	// Get unit cube length and gaps between layers
-	float cube_length = cubes[0].GetLength();
-	float gap = gap_between_layers_;
+	RenderDevice* render_device = d3d9->GetRenderDevice();
+	TextureHandle texture = render_device->CreateTexture(full_atlas_->GetWidth(), full_atlas_->GetHeight(), full_atlas_->GetPixels());
+	Cube::SetStickerTexture(texture);
+	render_device->ReleaseTexture(sticker_texture_);
+	sticker_texture_ = texture;
 
-	// Calculate half face length
-	float half_face_length = face_length_ / 2;
+	delete full_atlas_;
+	full_atlas_ = NULL;
 
-	/* Initialize the top-front-left corner of each unit cubes, we use (kNumLayers)^3 unit cubes
-	   to build up a Rubik Cube
+	frame_scheduler_.Invalidate();
+}
 
+void RubikCube::InitCubes()
+{
+	/* All unit cubes back to their initial position, not rotated
 	   The Cube was labeled by the following rule, suppose a 3 x 3 x 3 Rubik Cube
 	   front layer		middle layer      back layer
 	   6   7   8		15  16  17		  24  25  26
 	   3   4   5 		12  13  14		  21  22  23
 	   0   1   2		 9  10  11		  18  19  20
 	*/
-	for (int i = 0; i < kNumLayers; ++i)
-	{
-		for (int j = 0; j < kNumLayers; ++j)
-		{
-			for (int k = 0; k < kNumLayers; ++k)
-			{
-				// calculate the front-bottom-left corner coodinates for current cube
-				// The Rubik Cube's center was the coordinate center, but the calculation assume the front-bottom-left corner
-				// of the Rubik Cube was in the coodinates center, so move half_face_length for each coordinates component.
-				float x = i * (cube_length + gap) - half_face_length;
-				float y = j * (cube_length + gap) - half_face_length;
-				float z = k * (cube_length + gap) - half_face_length;
-
-				// calculate the unit cube index in inti_pos
-				int n = i + (j * kNumLayers) + (k * kNumLayers * kNumLayers);
-
-				// Initiliaze cube n
-				cubes[n].Init(D3DXVECTOR3(x, y, z));
-			}
-		}
-	}
-
-	// Reset world matrix to Identity matrix for each unit cube
-	D3DXMATRIX world_matrix;
-	D3DXMatrixIdentity(&world_matrix);
-
-	for (int i = 0; i < kNumCubes; ++i)
-	{
-		cubes[i].SetWorldMatrix(world_matrix);
-	}
+	transforms_.Reset();
 }
 
 int RubikCube::GetWindowPosX() const
@@ -772,7 +1226,7 @@ is cube_length, and the gap length between two layers is gaps, and the Rubik cub
 then, if the left face was picked, then, x == -(1.5 * cube_length + gaps), if the top face was picked, then 
 y == 1.5 * length + gaps
 */
-Face RubikCube::GetPickedFace(D3DXVECTOR3 hit_point) const
+Face RubikCube::GetPickedFace(Vector3 hit_point) const
 {
 	float float_epsilon = 0.001f;
 	float cube_length = cubes[0].GetLength();
@@ -789,7 +1243,7 @@ Face RubikCube::GetPickedFace(D3DXVECTOR3 hit_point) const
 	return kUnknownFace;
 }
 
-D3DXPLANE RubikCube::GeneratePlane(Face face, D3DXVECTOR3& previous_point, D3DXVECTOR3& current_point)
+Plane RubikCube::GeneratePlane(Face face, Vector3& previous_point, Vector3& current_point)
 {
 	float abs_diff_x = fabs(previous_point.x - current_point.x);
 	float abs_diff_y = fabs(previous_point.y - current_point.y);
@@ -800,33 +1254,33 @@ D3DXPLANE RubikCube::GeneratePlane(Face face, D3DXVECTOR3& previous_point, D3DXV
 	case kFrontFace:
 	case kBackFace:
 		if (abs_diff_x < abs_diff_y)
-			return D3DXPLANE(1, 0, 0, -previous_point.x);
+			return Plane(1, 0, 0, -previous_point.x);
 		else
-			return D3DXPLANE(0, 1, 0, -previous_point.y);
+			return Plane(0, 1, 0, -previous_point.y);
 		break;
 
 	case kLeftFace:
 	case kRightFace:
 		if (abs_diff_y < abs_diff_z)
-			return D3DXPLANE(0, 1, 0, -previous_point.y);
+			return Plane(0, 1, 0, -previous_point.y);
 		else
-			return D3DXPLANE(0, 0, 1, -previous_point.z);
+			return Plane(0, 0, 1, -previous_point.z);
 		break;
 
 	case kTopFace:
 	case kBottomFace:
 		if (abs_diff_x < abs_diff_z)
-			return D3DXPLANE(1, 0, 0, -previous_point.x);
+			return Plane(1, 0, 0, -previous_point.x);
 		else
-			return D3DXPLANE(0, 0, 1, -previous_point.z);
+			return Plane(0, 0, 1, -previous_point.z);
 		break;
 
 	default:
-		return D3DXPLANE(0, 0, 0, 0);
+		return Plane(0, 0, 0, 0);
 	}
 }
 
-D3DXVECTOR3 RubikCube::GetRotateAxis(Face face, D3DXVECTOR3& previous_point, D3DXVECTOR3& current_point)
+Vector3 RubikCube::GetRotateAxis(Face face, Vector3& previous_point, Vector3& current_point)
 {
 	float abs_diff_x = fabs(previous_point.x - current_point.x);
 	float abs_diff_y = fabs(previous_point.y - current_point.y);
@@ -837,33 +1291,33 @@ D3DXVECTOR3 RubikCube::GetRotateAxis(Face face, D3DXVECTOR3& previous_point, D3D
 	case kFrontFace:
 	case kBackFace:
 		if (abs_diff_x < abs_diff_y)
-			return D3DXVECTOR3(1, 0, 0);
+			return Vector3(1, 0, 0);
 		else
-			return D3DXVECTOR3(0, 1, 0);
+			return Vector3(0, 1, 0);
 		break;
 
 	case kLeftFace:
 	case kRightFace:
 		if (abs_diff_y < abs_diff_z)
-			return D3DXVECTOR3(0, 1, 0);
+			return Vector3(0, 1, 0);
 		else
-			return D3DXVECTOR3(0, 0, 1);
+			return Vector3(0, 0, 1);
 		break;
 
 	case kTopFace:
 	case kBottomFace:
 		if (abs_diff_x < abs_diff_z)
-			return D3DXVECTOR3(1, 0, 0);
+			return Vector3(1, 0, 0);
 		else
-			return D3DXVECTOR3(0, 0, 1);
+			return Vector3(0, 0, 1);
 		break;
 
 	default:
-		return D3DXVECTOR3(0, 0, 0);
+		return Vector3(0, 0, 0);
 	}
 }
 
-RotateDirection RubikCube::GetRotateDirection(Face face, D3DXVECTOR3& axis, D3DXVECTOR3& previous_vector, D3DXVECTOR3& current_vector)
+RotateDirection RubikCube::GetRotateDirection(Face face, Vector3& axis, Vector3& previous_vector, Vector3& current_vector)
 {
 	float delta_x = previous_vector.x - current_vector.x;
 	float delta_y = previous_vector.y - current_vector.y;
@@ -962,7 +1416,7 @@ RotateDirection RubikCube::GetRotateDirection(Face face, D3DXVECTOR3& axis, D3DX
 float RubikCube::CalculateRotateAngle()
 {
 	// Get the rotation increment
-	D3DXQUATERNION quat = world_arcball_->GetRotationQuatIncreament();
+	Quaternion quat = world_arcball_->GetRotationQuatIncreament();
 
 	//extract rotation angle from quaternion
 	float angle = 2.0f * acosf(quat.w) * rotate_speed_ ;
@@ -970,87 +1424,27 @@ float RubikCube::CalculateRotateAngle()
 	return angle;
 }
 
-int  RubikCube::GetHitLayer(Face face, D3DXVECTOR3& rotate_axis, D3DXVECTOR3& hit_point)
+// The layer of the picked cubie around the rotate axis, no layer if the axis is the normal of the picked face
+int  RubikCube::GetHitLayer(Face face, Vector3& rotate_axis)
 {
-	float length = cubes[0].GetLength();
-	float gap    = gap_between_layers_;
-
-	float half_face_length = face_length_ / 2;
-	float float_epsilon = 0.0001f; 
-
-	// X-Axis 
+	int axis = 2;
 	if (rotate_axis.x != 0)
-	{
-		switch (face)
-		{
-		case kFrontFace:
-		case kBackFace:
-		case kTopFace:
-		case kBottomFace:
-			{
-				for (int i = 0; i < kNumLayers; ++i)
-				{
-					if (hit_point.x + half_face_length >= i * (length + gap) 
-					    && hit_point.x + half_face_length <= (i + 1) * (length + gap) - gap)
-						return i;
-				}
-			}
-		break;
-		}
-	}
-
-	// Y-Axis
+		axis = 0;
 	else if (rotate_axis.y != 0)
-	{
-		switch (face)
-		{
-		case kLeftFace:
-		case kRightFace:
-		case kFrontFace:
-		case kBackFace:
-			{
-				for (int i = 0; i < kNumLayers; ++i)
-				{
-					if (hit_point.y + half_face_length >= i * (length + gap)
-						&& hit_point.y + half_face_length <= (i + 1) * (length + gap) - gap)
-						return i + kNumLayers;
-				}
-			}
-		break;
-		}
-	}
+		axis = 1;
 
-	// Z-Axis
-	else 
-	{
-		switch (face)
-		{
-		case kLeftFace:
-		case kRightFace:
-		case kTopFace:
-		case kBottomFace:
-			{
-				for (int i = 0; i < kNumLayers; ++i)
-				{
-					if (hit_point.z + half_face_length >= i * (length + gap)
-						&& hit_point.z + half_face_length <= (i + 1) * (length + gap) - gap)
-						return i + 2 * kNumLayers;
-				}
-			}
-			break;
-		}
-	}
+	// Front and back faces are along Z, left and right along X, top and bottom along Y
+	int face_axis = face <= kBackFace ? 2 : (face <= kRightFace ? 0 : 1);
+	if (face == kUnknownFace || axis == face_axis)
+		return -1;
 
-	return -1;
+	return hit_cell_[axis] + axis * kNumLayers;
 }
 
-void RubikCube::RotateLayer(int layer, D3DXVECTOR3& axis, float angle)
+void RubikCube::RotateLayer(int layer, Vector3& axis, float angle)
 {
-	for(int i = 0; i < kNumCubes; ++i)
-	{
-		if (cubes[i].InLayer(layer))
-		{
-			cubes[i].Rotate(axis, angle);
-		}
-	}
+	Quaternion rotation;
+	QuaternionRotationAxis(&rotation, &axis, angle);
+
+	transforms_.RotateLayer(layer, rotation);
 }
@@ -1,10 +1,24 @@
 #ifndef __RUBIK_CUBE_H__
 #define __RUBIK_CUBE_H__
 
+#include "Arena.h"
 #include "Cube.h"
 #include "Camera.h"
 #include "D3D9.h"
+#include "FrameProfiler.h"
+#include "FrameScheduler.h"
+#include "GridPicker.h"
+#include "MouseInput.h"
+#include "MoveHistory.h"
+#include "MoveQueue.h"
+#include "PuzzleFile.h"
 #include "Math.h"
+#include "SimulationThread.h"
+#include "Solver.h"
+#include "StartupProfiler.h"
+#include "StickerAtlas.h"
+#include "TripleBuffer.h"
+#include <thread>
 
 // The 6 faces of the Rubik Cube
 enum Face
@@ -27,43 +41,78 @@ enum RotateDirection
 	kUnknownDirection = 2
 };
 
-class RubikCube
+// The cubes as the simulation thread left them after a tick, drawn by the render thread
+struct CubeSnapshot
+{
+	std::vector<InstanceData> instances;	// Built by Cube::GetInstances
+	bool animating;							// Queued turns were still running
+	int num_commands;						// Number of posted commands run before the snapshot
+};
+
+class RubikCube : public MoveListener, public Simulation
 {
 public:
 	RubikCube(void);
 	~RubikCube(void);
 
-	void Initialize(HWND hWnd);
+	void Initialize(HWND hWnd, const char* puzzle_file = NULL);	// Start from a saved puzzle if the file is given
 	void Render();
+	DWORD GetRenderWaitTime();		// Milliseconds to wait for messages before the next Render, INFINITE if nothing changed
+	void SetTargetFps(int fps);		// Frame rate limit, 0 for no limit
+	bool EnableRawInput();			// Drag with the raw mouse deltas, return false if not available
 	LRESULT HandleMessages(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 	int GetWindowPosX() const;
 	int GetWindowPosY() const;
 	int GetWindowWidth() const;
 	int GetWindowHeight() const;
 
+	// MoveListener, the turns of the move queue
+	void OnMoveStep(int layer, const Quaternion& rotation);
+	void OnMoveEnd(int layer, const Vector3& axis, int quarter_turns);
+
+	// Simulation, run the queued turns and publish a snapshot of the cubes
+	bool Tick(double time);
+
 private:
 	void Shuffle();
 	void Restore(); 
+	void Undo();					// Animate the last turn backward
+	void Redo();
+	void SeekHistory(int position);	// Jump to a point of the history at once, clamped to its ends
+	void SavePuzzle();				// Write RubikCube.puzzle and its text form RubikCube.puzzle.txt
+	bool LoadPuzzle(const char* file_name);	// Either form, false if it is not a puzzle of this size
 	void ToggleFullScreen();
+	void DrawProfilerOverlay();
+	bool OpenPuzzle(const char* file_name, CubePlacement* placement);
+	void OnAtlasReady();			// The full sticker atlas was made by atlas_thread_
+	void ExportProfile();		// Write the profiled frames to FrameProfile.csv and FrameProfile.json, the startup to StartupProfile.csv
+	void PostCommand(const std::function<void()>& command);		// Change the cubes on the simulation thread
+	void PostTurnCommand(const std::function<void()>& command);	// A command which turns layers, cancels the solve
+	void CancelSolve();			// Makes the hint and a running solve out of date
+	void RequestSolve(bool animate);	// Solve in the background, then show the next turn or animate all turns
+	void OnSolution();
+	bool IsSettled();			// All posted commands ran and no turn is animating
+	void ProcessMouseMove();	// Handle the mouse moves collected since the last frame as one move
 	void OnLeftButtonDown(int x, int y);
 	void OnMouseMove(int x, int y);
 	void OnLeftButtonUp();
 	void InitTextures();
 	void InitCubes();
-	void ResetLayerIds();
 	void ResetTextures();
-	Face GetPickedFace(D3DXVECTOR3 hit_point) const;	// Get the face picking by mouse 
-	D3DXPLANE GeneratePlane(Face face, D3DXVECTOR3& previous_point, D3DXVECTOR3& current_point);
-	D3DXVECTOR3 GetRotateAxis(Face face, D3DXVECTOR3& previous_point, D3DXVECTOR3& current_point);
+	Face GetPickedFace(Vector3 hit_point) const;	// Get the face picking by mouse 
+	Plane GeneratePlane(Face face, Vector3& previous_point, Vector3& current_point);
+	Vector3 GetRotateAxis(Face face, Vector3& previous_point, Vector3& current_point);
 	float CalculateRotateAngle();
-	RotateDirection GetRotateDirection(Face face, D3DXVECTOR3& axis, D3DXVECTOR3& previous_vector, D3DXVECTOR3& current_vector);
-	int  GetHitLayer(Face face, D3DXVECTOR3& rotate_axis, D3DXVECTOR3& hit_point);
-	void RotateLayer(int layer, D3DXVECTOR3& axis, float angle);
+	RotateDirection GetRotateDirection(Face face, Vector3& axis, Vector3& previous_vector, Vector3& current_vector);
+	int  GetHitLayer(Face face, Vector3& rotate_axis);
+	void RotateLayer(int layer, Vector3& axis, float angle);
 
 private:
 	const int kNumLayers;	// Number of layers in one direction, a 3 x 3 Rubik Cube has num_layers_ = 3.
 	const int kNumCubes;	// Number of unit cubes, 27 unit cubes build up a rubik cube.
+	Arena puzzle_arena_;	// Holds the cubes, faces, texture ids and transforms for the lifetime of the puzzle
 	Cube* cubes;			// Array to store 27 unit cubes
+	CubeTransforms transforms_;	// Positions and orientations of the unit cubes
 
 	const int kNumFaces;		// Number of faces
 	Rect* faces;				// Store faces in rect
@@ -73,19 +122,21 @@ private:
 
 	bool is_hit_;				// The picking ray hit the RubikCube
 	int  hit_layer_;			// The layer hit by the picking Ray
+	int  hit_cell_[3];			// Grid position of the cubie hit by the picking ray
+	GridPicker picker_;			// Picks the cubies by walking the grid along the picking ray
 	bool rotate_finish_;		// A rotaton action was finished.
 	bool is_cubes_selected_;	// Does cubes selected in current rotation?
 	bool window_active_;		// Window was inactive? turn when device lost, window minimized...
 
-	D3DXVECTOR3 previous_hitpoint_;
-	D3DXVECTOR3 current_hitpoint_;
+	Vector3 previous_hitpoint_;
+	Vector3 current_hitpoint_;
 
-	D3DXVECTOR3 current_vector_;		// Current hit point
-	D3DXVECTOR3 previous_vector_;		// Last hit point
+	Vector3 current_vector_;		// Current hit point
+	Vector3 previous_vector_;		// Last hit point
 
 	float rotate_speed_;				// layer rotation speed
 	float total_rotate_angle_;			// The angle rotated when mouse up
-	D3DXVECTOR3 rotate_axis_;			// Rotate axis, X or Y or Z
+	Vector3 rotate_axis_;			// Rotate axis, X or Y or Z
 	RotateDirection rotate_direction_;	// Rotate direction
 
 
@@ -110,11 +161,37 @@ private:
 	int current_window_height_;
 
 	// Textures
-	int texture_width_;						// Texture width in pixel.
-	int texture_height_;					// Texture height in pixel.
+	int texture_width_;						// Width of a sticker atlas tile in pixel.
+	int texture_height_;					// Height of a sticker atlas tile in pixel.
 	int* texture_id_;						// The index is the faceId, the value is the texture_id_.
-	IDirect3DTexture9**	face_textures_;		// Face textures
-	IDirect3DTexture9*	inner_textures_;	// Inner face texture.
+	TextureHandle	sticker_texture_;		// Sticker atlas shared by all faces, colored by the face color
+	StickerAtlas* full_atlas_;				// Made by atlas_thread_, replaces the placeholder atlas when ready
+	std::thread atlas_thread_;
+
+	DrawList draw_list_;					// Draws of the current frame
+	FrameScheduler frame_scheduler_;		// Draw a frame only when the scene changed
+	FrameProfiler profiler_;				// Phase times of the recent frames
+	StartupProfiler startup_profiler_;		// Phase times from the start to the first frame
+	bool show_profiler_;					// Draw the profiler overlay, toggled by P
+	bool record_frame_;						// Write the draws of the next frame to FrameRecording.txt, set by B
+	MoveQueue move_queue_;					// Animated turns of Shuffle
+	MoveHistory history_;					// Committed turns for undo and redo, used by the simulation thread only
+	MouseInput mouse_input_;				// Left button drag, the moves are handled once per frame
+
+	// The cubes and the move queue are changed only on the simulation thread, by posted commands,
+	// the message thread draws the latest snapshot of them.
+	SimulationThread simulation_;
+	TripleBuffer<CubeSnapshot> snapshots_;
+	int posted_commands_;					// Commands posted by the message thread
+	int executed_commands_;					// Commands run by the simulation thread
+	int mouse_rotating_layer_;				// Layer rotated by the mouse, -1 if none, simulation thread
+	std::atomic<bool> snapshot_posted_;		// A snapshot message is waiting in the message queue
+
+	// Hint and solve, the solver thread solves the history of the simulation thread
+	Solver solver_;
+	int solve_requests_;					// Numbers the solves and the turns which make them out of date, message thread
+	bool solve_animate_;					// The requested solve is animated rather than shown as a hint
+	WCHAR hint_text_[128];					// Drawn at the bottom of the window, empty if none
 
 	D3D9* d3d9;								// Objects from other classes
 };
@@ -0,0 +1,119 @@
+#include "SimulationThread.h"
+
+#include <chrono>
+
+SimulationThread::SimulationThread(void)
+	: simulation_(NULL),
+	  tick_time_(0),
+	  quit_(false)
+{
+	QueryPerformanceFrequency(&frequency_);
+}
+
+SimulationThread::~SimulationThread(void)
+{
+	Stop();
+}
+
+void SimulationThread::Start(Simulation* simulation, double tick_time)
+{
+	Stop();
+
+	simulation_ = simulation;
+	tick_time_  = tick_time;
+	quit_       = false;
+	thread_ = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop()
+{
+	if (!thread_.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+		commands_.clear();
+	}
+	condition_.notify_one();
+
+	thread_.join();
+}
+
+void SimulationThread::Post(const std::function<void()>& command)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		commands_.push_back(command);
+	}
+	condition_.notify_one();
+}
+
+/*
+While the model is busy the thread wakes at every tick, runs the commands posted since the last
+tick, then advances the model by whole ticks up to the current time. While it is idle the thread
+sleeps until a command is posted and restarts the tick clock from then.
+*/
+void SimulationThread::Run()
+{
+	std::vector<std::function<void()> > commands;
+	double next_tick = GetTime();
+	bool busy = true;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+
+			if (busy)
+			{
+				double wait_time = next_tick - GetTime();
+				if (wait_time > 0 && !quit_)
+					condition_.wait_for(lock, std::chrono::microseconds((long long)(wait_time * 1000)));
+			}
+			else
+			{
+				while (!quit_ && commands_.empty())
+					condition_.wait(lock);
+			}
+
+			if (quit_)
+				return;
+
+			commands.swap(commands_);
+		}
+
+		double now = GetTime();
+		if (!busy)
+			next_tick = now;
+
+		for (size_t i = 0; i < commands.size(); ++i)
+			commands[i]();
+		commands.clear();
+
+		// A command posted while busy wakes the thread before the tick, tick again at the
+		// time of the last tick, so the command shows up at once without advancing the model.
+		if (now < next_tick)
+		{
+			busy = simulation_->Tick(next_tick - tick_time_);
+			continue;
+		}
+
+		int num_ticks = 0;
+		do
+		{
+			busy = simulation_->Tick(next_tick);
+			next_tick += tick_time_;
+		} while (busy && next_tick <= now && ++num_ticks < kMaxCatchUpTicks);
+
+		if (next_tick <= now)
+			next_tick = now + tick_time_;
+	}
+}
+
+double SimulationThread::GetTime() const
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000.0 / frequency_.QuadPart;
+}
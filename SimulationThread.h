@@ -0,0 +1,58 @@
+#ifndef __SIMULATION_THREAD_H__
+#define __SIMULATION_THREAD_H__
+
+#include <windows.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The model advanced by the simulation thread
+class Simulation
+{
+public:
+	virtual ~Simulation(void) {}
+
+	// Advance the model to time(milliseconds, in steps of the tick time), called on the simulation
+	// thread after the posted commands ran. Return true while the model still changes by itself
+	// (an animation), then the next tick follows, otherwise the thread sleeps until the next command.
+	virtual bool Tick(double time) = 0;
+};
+
+// Runs a Simulation on its own thread at a fixed tick, so the model advances by the same
+// steps whatever the frame rate is, and a long operation on the model does not block the
+// message thread. The other threads change the model only through posted commands, which run
+// on the simulation thread in the order they were posted.
+class SimulationThread
+{
+public:
+	SimulationThread(void);
+	~SimulationThread(void);
+
+	void Start(Simulation* simulation, double tick_time);
+	void Stop();	// Wait for the thread to finish, the commands not run yet are dropped
+
+	// Run a command on the simulation thread before the next tick
+	void Post(const std::function<void()>& command);
+
+private:
+	void Run();
+	double GetTime() const;		// Milliseconds from an arbitrary start
+
+private:
+	static const int kMaxCatchUpTicks = 8;	// Ticks run at once after a stall, the rest is dropped
+
+	Simulation* simulation_;
+	double tick_time_;
+
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	std::vector<std::function<void()> > commands_;	// Posted commands, guarded by mutex_
+	bool quit_;
+
+	LARGE_INTEGER frequency_;		// Performance counter ticks per second
+};
+
+#endif // end __SIMULATION_THREAD_H__
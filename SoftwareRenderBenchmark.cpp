@@ -0,0 +1,216 @@
+#include "SoftwareRenderBenchmark.h"
+
+#include <windows.h>
+#include <stdio.h>
+#include <vector>
+
+#include "DrawList.h"
+#include "GeometryPool.h"
+#include "SoftwareRenderDevice.h"
+#include "VectorMath.h"
+
+static const int kNumLayers   = 16;		// Unit cubes per edge of the benchmark cube
+static const int kImageSize   = 1024;	// Width and height of the image in pixels
+static const int kNumFrames   = 10;		// The fastest frame is reported
+static const unsigned int kClearColor = 0xff4f94cd;
+static const unsigned int kInnerColor = 0xff121212;
+
+// Sticker colors in the face order of the unit cube mesh: front, back, left, right, top, bottom
+static const unsigned int kFaceColors[6] = { 0xffffffff, 0xffffff00, 0xffff0000, 0xffffa500, 0xff00ff00, 0xff0000ff };
+
+static double GetTime()
+{
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000.0 / frequency.QuadPart;
+}
+
+// The surface cubes of the cube at rest, each with its stickers only, and the inner box, as Cube::GetInstances builds them
+static void GetCubeInstances(std::vector<InstanceData>* instances)
+{
+	float length = 10.0f;
+	float pitch  = length * 1.15f;
+	float offset = -(kNumLayers - 1) * pitch / 2 - length / 2;
+	float full_rect[4] = { 0, 0, 1, 1 };
+
+	for (int k = 0; k < kNumLayers; ++k)
+	{
+		for (int j = 0; j < kNumLayers; ++j)
+		{
+			for (int i = 0; i < kNumLayers; ++i)
+			{
+				int index[3] = { i, j, k };
+				unsigned int face_mask = 0;
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					// Faces 2 * axis + 0/1 are the low/high side along X(left/right), Y(bottom/top), Z(front/back)
+					int low  = axis == 0 ? 2 : (axis == 1 ? 5 : 0);
+					int high = axis == 0 ? 3 : (axis == 1 ? 4 : 1);
+					if (index[axis] == 0)
+						face_mask |= 1 << low;
+					if (index[axis] == kNumLayers - 1)
+						face_mask |= 1 << high;
+				}
+
+				if (face_mask == 0)
+					continue;
+
+				Matrix scale;
+				Matrix translation;
+				MatrixScaling(&scale, length, length, length);
+				MatrixTranslation(&translation, offset + i * pitch, offset + j * pitch, offset + k * pitch);
+				Matrix world = scale * translation;
+
+				InstanceData instance;
+				memcpy(instance.world, (const float*)world, sizeof(instance.world));
+				for (int face = 0; face < 6; ++face)
+				{
+					instance.colors[face] = face_mask & (1 << face) ? kFaceColors[face] : kInnerColor;
+					memcpy(instance.uv_rects[face], full_rect, sizeof(full_rect));
+				}
+				instance.face_mask = face_mask;
+				instances->push_back(instance);
+			}
+		}
+	}
+
+	// The inner box seen through the gaps
+	float inset = length / 4;
+	float box_size = (kNumLayers - 1) * pitch + length - 2 * inset;
+	Matrix scale;
+	Matrix translation;
+	MatrixScaling(&scale, box_size, box_size, box_size);
+	MatrixTranslation(&translation, offset + inset, offset + inset, offset + inset);
+	Matrix world = scale * translation;
+
+	InstanceData box;
+	memcpy(box.world, (const float*)world, sizeof(box.world));
+	for (int face = 0; face < 6; ++face)
+	{
+		box.colors[face] = kInnerColor;
+		memcpy(box.uv_rects[face], full_rect, sizeof(full_rect));
+	}
+	box.face_mask = kAllQuads;
+	instances->push_back(box);
+}
+
+// Render the frames, return the fastest frame time in milliseconds, the device keeps the last frame
+static double RenderFrames(SoftwareRenderDevice* device, const std::vector<InstanceData>& instances)
+{
+	Mesh meshes[kNumMeshes];
+	if (!GeometryPool::CreateMeshes(device, meshes))
+		return -1;
+
+	float radius = kNumLayers * 11.5f * 2.2f;
+	Vector3 eye(-radius * 0.6f, radius * 0.6f, -radius * 0.8f);
+	Vector3 at(0, 0, 0);
+	Vector3 up(0, 1, 0);
+	Matrix view;
+	Matrix proj;
+	Matrix world;
+	MatrixLookAtLH(&view, &eye, &at, &up);
+	MatrixPerspectiveFovLH(&proj, kPi / 4, 1.0f, 1.0f, radius * 4);
+	MatrixIdentity(&world);
+
+	// The light and material of D3D9::SetupLight
+	Light light =
+	{
+		{ eye.x, eye.y, eye.z },
+		{ 0.6f, 0.6f, 0.6f, 0.6f },
+		{ 1.0f, 1.0f, 1.0f, 1.0f },
+		{ 0.6f, 0.6f, 0.6f, 0.6f },
+		radius * 4,
+		{ 1.0f, 0.0f, 0.0f },
+	};
+	Material material =
+	{
+		{ 1.0f, 1.0f, 1.0f, 0.0f },
+		{ 1.0f, 1.0f, 1.0f, 0.0f },
+		{ 1.0f, 1.0f, 1.0f, 0.0f },
+		{ 0.0f, 0.0f, 0.0f, 0.0f },
+		2.0f,
+	};
+
+	DrawItem item;
+	item.texture = kInvalidHandle;
+	GeometryPool::SetDrawItemMesh(meshes[kUnitCubeMesh], &item);
+	memcpy(item.world, (const float*)world, sizeof(item.world));
+
+	DrawList draw_list;
+	draw_list.AddInstanced(item, &instances[0], (int)instances.size());
+
+	double best_time = 0;
+	for (int frame = 0; frame < kNumFrames; ++frame)
+	{
+		double start = GetTime();
+
+		device->SetTransform(kViewTransform, view);
+		device->SetTransform(kProjectionTransform, proj);
+		device->SetMaterial(material);
+		device->SetLight(0, light);
+		device->Clear(kClearColor);
+		if (device->BeginScene())
+		{
+			draw_list.Submit(device);
+			device->EndScene();
+		}
+		device->Present();
+
+		double time = GetTime() - start;
+		best_time = frame == 0 ? time : min(best_time, time);
+	}
+
+	GeometryPool::ReleaseMeshes(device, meshes);
+	return best_time;
+}
+
+bool RunSoftwareRenderBenchmark(const char* file_name)
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	std::vector<InstanceData> instances;
+	GetCubeInstances(&instances);
+
+	SoftwareRenderDevice single_thread(kImageSize, kImageSize, 1);
+	SoftwareRenderDevice all_threads(kImageSize, kImageSize);
+	double single_time = RenderFrames(&single_thread, instances);
+	double all_time    = RenderFrames(&all_threads, instances);
+
+	// The tiles are rasterized independently, so the images are the same whatever the number of threads
+	int num_mismatches = 0;
+	int num_cube_pixels = 0;
+	for (int y = 0; y < kImageSize; ++y)
+	{
+		const unsigned int* single_row = single_thread.GetPixels() + y * single_thread.GetPitch();
+		const unsigned int* all_row    = all_threads.GetPixels() + y * all_threads.GetPitch();
+		for (int x = 0; x < kImageSize; ++x)
+		{
+			if (single_row[x] != all_row[x])
+				++num_mismatches;
+			if (single_row[x] != kClearColor)
+				++num_cube_pixels;
+		}
+	}
+
+	const unsigned int* pixels = all_threads.GetPixels();
+	int pitch = all_threads.GetPitch();
+	bool center_covered = pixels[kImageSize / 2 * pitch + kImageSize / 2] != kClearColor;
+	bool corners_clear  = pixels[0] == kClearColor && pixels[kImageSize - 1] == kClearColor
+		&& pixels[(kImageSize - 1) * pitch] == kClearColor && pixels[(kImageSize - 1) * pitch + kImageSize - 1] == kClearColor;
+
+	all_threads.WriteTGA("SoftwareRender.tga");
+
+	fprintf(file, "Software rasterizer: %d x %d cube, %d instances, %d x %d pixels\n", kNumLayers, kNumLayers, (int)instances.size(), kImageSize, kImageSize);
+	fprintf(file, "  1 thread       %9.3f ms\n", single_time);
+	fprintf(file, "  %2d threads     %9.3f ms  %.1fx\n", (int)std::thread::hardware_concurrency(), all_time, all_time > 0 ? single_time / all_time : 0);
+	fprintf(file, "  cube pixels    %d\n", num_cube_pixels);
+	fprintf(file, "  center covered %s, corners clear %s\n", center_covered ? "yes" : "no", corners_clear ? "yes" : "no");
+	fprintf(file, "  mismatches     %d\n", num_mismatches);
+
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,10 @@
+#ifndef __SOFTWARE_RENDER_BENCHMARK_H__
+#define __SOFTWARE_RENDER_BENCHMARK_H__
+
+// Renders a large cube offscreen with SoftwareRenderDevice on one thread and on all cores, times the
+// frames, checks that both give the same image and that the cube covers the center but not the corners
+// of the image, and writes the results as text and the last frame as SoftwareRender.tga.
+// Return false if the file could not be written.
+bool RunSoftwareRenderBenchmark(const char* file_name);
+
+#endif // end __SOFTWARE_RENDER_BENCHMARK_H__
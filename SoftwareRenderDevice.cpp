@@ -0,0 +1,835 @@
+#include "SoftwareRenderDevice.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define SOFTWARE_RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+// out = a * b, row-major 4 x 4 matrices
+static void MultiplyMatrix(const float* a, const float* b, float* out)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			out[i * 4 + j] = a[i * 4 + 0] * b[0 * 4 + j]
+				           + a[i * 4 + 1] * b[1 * 4 + j]
+				           + a[i * 4 + 2] * b[2 * 4 + j]
+				           + a[i * 4 + 3] * b[3 * 4 + j];
+		}
+	}
+}
+
+static void IdentityMatrix(float* m)
+{
+	for (int i = 0; i < 16; ++i)
+	{
+		m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+	}
+}
+
+static void SetColor(float* color, float r, float g, float b, float a)
+{
+	color[0] = r;
+	color[1] = g;
+	color[2] = b;
+	color[3] = a;
+}
+
+static float Clamp01(float value)
+{
+	return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+// Plane equation of a value given at the 3 screen space vertices
+static void SetupPlane(float* plane, float x0, float y0, float dx1, float dy1, float dx2, float dy2,
+					   float inv_area, float f0, float f1, float f2)
+{
+	float df1 = f1 - f0;
+	float df2 = f2 - f0;
+
+	plane[0] = (df1 * dy2 - df2 * dy1) * inv_area;
+	plane[1] = (dx1 * df2 - dx2 * df1) * inv_area;
+	plane[2] = f0 - plane[0] * x0 - plane[1] * y0;
+}
+
+static float EvaluatePlane(const float* plane, float x, float y)
+{
+	return plane[0] * x + plane[1] * y + plane[2];
+}
+
+SoftwareRenderDevice::SoftwareRenderDevice(int width, int height, int num_threads)
+	: width_(width),
+	  height_(height),
+	  pitch_((width + 3) & ~3),
+	  num_tiles_x_((width + kTileSize - 1) / kTileSize),
+	  num_tiles_y_((height + kTileSize - 1) / kTileSize),
+	  clear_color_(0xff000000),
+	  texture_(kInvalidHandle),
+	  vertex_buffer_(kInvalidHandle),
+	  index_buffer_(kInvalidHandle),
+	  frame_id_(0),
+	  num_busy_workers_(0),
+	  quit_(false),
+	  next_tile_(0)
+{
+	color_buffer_.resize(pitch_ * height_, clear_color_);
+	depth_buffer_.resize(pitch_ * height_, 1.0f);
+	tile_bins_.resize(num_tiles_x_ * num_tiles_y_);
+
+	for (int i = 0; i < kNumTransformTypes; ++i)
+	{
+		IdentityMatrix(transforms_[i]);
+	}
+
+	for (int i = 0; i < kMaxLights; ++i)
+	{
+		light_enabled_[i] = false;
+	}
+
+	// Default material is white
+	SetColor(material_.ambient,  1.0f, 1.0f, 1.0f, 1.0f);
+	SetColor(material_.diffuse,  1.0f, 1.0f, 1.0f, 1.0f);
+	SetColor(material_.specular, 0.0f, 0.0f, 0.0f, 0.0f);
+	SetColor(material_.emissive, 0.0f, 0.0f, 0.0f, 0.0f);
+	material_.power = 0.0f;
+
+	if (num_threads <= 0)
+	{
+		num_threads = (int)std::thread::hardware_concurrency();
+	}
+
+	// The main thread rasterizes tiles too
+	for (int i = 1; i < num_threads; ++i)
+	{
+		workers_.push_back(std::thread(&SoftwareRenderDevice::WorkerThread, this));
+	}
+}
+
+SoftwareRenderDevice::~SoftwareRenderDevice(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	start_condition_.notify_all();
+
+	for (size_t i = 0; i < workers_.size(); ++i)
+	{
+		workers_[i].join();
+	}
+}
+
+BufferHandle SoftwareRenderDevice::CreateVertexBuffer(const void* vertices, int size, VertexFormat format)
+{
+	const unsigned char* data = (const unsigned char*)vertices;
+	buffers_.push_back(std::vector<unsigned char>(data, data + size));
+	return (BufferHandle)(buffers_.size() - 1);
+}
+
+BufferHandle SoftwareRenderDevice::CreateIndexBuffer(const unsigned short* indices, int num_indices)
+{
+	const unsigned char* data = (const unsigned char*)indices;
+	buffers_.push_back(std::vector<unsigned char>(data, data + num_indices * sizeof(unsigned short)));
+	return (BufferHandle)(buffers_.size() - 1);
+}
+
+void SoftwareRenderDevice::UpdateBuffer(BufferHandle buffer, const void* data, int offset, int size)
+{
+	if (buffer == kInvalidHandle)
+		return;
+
+	memcpy(&buffers_[buffer][offset], data, size);
+}
+
+void SoftwareRenderDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	if (buffer == kInvalidHandle)
+		return;
+
+	std::vector<unsigned char>().swap(buffers_[buffer]);
+}
+
+TextureHandle SoftwareRenderDevice::CreateTexture(int width, int height, const unsigned int* pixels)
+{
+	Texture texture;
+	texture.width  = width;
+	texture.height = height;
+	texture.pixels.assign(pixels, pixels + width * height);
+
+	textures_.push_back(texture);
+	return (TextureHandle)(textures_.size() - 1);
+}
+
+void SoftwareRenderDevice::UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels)
+{
+	if (texture == kInvalidHandle)
+		return;
+
+	Texture& t = textures_[texture];
+	for (int i = 0; i < height; ++i)
+	{
+		memcpy(&t.pixels[(y + i) * t.width + x], pixels + i * width, width * sizeof(unsigned int));
+	}
+}
+
+void SoftwareRenderDevice::ReleaseTexture(TextureHandle texture)
+{
+	if (texture == kInvalidHandle)
+		return;
+
+	textures_[texture].width  = 0;
+	textures_[texture].height = 0;
+	std::vector<unsigned int>().swap(textures_[texture].pixels);
+}
+
+void SoftwareRenderDevice::SetTransform(TransformType type, const float* matrix)
+{
+	memcpy(transforms_[type], matrix, sizeof(transforms_[type]));
+}
+
+void SoftwareRenderDevice::SetTexture(TextureHandle texture)
+{
+	texture_ = texture;
+}
+
+void SoftwareRenderDevice::SetStreamSource(BufferHandle vertex_buffer, int stride)
+{
+	vertex_buffer_ = vertex_buffer;
+}
+
+void SoftwareRenderDevice::SetIndices(BufferHandle index_buffer)
+{
+	index_buffer_ = index_buffer;
+}
+
+void SoftwareRenderDevice::SetVertexFormat(VertexFormat format)
+{
+	// Only kVertexPositionNormalTexture
+}
+
+void SoftwareRenderDevice::SetLight(int index, const Light& light)
+{
+	if (index < 0 || index >= kMaxLights)
+		return;
+
+	lights_[index] = light;
+	light_enabled_[index] = true;
+}
+
+void SoftwareRenderDevice::SetMaterial(const Material& material)
+{
+	material_ = material;
+}
+
+void SoftwareRenderDevice::DrawIndexedPrimitive(PrimitiveType type, int num_vertices, int start_index, int primitive_count)
+{
+	if (vertex_buffer_ == kInvalidHandle || index_buffer_ == kInvalidHandle)
+		return;
+
+	const Vertex* vertices = (const Vertex*)&buffers_[vertex_buffer_][0];
+	const unsigned short* indices = (const unsigned short*)&buffers_[index_buffer_][0] + start_index;
+
+	TransformVertices(vertices, num_vertices, transforms_[kWorldTransform], NULL);
+
+	for (int i = 0; i < primitive_count; ++i)
+	{
+		if (type == kTriangleList)
+		{
+			AddTriangle(clip_vertices_[indices[i * 3]], clip_vertices_[indices[i * 3 + 1]], clip_vertices_[indices[i * 3 + 2]]);
+		}
+		else if (i % 2 == 0) // kTriangleStrip, odd triangles have the reversed winding
+		{
+			AddTriangle(clip_vertices_[indices[i]], clip_vertices_[indices[i + 1]], clip_vertices_[indices[i + 2]]);
+		}
+		else
+		{
+			AddTriangle(clip_vertices_[indices[i + 1]], clip_vertices_[indices[i]], clip_vertices_[indices[i + 2]]);
+		}
+	}
+}
+
+void SoftwareRenderDevice::DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances)
+{
+	if (vertex_buffer_ == kInvalidHandle || index_buffer_ == kInvalidHandle)
+		return;
+
+	const Vertex* vertices = (const Vertex*)&buffers_[vertex_buffer_][0];
+	const unsigned short* indices = (const unsigned short*)&buffers_[index_buffer_][0] + start_index;
+
+	for (int i = 0; i < num_instances; ++i)
+	{
+		float world[16];
+		MultiplyMatrix(instances[i].world, transforms_[kWorldTransform], world);
+
+		TransformVertices(vertices, num_vertices, world, &instances[i]);
+
+		for (int j = 0; j < primitive_count; ++j)
+		{
+			if ((instances[i].face_mask & (1 << (indices[j * 3] / 4))) == 0)
+				continue;
+
+			AddTriangle(clip_vertices_[indices[j * 3]], clip_vertices_[indices[j * 3 + 1]], clip_vertices_[indices[j * 3 + 2]]);
+		}
+	}
+}
+
+// Transform the vertices to clip space and light them, instance gives the color and texture rectangle
+// of every 4 vertices, NULL to use the material color and the mesh texture coordinates.
+void SoftwareRenderDevice::TransformVertices(const Vertex* vertices, int num_vertices, const float* world, const InstanceData* instance)
+{
+	float view_proj[16];
+	float world_view_proj[16];
+	MultiplyMatrix(transforms_[kViewTransform], transforms_[kProjectionTransform], view_proj);
+	MultiplyMatrix(world, view_proj, world_view_proj);
+
+	const float* m = world_view_proj;
+	clip_vertices_.resize(num_vertices);
+
+	for (int i = 0; i < num_vertices; ++i)
+	{
+		const Vertex& in = vertices[i];
+		ClipVertex& out = clip_vertices_[i];
+
+		out.x = in.x * m[0] + in.y * m[4] + in.z * m[8]  + m[12];
+		out.y = in.x * m[1] + in.y * m[5] + in.z * m[9]  + m[13];
+		out.z = in.x * m[2] + in.y * m[6] + in.z * m[10] + m[14];
+		out.w = in.x * m[3] + in.y * m[7] + in.z * m[11] + m[15];
+		if (instance != NULL)
+		{
+			const float* uv_rect = instance->uv_rects[(i / 4) % kMaxInstanceColors];
+			out.u = uv_rect[0] + in.u * uv_rect[2];
+			out.v = uv_rect[1] + in.v * uv_rect[3];
+		}
+		else
+		{
+			out.u = in.u;
+			out.v = in.v;
+		}
+
+		// Lighting in world space
+		float position[3] =
+		{
+			in.x * world[0] + in.y * world[4] + in.z * world[8]  + world[12],
+			in.x * world[1] + in.y * world[5] + in.z * world[9]  + world[13],
+			in.x * world[2] + in.y * world[6] + in.z * world[10] + world[14],
+		};
+
+		float normal[3] =
+		{
+			in.nx * world[0] + in.ny * world[4] + in.nz * world[8],
+			in.nx * world[1] + in.ny * world[5] + in.nz * world[9],
+			in.nx * world[2] + in.ny * world[6] + in.nz * world[10],
+		};
+
+		float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (length > 0.0f)
+		{
+			normal[0] /= length;
+			normal[1] /= length;
+			normal[2] /= length;
+		}
+
+		float color[3];
+		if (instance != NULL)
+		{
+			// The vertex color replaces the diffuse and ambient material color
+			unsigned int argb = instance->colors[(i / 4) % kMaxInstanceColors];
+			float vertex_color[4] =
+			{
+				((argb >> 16) & 0xff) / 255.0f,
+				((argb >>  8) & 0xff) / 255.0f,
+				( argb        & 0xff) / 255.0f,
+				((argb >> 24) & 0xff) / 255.0f,
+			};
+			LightVertex(position, normal, vertex_color, vertex_color, color);
+		}
+		else
+		{
+			LightVertex(position, normal, material_.diffuse, material_.ambient, color);
+		}
+
+		out.r = color[0];
+		out.g = color[1];
+		out.b = color[2];
+	}
+}
+
+// Fixed function point light: ambient + diffuse * N.L * attenuation, clamped to [0, 1].
+void SoftwareRenderDevice::LightVertex(const float* position, const float* normal, const float* diffuse, const float* ambient, float* color) const
+{
+	color[0] = material_.emissive[0];
+	color[1] = material_.emissive[1];
+	color[2] = material_.emissive[2];
+
+	for (int i = 0; i < kMaxLights; ++i)
+	{
+		if (!light_enabled_[i])
+			continue;
+
+		const Light& light = lights_[i];
+
+		float to_light[3] =
+		{
+			light.position[0] - position[0],
+			light.position[1] - position[1],
+			light.position[2] - position[2],
+		};
+
+		float distance = sqrtf(to_light[0] * to_light[0] + to_light[1] * to_light[1] + to_light[2] * to_light[2]);
+		if (distance > light.range)
+			continue;
+
+		float attenuation = light.attenuation[0] + light.attenuation[1] * distance + light.attenuation[2] * distance * distance;
+		attenuation = attenuation > 0.0f ? 1.0f / attenuation : 1.0f;
+
+		float n_dot_l = 0.0f;
+		if (distance > 0.0f)
+		{
+			n_dot_l = (normal[0] * to_light[0] + normal[1] * to_light[1] + normal[2] * to_light[2]) / distance;
+			n_dot_l = n_dot_l > 0.0f ? n_dot_l : 0.0f;
+		}
+
+		for (int c = 0; c < 3; ++c)
+		{
+			color[c] += (light.ambient[c] * ambient[c] + light.diffuse[c] * diffuse[c] * n_dot_l) * attenuation;
+		}
+	}
+
+	color[0] = Clamp01(color[0]);
+	color[1] = Clamp01(color[1]);
+	color[2] = Clamp01(color[2]);
+}
+
+// Clip the triangle against the near plane(z = 0 in clip space), the other planes are handled by
+// the screen bounding box and the depth test.
+void SoftwareRenderDevice::AddTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2)
+{
+	if (v0.z >= 0.0f && v1.z >= 0.0f && v2.z >= 0.0f)
+	{
+		SetupTriangle(v0, v1, v2);
+		return;
+	}
+
+	const ClipVertex* in[3] = { &v0, &v1, &v2 };
+	ClipVertex out[4];
+	int num_out = 0;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const ClipVertex& a = *in[i];
+		const ClipVertex& b = *in[(i + 1) % 3];
+
+		if (a.z >= 0.0f)
+		{
+			out[num_out++] = a;
+		}
+
+		// Edge crosses the near plane
+		if ((a.z >= 0.0f) != (b.z >= 0.0f))
+		{
+			float t = a.z / (a.z - b.z);
+			ClipVertex& c = out[num_out++];
+			c.x = a.x + (b.x - a.x) * t;
+			c.y = a.y + (b.y - a.y) * t;
+			c.z = 0.0f;
+			c.w = a.w + (b.w - a.w) * t;
+			c.u = a.u + (b.u - a.u) * t;
+			c.v = a.v + (b.v - a.v) * t;
+			c.r = a.r + (b.r - a.r) * t;
+			c.g = a.g + (b.g - a.g) * t;
+			c.b = a.b + (b.b - a.b) * t;
+		}
+	}
+
+	for (int i = 2; i < num_out; ++i)
+	{
+		SetupTriangle(out[0], out[i - 1], out[i]);
+	}
+}
+
+void SoftwareRenderDevice::SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2)
+{
+	const ClipVertex* v[3] = { &v0, &v1, &v2 };
+
+	float sx[3];
+	float sy[3];
+	float sz[3];
+	float inv_w[3];
+
+	// Project to screen space
+	for (int i = 0; i < 3; ++i)
+	{
+		if (v[i]->w <= 0.0f)
+			return;
+
+		inv_w[i] = 1.0f / v[i]->w;
+		sx[i] = (v[i]->x * inv_w[i] * 0.5f + 0.5f) * width_;
+		sy[i] = (0.5f - v[i]->y * inv_w[i] * 0.5f) * height_;
+		sz[i] = v[i]->z * inv_w[i];
+	}
+
+	// Signed area, positive for triangles which are clockwise on screen.
+	// Counter-clockwise triangles are back faces and culled.
+	float dx1 = sx[1] - sx[0];
+	float dy1 = sy[1] - sy[0];
+	float dx2 = sx[2] - sx[0];
+	float dy2 = sy[2] - sy[0];
+	float area = dx1 * dy2 - dx2 * dy1;
+	if (area <= 0.0f)
+		return;
+
+	RasterTriangle tri;
+
+	// Bounding box, clamped to the screen
+	float min_x = (std::min)(sx[0], (std::min)(sx[1], sx[2]));
+	float max_x = (std::max)(sx[0], (std::max)(sx[1], sx[2]));
+	float min_y = (std::min)(sy[0], (std::min)(sy[1], sy[2]));
+	float max_y = (std::max)(sy[0], (std::max)(sy[1], sy[2]));
+
+	if (max_x < 0.0f || max_y < 0.0f || min_x > (float)width_ || min_y > (float)height_)
+		return;
+
+	tri.min_x = (int)(std::max)(0.0f, floorf(min_x));
+	tri.min_y = (int)(std::max)(0.0f, floorf(min_y));
+	tri.max_x = (int)(std::min)((float)(width_ - 1), ceilf(max_x));
+	tri.max_y = (int)(std::min)((float)(height_ - 1), ceilf(max_y));
+	if (tri.min_x > tri.max_x || tri.min_y > tri.max_y)
+		return;
+
+	// Edge functions, edge i goes from vertex i to vertex i + 1
+	for (int i = 0; i < 3; ++i)
+	{
+		int j = (i + 1) % 3;
+		tri.edge[i][0] = sy[i] - sy[j];
+		tri.edge[i][1] = sx[j] - sx[i];
+		tri.edge[i][2] = (sy[j] - sy[i]) * sx[i] - (sx[j] - sx[i]) * sy[i];
+	}
+
+	float inv_area = 1.0f / area;
+	SetupPlane(tri.z,     sx[0], sy[0], dx1, dy1, dx2, dy2, inv_area, sz[0], sz[1], sz[2]);
+	SetupPlane(tri.inv_w, sx[0], sy[0], dx1, dy1, dx2, dy2, inv_area, inv_w[0], inv_w[1], inv_w[2]);
+	SetupPlane(tri.u,     sx[0], sy[0], dx1, dy1, dx2, dy2, inv_area, v0.u * inv_w[0], v1.u * inv_w[1], v2.u * inv_w[2]);
+	SetupPlane(tri.v,     sx[0], sy[0], dx1, dy1, dx2, dy2, inv_area, v0.v * inv_w[0], v1.v * inv_w[1], v2.v * inv_w[2]);
+	SetupPlane(tri.r,     sx[0], sy[0], dx1, dy1, dx2, dy2, inv_area, v0.r * inv_w[0], v1.r * inv_w[1], v2.r * inv_w[2]);
+	SetupPlane(tri.g,     sx[0], sy[0], dx1, dy1, dx2, dy2, inv_area, v0.g * inv_w[0], v1.g * inv_w[1], v2.g * inv_w[2]);
+	SetupPlane(tri.b,     sx[0], sy[0], dx1, dy1, dx2, dy2, inv_area, v0.b * inv_w[0], v1.b * inv_w[1], v2.b * inv_w[2]);
+
+	tri.texture = (texture_ != kInvalidHandle && !textures_[texture_].pixels.empty()) ? texture_ : kInvalidHandle;
+
+	// Bin the triangle into the tiles it overlaps
+	int index = (int)triangles_.size();
+	triangles_.push_back(tri);
+
+	for (int ty = tri.min_y / kTileSize; ty <= tri.max_y / kTileSize; ++ty)
+	{
+		for (int tx = tri.min_x / kTileSize; tx <= tri.max_x / kTileSize; ++tx)
+		{
+			tile_bins_[ty * num_tiles_x_ + tx].push_back(index);
+		}
+	}
+}
+
+// Rasterize all triangles binned in a tile. Pixels are processed 4 at a time: the edge functions
+// and the depth test are evaluated with SSE2, only the covered pixels which pass the depth test are shaded.
+// Pixels on a shared edge may be drawn by both triangles, there is no top-left fill rule.
+void SoftwareRenderDevice::RasterizeTile(int tile)
+{
+	int tile_x0 = (tile % num_tiles_x_) * kTileSize;
+	int tile_y0 = (tile / num_tiles_x_) * kTileSize;
+	int tile_x1 = (std::min)(tile_x0 + kTileSize, width_) - 1;
+	int tile_y1 = (std::min)(tile_y0 + kTileSize, height_) - 1;
+
+	// Clear the tile
+	for (int y = tile_y0; y <= tile_y1; ++y)
+	{
+		unsigned int* color_row = &color_buffer_[y * pitch_];
+		float* depth_row = &depth_buffer_[y * pitch_];
+		for (int x = tile_x0; x <= tile_x1; ++x)
+		{
+			color_row[x] = clear_color_;
+			depth_row[x] = 1.0f;
+		}
+	}
+
+	const std::vector<int>& bin = tile_bins_[tile];
+
+	for (size_t t = 0; t < bin.size(); ++t)
+	{
+		const RasterTriangle& tri = triangles_[bin[t]];
+
+		// Clamp the bounding box to the tile, start at a multiple of 4 pixels
+		int x0 = (std::max)(tri.min_x, tile_x0) & ~3;
+		int x1 = (std::min)(tri.max_x, tile_x1);
+		int y0 = (std::max)(tri.min_y, tile_y0);
+		int y1 = (std::min)(tri.max_y, tile_y1);
+
+		const Texture* texture = tri.texture != kInvalidHandle ? &textures_[tri.texture] : NULL;
+
+#ifdef SOFTWARE_RASTER_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 x_limit = _mm_set1_ps(x1 + 0.5f);
+		const __m128 a0 = _mm_set1_ps(tri.edge[0][0]);
+		const __m128 a1 = _mm_set1_ps(tri.edge[1][0]);
+		const __m128 a2 = _mm_set1_ps(tri.edge[2][0]);
+		const __m128 za = _mm_set1_ps(tri.z[0]);
+#endif
+
+		for (int y = y0; y <= y1; ++y)
+		{
+			float py = y + 0.5f;
+			unsigned int* color_row = &color_buffer_[y * pitch_];
+			float* depth_row = &depth_buffer_[y * pitch_];
+
+#ifdef SOFTWARE_RASTER_SSE2
+			const __m128 row0 = _mm_set1_ps(tri.edge[0][1] * py + tri.edge[0][2]);
+			const __m128 row1 = _mm_set1_ps(tri.edge[1][1] * py + tri.edge[1][2]);
+			const __m128 row2 = _mm_set1_ps(tri.edge[2][1] * py + tri.edge[2][2]);
+			const __m128 rowz = _mm_set1_ps(tri.z[1] * py + tri.z[2]);
+#endif
+
+			for (int x = x0; x <= x1; x += 4)
+			{
+				int mask = 0;
+
+#ifdef SOFTWARE_RASTER_SSE2
+				__m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), row0);
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), row1);
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), row2);
+
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+										   _mm_and_ps(_mm_cmpge_ps(e2, zero), _mm_cmple_ps(px, x_limit)));
+				if (_mm_movemask_ps(inside) == 0)
+					continue;
+
+				__m128 z = _mm_add_ps(_mm_mul_ps(za, px), rowz);
+				__m128 old_z = _mm_loadu_ps(depth_row + x);
+				__m128 pass = _mm_and_ps(inside, _mm_cmple_ps(z, old_z));
+
+				mask = _mm_movemask_ps(pass);
+				if (mask == 0)
+					continue;
+
+				_mm_storeu_ps(depth_row + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, old_z)));
+#else
+				for (int i = 0; i < 4 && x + i <= x1; ++i)
+				{
+					float px = x + i + 0.5f;
+					if (EvaluatePlane(tri.edge[0], px, py) < 0.0f
+						|| EvaluatePlane(tri.edge[1], px, py) < 0.0f
+						|| EvaluatePlane(tri.edge[2], px, py) < 0.0f)
+						continue;
+
+					float z = EvaluatePlane(tri.z, px, py);
+					if (z > depth_row[x + i])
+						continue;
+
+					depth_row[x + i] = z;
+					mask |= 1 << i;
+				}
+
+				if (mask == 0)
+					continue;
+#endif
+
+				// Shade the visible pixels
+				for (int i = 0; i < 4; ++i)
+				{
+					if ((mask & (1 << i)) == 0)
+						continue;
+
+					float px = x + i + 0.5f;
+					float w = 1.0f / EvaluatePlane(tri.inv_w, px, py);
+
+					float r = Clamp01(EvaluatePlane(tri.r, px, py) * w);
+					float g = Clamp01(EvaluatePlane(tri.g, px, py) * w);
+					float b = Clamp01(EvaluatePlane(tri.b, px, py) * w);
+
+					if (texture != NULL)
+					{
+						// Point sampling, wrap address mode
+						float u = EvaluatePlane(tri.u, px, py) * w;
+						float v = EvaluatePlane(tri.v, px, py) * w;
+						u -= floorf(u);
+						v -= floorf(v);
+
+						int tu = (std::min)((int)(u * texture->width), texture->width - 1);
+						int tv = (std::min)((int)(v * texture->height), texture->height - 1);
+						unsigned int texel = texture->pixels[tv * texture->width + tu];
+
+						r *= ((texel >> 16) & 0xff) / 255.0f;
+						g *= ((texel >>  8) & 0xff) / 255.0f;
+						b *= ( texel        & 0xff) / 255.0f;
+					}
+
+					color_row[x + i] = 0xff000000
+						| ((unsigned int)(r * 255.0f + 0.5f) << 16)
+						| ((unsigned int)(g * 255.0f + 0.5f) << 8)
+						|  (unsigned int)(b * 255.0f + 0.5f);
+				}
+			}
+		}
+	}
+}
+
+void SoftwareRenderDevice::RasterizeFrame()
+{
+	int num_tiles = num_tiles_x_ * num_tiles_y_;
+
+	if (workers_.empty())
+	{
+		for (int i = 0; i < num_tiles; ++i)
+		{
+			RasterizeTile(i);
+		}
+		return;
+	}
+
+	// Wake up the workers
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		next_tile_ = 0;
+		num_busy_workers_ = (int)workers_.size();
+		++frame_id_;
+	}
+	start_condition_.notify_all();
+
+	// Rasterize on the main thread too
+	int tile;
+	while ((tile = next_tile_++) < num_tiles)
+	{
+		RasterizeTile(tile);
+	}
+
+	// Wait for the workers
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (num_busy_workers_ > 0)
+	{
+		done_condition_.wait(lock);
+	}
+}
+
+void SoftwareRenderDevice::WorkerThread()
+{
+	int num_tiles = num_tiles_x_ * num_tiles_y_;
+	int last_frame = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			while (!quit_ && frame_id_ == last_frame)
+			{
+				start_condition_.wait(lock);
+			}
+
+			if (quit_)
+				return;
+
+			last_frame = frame_id_;
+		}
+
+		int tile;
+		while ((tile = next_tile_++) < num_tiles)
+		{
+			RasterizeTile(tile);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (--num_busy_workers_ == 0)
+			{
+				done_condition_.notify_one();
+			}
+		}
+	}
+}
+
+// The Clear covers the whole target, so everything drawn before it in the frame is discarded
+// and the tiles are cleared when they are rasterized.
+void SoftwareRenderDevice::Clear(unsigned int color)
+{
+	clear_color_ = color | 0xff000000;
+	triangles_.clear();
+
+	for (size_t i = 0; i < tile_bins_.size(); ++i)
+	{
+		tile_bins_[i].clear();
+	}
+}
+
+bool SoftwareRenderDevice::BeginScene()
+{
+	return true;
+}
+
+void SoftwareRenderDevice::EndScene()
+{
+}
+
+bool SoftwareRenderDevice::Present()
+{
+	RasterizeFrame();
+
+	triangles_.clear();
+	for (size_t i = 0; i < tile_bins_.size(); ++i)
+	{
+		tile_bins_[i].clear();
+	}
+
+	return true;
+}
+
+int SoftwareRenderDevice::GetWidth() const
+{
+	return width_;
+}
+
+int SoftwareRenderDevice::GetHeight() const
+{
+	return height_;
+}
+
+const unsigned int* SoftwareRenderDevice::GetPixels() const
+{
+	return &color_buffer_[0];
+}
+
+int SoftwareRenderDevice::GetPitch() const
+{
+	return pitch_;
+}
+
+bool SoftwareRenderDevice::WriteTGA(const char* file_name) const
+{
+	FILE* file = fopen(file_name, "wb");
+	if (file == NULL)
+		return false;
+
+	// Uncompressed true-color image, 32 bits per pixel, 8 alpha bits, top-left origin
+	unsigned char header[18] = { 0 };
+	header[2]  = 2;
+	header[12] = (unsigned char)(width_ & 0xff);
+	header[13] = (unsigned char)(width_ >> 8);
+	header[14] = (unsigned char)(height_ & 0xff);
+	header[15] = (unsigned char)(height_ >> 8);
+	header[16] = 32;
+	header[17] = 0x28;
+	fwrite(header, 1, sizeof(header), file);
+
+	// ARGB in little endian is the BGRA order of TGA
+	for (int y = 0; y < height_; ++y)
+	{
+		fwrite(&color_buffer_[y * pitch_], 4, width_, file);
+	}
+
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,145 @@
+#ifndef __SOFTWARE_RENDER_DEVICE_H__
+#define __SOFTWARE_RENDER_DEVICE_H__
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "RenderDevice.h"
+
+// A CPU implementation of the render device, it needs no GPU and no Windows headers.
+// Draw calls only transform, light and bin the triangles into screen tiles, the tiles are
+// rasterized in parallel by a pool of worker threads when the frame is presented.
+// The result is a 32-bit ARGB image which can be read by GetPixels or written by WriteTGA.
+//
+// It follows the fixed function states used by the app: one texture stage modulated by the
+// lit vertex color, point sampling with wrap address mode, counter-clockwise back face culling,
+// less-equal depth test and point lights.
+class SoftwareRenderDevice : public RenderDevice
+{
+public:
+	// num_threads = 0 uses one thread for each hardware core.
+	SoftwareRenderDevice(int width, int height, int num_threads = 0);
+	~SoftwareRenderDevice(void);
+
+	BufferHandle CreateVertexBuffer(const void* vertices, int size, VertexFormat format);
+	BufferHandle CreateIndexBuffer(const unsigned short* indices, int num_indices);
+	void UpdateBuffer(BufferHandle buffer, const void* data, int offset, int size);
+	void ReleaseBuffer(BufferHandle buffer);
+
+	TextureHandle CreateTexture(int width, int height, const unsigned int* pixels);
+	void UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels);
+	void ReleaseTexture(TextureHandle texture);
+
+	void SetTransform(TransformType type, const float* matrix);
+	void SetTexture(TextureHandle texture);
+	void SetStreamSource(BufferHandle vertex_buffer, int stride);
+	void SetIndices(BufferHandle index_buffer);
+	void SetVertexFormat(VertexFormat format);
+	void SetLight(int index, const Light& light);
+	void SetMaterial(const Material& material);
+
+	void DrawIndexedPrimitive(PrimitiveType type, int num_vertices, int start_index, int primitive_count);
+	void DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances);
+
+	void Clear(unsigned int color);
+	bool BeginScene();
+	void EndScene();
+	bool Present();
+
+	int GetWidth() const;
+	int GetHeight() const;
+
+	// The last presented frame, GetPitch() pixels per row.
+	const unsigned int* GetPixels() const;
+	int GetPitch() const;
+
+	// Write the last presented frame as an uncompressed 32-bit TGA file.
+	bool WriteTGA(const char* file_name) const;
+
+private:
+	static const int kTileSize = 64;	// Tile width and height in pixels
+	static const int kMaxLights = 8;
+
+	// A transformed and lit vertex
+	struct ClipVertex
+	{
+		float x, y, z, w;	// Clip space position
+		float u, v;			// Texture coordinates
+		float r, g, b;		// Lit color
+	};
+
+	// Triangle after setup, values are interpolated by plane equations value = dx * x + dy * y + c
+	// in screen space, u, v, r, g, b are divided by w for perspective correction.
+	struct RasterTriangle
+	{
+		float edge[3][3];		// Edge functions(a, b, c), positive inside
+		float z[3];
+		float inv_w[3];
+		float u[3];
+		float v[3];
+		float r[3];
+		float g[3];
+		float b[3];
+		int min_x, min_y, max_x, max_y;
+		int texture;			// TextureHandle, kInvalidHandle for untextured
+	};
+
+	struct Texture
+	{
+		int width;
+		int height;
+		std::vector<unsigned int> pixels;
+	};
+
+	void TransformVertices(const Vertex* vertices, int num_vertices, const float* world, const InstanceData* instance);
+	void LightVertex(const float* position, const float* normal, const float* diffuse, const float* ambient, float* color) const;
+	void AddTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2);
+	void SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2);
+	void RasterizeTile(int tile);
+	void RasterizeFrame();
+	void WorkerThread();
+
+private:
+	int width_;
+	int height_;
+	int pitch_;					// Pixels per row, rounded up to 4 for the 4-wide rasterizer
+	int num_tiles_x_;
+	int num_tiles_y_;
+
+	std::vector<unsigned int> color_buffer_;
+	std::vector<float> depth_buffer_;
+	unsigned int clear_color_;
+
+	// Resources
+	std::vector<std::vector<unsigned char> > buffers_;	// Indexed by BufferHandle, empty for released buffer
+	std::vector<Texture> textures_;						// Indexed by TextureHandle, empty for released texture
+
+	// States
+	float transforms_[kNumTransformTypes][16];
+	TextureHandle texture_;
+	BufferHandle vertex_buffer_;
+	BufferHandle index_buffer_;
+	Light lights_[kMaxLights];
+	bool light_enabled_[kMaxLights];
+	Material material_;
+
+	// Frame data
+	std::vector<ClipVertex> clip_vertices_;			// Vertices of the current draw call
+	std::vector<RasterTriangle> triangles_;			// All triangles of the frame
+	std::vector<std::vector<int> > tile_bins_;		// Triangle indices overlapping each tile
+
+	// Worker threads, the main thread also rasterizes tiles
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	std::condition_variable start_condition_;
+	std::condition_variable done_condition_;
+	int frame_id_;					// Incremented for each rasterized frame
+	int num_busy_workers_;
+	bool quit_;
+	std::atomic<int> next_tile_;	// Next tile to be rasterized
+};
+
+#endif // end __SOFTWARE_RENDER_DEVICE_H__
@@ -0,0 +1,147 @@
+#include "Solver.h"
+
+// The cancel flag is read once per this many turns
+static const int kCancelCheckInterval = 4096;
+
+Solver::Solver(void)
+	: cancelled_(false),
+	  has_result_(false)
+{
+	result_.request = 0;
+	result_.solved = false;
+}
+
+Solver::~Solver(void)
+{
+	Stop();
+}
+
+void Solver::Start(int request, const CubePlacement& start, const std::vector<unsigned int>& turns, HWND hWnd, UINT message)
+{
+	Stop();
+
+	cancelled_ = false;
+	thread_ = std::thread([=]()
+	{
+		Run(request, start, turns, hWnd, message);
+	});
+}
+
+void Solver::Cancel()
+{
+	cancelled_ = true;
+}
+
+void Solver::Stop()
+{
+	Cancel();
+
+	if (thread_.joinable())
+		thread_.join();
+}
+
+bool Solver::GetResult(SolverResult* result)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!has_result_)
+		return false;
+
+	result->request = result_.request;
+	result->solved = result_.solved;
+	result->turns.swap(result_.turns);
+	has_result_ = false;
+
+	return true;
+}
+
+void Solver::Run(int request, const CubePlacement& start, const std::vector<unsigned int>& turns, HWND hWnd, UINT message)
+{
+	std::vector<unsigned int> solution;
+	bool solved = false;
+
+	if (start.IsSolved())
+	{
+		if (!Simplify(start.GetNumLayers(), turns, &solution))
+			return;
+
+		// Check the solution on a copy of the placement
+		CubePlacement placement = start;
+		for (size_t i = 0; i < turns.size() + solution.size(); ++i)
+		{
+			if (i % kCancelCheckInterval == 0 && cancelled_)
+				return;
+
+			unsigned int turn = i < turns.size() ? turns[i] : solution[i - turns.size()];
+			placement.RotateLayer(turn / 4, turn % 4);
+		}
+
+		solved = placement.IsSolved();
+		if (!solved)
+			solution.clear();
+	}
+
+	if (cancelled_)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		result_.request = request;
+		result_.solved = solved;
+		result_.turns.swap(solution);
+		has_result_ = true;
+	}
+
+	PostMessage(hWnd, message, 0, 0);
+}
+
+/*
+The inverse turns are pushed on a stack, last turn first. The turns at the top of the stack around
+the same axis as the new turn commute with it, so the new turn is merged with a turn of its layer
+among them, or pushed if there is none. The run of one axis holds at most one turn per layer.
+*/
+bool Solver::Simplify(int num_layers, const std::vector<unsigned int>& turns, std::vector<unsigned int>* solution)
+{
+	size_t stack_size = (turns.size() + 1) * sizeof(unsigned int);
+	if (scratch_.GetCapacity() < stack_size + Arena::kDefaultAlignment)
+		scratch_.Init(stack_size * 2 + Arena::kDefaultAlignment);
+
+	ArenaScope scope(&scratch_);
+	unsigned int* stack = (unsigned int*)scratch_.Allocate(stack_size);
+	int size = 0;
+
+	for (int i = (int)turns.size() - 1; i >= 0; --i)
+	{
+		if (i % kCancelCheckInterval == 0 && cancelled_)
+			return false;
+
+		int layer = turns[i] / 4;
+		int quarter_turns = 4 - turns[i] % 4;
+		int axis = layer / num_layers;
+
+		int j = size - 1;
+		while (j >= 0 && (int)(stack[j] / 4) / num_layers == axis && (int)(stack[j] / 4) != layer)
+			--j;
+
+		if (j >= 0 && (int)(stack[j] / 4) == layer)
+		{
+			int merged = (stack[j] % 4 + quarter_turns) % 4;
+			if (merged != 0)
+			{
+				stack[j] = layer * 4 + merged;
+			}
+			else
+			{
+				for (int k = j; k < size - 1; ++k)
+					stack[k] = stack[k + 1];
+				--size;
+			}
+		}
+		else
+		{
+			stack[size++] = layer * 4 + quarter_turns;
+		}
+	}
+
+	solution->assign(stack, stack + size);
+	return true;
+}
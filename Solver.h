@@ -0,0 +1,61 @@
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+
+#include <windows.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Arena.h"
+#include "CubePlacement.h"
+
+// A finished solve, the turns are encoded as in MoveHistory, layer_id * 4 + quarter_turns
+struct SolverResult
+{
+	int request;						// The request number passed to Start
+	bool solved;						// False if no solution was found
+	std::vector<unsigned int> turns;	// The turns to the solved cube, in order
+};
+
+/*
+Finds the turns from the current placement back to the solved cube on a background thread.
+The solve takes the placement the history started from and the turns done since, the solution is the
+inverse of those turns simplified: the turns around one axis commute, so a run of them is kept as
+one turn per layer, a layer turned back to where it was drops out, and a layer turned on merges
+with its earlier turn. The solution is replayed on a copy of the placement to check it solves.
+The history must start at a solved cube, a loaded puzzle which was not solved has no solution.
+The simplification works in a scratch arena, the solve allocates once however long the history is.
+Cancel may be called from any thread, a cancelled solve stops within a few thousand turns and
+posts nothing. Start and Stop are called by one thread.
+*/
+class Solver
+{
+public:
+	Solver(void);
+	~Solver(void);
+
+	// Solve on the background thread, the solve running before is cancelled. When it ends the
+	// message is posted to the window, GetResult then returns the result.
+	void Start(int request, const CubePlacement& start, const std::vector<unsigned int>& turns, HWND hWnd, UINT message);
+
+	void Cancel();
+	void Stop();		// Cancel and wait for the thread
+
+	// The last finished solve, false if there is none since the last call
+	bool GetResult(SolverResult* result);
+
+private:
+	void Run(int request, const CubePlacement& start, const std::vector<unsigned int>& turns, HWND hWnd, UINT message);
+	bool Simplify(int num_layers, const std::vector<unsigned int>& turns, std::vector<unsigned int>* solution);
+
+private:
+	std::thread thread_;
+	std::atomic<bool> cancelled_;
+	Arena scratch_;						// Stack of the simplified turns, used by the solver thread
+
+	std::mutex mutex_;
+	bool has_result_;
+	SolverResult result_;
+};
+
+#endif // end __SOLVER_H__
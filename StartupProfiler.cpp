@@ -0,0 +1,100 @@
+#include "StartupProfiler.h"
+
+#include <stdio.h>
+
+static const char* kPhaseNames[kNumStartupPhases] =
+{
+	"Window",
+	"Device",
+	"Textures",
+	"Meshes",
+	"Puzzle",
+	"Simulation",
+	"FirstFrame",
+	"StickerAtlas",
+};
+
+StartupProfiler::StartupProfiler(void)
+	: current_phase_(-1)
+{
+	for (int i = 0; i < kNumStartupPhases; ++i)
+	{
+		phase_starts_[i] = 0;
+		phase_ends_[i] = 0;
+	}
+
+	QueryPerformanceFrequency(&frequency_);
+	QueryPerformanceCounter(&start_counter_);
+
+	BeginPhase(kStartupWindow);
+}
+
+StartupProfiler::~StartupProfiler(void)
+{
+}
+
+void StartupProfiler::BeginPhase(StartupPhase phase)
+{
+	EndPhase();
+
+	current_phase_ = phase;
+	phase_starts_[phase] = GetTime();
+}
+
+void StartupProfiler::EndPhase()
+{
+	if (current_phase_ >= 0)
+		phase_ends_[current_phase_] = GetTime();
+	current_phase_ = -1;
+}
+
+void StartupProfiler::RecordPhase(StartupPhase phase, double start_time, double end_time)
+{
+	phase_starts_[phase] = start_time;
+	phase_ends_[phase] = end_time;
+}
+
+double StartupProfiler::GetTime() const
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (counter.QuadPart - start_counter_.QuadPart) * 1000.0 / frequency_.QuadPart;
+}
+
+double StartupProfiler::GetPhaseTime(StartupPhase phase) const
+{
+	return phase_ends_[phase] - phase_starts_[phase];
+}
+
+double StartupProfiler::GetFirstFrameTime() const
+{
+	return phase_ends_[kStartupFirstFrame];
+}
+
+bool StartupProfiler::WriteReport(const char* file_name) const
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "phase,start_ms,duration_ms\n");
+	for (int i = 0; i < kNumStartupPhases; ++i)
+	{
+		fprintf(file, "%s,%.3f,%.3f\n", kPhaseNames[i], phase_starts_[i], GetPhaseTime((StartupPhase)i));
+	}
+
+	double first_frame = GetFirstFrameTime();
+	if (first_frame == 0)
+		fprintf(file, "\nfirst frame not presented yet, budget %d ms\n", kFirstFrameBudget);
+	else
+		fprintf(file, "\nfirst frame %.3f ms, budget %d ms, %s\n", first_frame, kFirstFrameBudget,
+			first_frame <= kFirstFrameBudget ? "within budget" : "over budget");
+
+	fclose(file);
+	return true;
+}
+
+const char* StartupProfiler::GetPhaseName(StartupPhase phase)
+{
+	return kPhaseNames[phase];
+}
@@ -0,0 +1,56 @@
+#ifndef __STARTUP_PROFILER_H__
+#define __STARTUP_PROFILER_H__
+
+#include <windows.h>
+
+// The steps from the program start to the first frame, in the order they run.
+// The sticker atlas is made by a background thread, it is not on the way to the first frame.
+enum StartupPhase
+{
+	kStartupWindow       = 0,	// Window class and window creation, before RubikCube::Initialize
+	kStartupDevice       = 1,	// Direct3D device
+	kStartupTextures     = 2,	// Placeholder sticker atlas, the full one is started in the background
+	kStartupMeshes       = 3,	// Unit meshes in the geometry pool
+	kStartupPuzzle       = 4,	// Cube placement, from a puzzle file or solved
+	kStartupSimulation   = 5,	// First snapshot and the simulation thread
+	kStartupFirstFrame   = 6,	// Initialize to the first Present
+	kStartupStickerAtlas = 7,	// Loading or generating the full sticker atlas, in the background
+
+	kNumStartupPhases    = 8
+};
+
+// Times the startup phases in milliseconds from the profiler creation, which is the creation of the
+// RubikCube, so the report shows how long the first frame took and where the time went.
+// The phases of the message thread run one after another, BeginPhase ends the running one.
+// The background phase is recorded by its thread with RecordPhase, and read after the thread ended.
+class StartupProfiler
+{
+public:
+	// The first frame should be presented within this time of the start, whatever the cube size is
+	static const int kFirstFrameBudget = 250;
+
+	StartupProfiler(void);
+	~StartupProfiler(void);
+
+	void BeginPhase(StartupPhase phase);
+	void EndPhase();
+	void RecordPhase(StartupPhase phase, double start_time, double end_time);
+
+	double GetTime() const;						// Milliseconds from the profiler creation
+	double GetPhaseTime(StartupPhase phase) const;	// 0 if the phase did not run yet
+	double GetFirstFrameTime() const;			// Time of the first Present, 0 before it
+
+	// One line per phase with its start and duration, then the first frame time against the budget
+	bool WriteReport(const char* file_name) const;
+
+	static const char* GetPhaseName(StartupPhase phase);
+
+private:
+	double phase_starts_[kNumStartupPhases];
+	double phase_ends_[kNumStartupPhases];
+	int current_phase_;					// Running phase, -1 if none
+	LARGE_INTEGER frequency_;			// Performance counter ticks per second
+	LARGE_INTEGER start_counter_;
+};
+
+#endif // end __STARTUP_PROFILER_H__
@@ -0,0 +1,204 @@
+#include "StateCacheRenderDevice.h"
+
+#include <string.h>
+
+StateCacheRenderDevice::StateCacheRenderDevice(RenderDevice* device)
+	: device_(device)
+{
+	memset(&frame_stats_, 0, sizeof(frame_stats_));
+	memset(&last_frame_stats_, 0, sizeof(last_frame_stats_));
+
+	Invalidate();
+}
+
+StateCacheRenderDevice::~StateCacheRenderDevice(void)
+{
+}
+
+BufferHandle StateCacheRenderDevice::CreateVertexBuffer(const void* vertices, int size, VertexFormat format)
+{
+	return device_->CreateVertexBuffer(vertices, size, format);
+}
+
+BufferHandle StateCacheRenderDevice::CreateIndexBuffer(const unsigned short* indices, int num_indices)
+{
+	return device_->CreateIndexBuffer(indices, num_indices);
+}
+
+void StateCacheRenderDevice::UpdateBuffer(BufferHandle buffer, const void* data, int offset, int size)
+{
+	device_->UpdateBuffer(buffer, data, offset, size);
+}
+
+// The handle of a released resource may be reused by the next created one, so it must not stay cached
+void StateCacheRenderDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	if (buffer == vertex_buffer_)
+		vertex_buffer_ = kUnknown;
+	if (buffer == index_buffer_)
+		index_buffer_ = kUnknown;
+
+	device_->ReleaseBuffer(buffer);
+}
+
+TextureHandle StateCacheRenderDevice::CreateTexture(int width, int height, const unsigned int* pixels)
+{
+	return device_->CreateTexture(width, height, pixels);
+}
+
+void StateCacheRenderDevice::UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels)
+{
+	device_->UpdateTexture(texture, x, y, width, height, pixels);
+}
+
+void StateCacheRenderDevice::ReleaseTexture(TextureHandle texture)
+{
+	if (texture == texture_)
+		texture_ = kUnknown;
+
+	device_->ReleaseTexture(texture);
+}
+
+void StateCacheRenderDevice::SetTransform(TransformType type, const float* matrix)
+{
+	bool redundant = transform_valid_[type] && memcmp(transforms_[type], matrix, sizeof(transforms_[type])) == 0;
+	if (!CountStateChange(redundant))
+		return;
+
+	memcpy(transforms_[type], matrix, sizeof(transforms_[type]));
+	transform_valid_[type] = true;
+	device_->SetTransform(type, matrix);
+}
+
+void StateCacheRenderDevice::SetTexture(TextureHandle texture)
+{
+	if (!CountStateChange(texture == texture_))
+		return;
+
+	texture_ = texture;
+	device_->SetTexture(texture);
+}
+
+void StateCacheRenderDevice::SetStreamSource(BufferHandle vertex_buffer, int stride)
+{
+	if (!CountStateChange(vertex_buffer == vertex_buffer_ && stride == stride_))
+		return;
+
+	vertex_buffer_ = vertex_buffer;
+	stride_ = stride;
+	device_->SetStreamSource(vertex_buffer, stride);
+}
+
+void StateCacheRenderDevice::SetIndices(BufferHandle index_buffer)
+{
+	if (!CountStateChange(index_buffer == index_buffer_))
+		return;
+
+	index_buffer_ = index_buffer;
+	device_->SetIndices(index_buffer);
+}
+
+void StateCacheRenderDevice::SetVertexFormat(VertexFormat format)
+{
+	if (!CountStateChange(format == vertex_format_))
+		return;
+
+	vertex_format_ = format;
+	device_->SetVertexFormat(format);
+}
+
+void StateCacheRenderDevice::SetLight(int index, const Light& light)
+{
+	if (index < 0 || index >= kMaxLights)
+	{
+		CountStateChange(false);
+		device_->SetLight(index, light);
+		return;
+	}
+
+	bool redundant = light_valid_[index] && memcmp(&lights_[index], &light, sizeof(light)) == 0;
+	if (!CountStateChange(redundant))
+		return;
+
+	lights_[index] = light;
+	light_valid_[index] = true;
+	device_->SetLight(index, light);
+}
+
+void StateCacheRenderDevice::SetMaterial(const Material& material)
+{
+	bool redundant = material_valid_ && memcmp(&material_, &material, sizeof(material)) == 0;
+	if (!CountStateChange(redundant))
+		return;
+
+	material_ = material;
+	material_valid_ = true;
+	device_->SetMaterial(material);
+}
+
+void StateCacheRenderDevice::DrawIndexedPrimitive(PrimitiveType type, int num_vertices, int start_index, int primitive_count)
+{
+	device_->DrawIndexedPrimitive(type, num_vertices, start_index, primitive_count);
+}
+
+void StateCacheRenderDevice::DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances)
+{
+	device_->DrawIndexedInstanced(num_vertices, start_index, primitive_count, instances, num_instances);
+}
+
+void StateCacheRenderDevice::Clear(unsigned int color)
+{
+	device_->Clear(color);
+}
+
+bool StateCacheRenderDevice::BeginScene()
+{
+	return device_->BeginScene();
+}
+
+void StateCacheRenderDevice::EndScene()
+{
+	device_->EndScene();
+}
+
+bool StateCacheRenderDevice::Present()
+{
+	last_frame_stats_ = frame_stats_;
+	memset(&frame_stats_, 0, sizeof(frame_stats_));
+
+	return device_->Present();
+}
+
+void StateCacheRenderDevice::Invalidate()
+{
+	for (int i = 0; i < kNumTransformTypes; ++i)
+	{
+		transform_valid_[i] = false;
+	}
+
+	for (int i = 0; i < kMaxLights; ++i)
+	{
+		light_valid_[i] = false;
+	}
+
+	material_valid_ = false;
+	texture_        = kUnknown;
+	vertex_buffer_  = kUnknown;
+	stride_         = 0;
+	index_buffer_   = kUnknown;
+	vertex_format_  = kUnknown;
+}
+
+const StateCacheStats& StateCacheRenderDevice::GetFrameStats() const
+{
+	return last_frame_stats_;
+}
+
+bool StateCacheRenderDevice::CountStateChange(bool redundant)
+{
+	++frame_stats_.state_changes;
+	if (redundant)
+		++frame_stats_.states_saved;
+
+	return !redundant;
+}
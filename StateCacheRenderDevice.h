@@ -0,0 +1,80 @@
+#ifndef __STATE_CACHE_RENDER_DEVICE_H__
+#define __STATE_CACHE_RENDER_DEVICE_H__
+
+#include "RenderDevice.h"
+
+// State changes of one frame, see StateCacheRenderDevice::GetFrameStats
+struct StateCacheStats
+{
+	int state_changes;		// Set* calls made by the caller
+	int states_saved;		// Set* calls dropped because the value was already bound
+};
+
+// A render device which sits in front of another one and remembers the bound states, so
+// the Set* calls which set the value already bound are not passed to the device.
+// All other calls are passed through.
+class StateCacheRenderDevice : public RenderDevice
+{
+public:
+	// device is not owned
+	explicit StateCacheRenderDevice(RenderDevice* device);
+	~StateCacheRenderDevice(void);
+
+	BufferHandle CreateVertexBuffer(const void* vertices, int size, VertexFormat format);
+	BufferHandle CreateIndexBuffer(const unsigned short* indices, int num_indices);
+	void UpdateBuffer(BufferHandle buffer, const void* data, int offset, int size);
+	void ReleaseBuffer(BufferHandle buffer);
+
+	TextureHandle CreateTexture(int width, int height, const unsigned int* pixels);
+	void UpdateTexture(TextureHandle texture, int x, int y, int width, int height, const unsigned int* pixels);
+	void ReleaseTexture(TextureHandle texture);
+
+	void SetTransform(TransformType type, const float* matrix);
+	void SetTexture(TextureHandle texture);
+	void SetStreamSource(BufferHandle vertex_buffer, int stride);
+	void SetIndices(BufferHandle index_buffer);
+	void SetVertexFormat(VertexFormat format);
+	void SetLight(int index, const Light& light);
+	void SetMaterial(const Material& material);
+
+	void DrawIndexedPrimitive(PrimitiveType type, int num_vertices, int start_index, int primitive_count);
+	void DrawIndexedInstanced(int num_vertices, int start_index, int primitive_count, const InstanceData* instances, int num_instances);
+
+	void Clear(unsigned int color);
+	bool BeginScene();
+	void EndScene();
+	bool Present();
+
+	// Forget all the cached states, call it when the device lost its states(e.g. after device reset).
+	void Invalidate();
+
+	// Counters of the last presented frame
+	const StateCacheStats& GetFrameStats() const;
+
+private:
+	static const int kMaxLights = 8;
+	static const int kUnknown = -2;		// Cached handle/format value when the bound state is unknown
+
+	// Count a Set* call, return true if it should be passed to the device
+	bool CountStateChange(bool redundant);
+
+private:
+	RenderDevice* device_;
+
+	float transforms_[kNumTransformTypes][16];
+	bool transform_valid_[kNumTransformTypes];
+	TextureHandle texture_;
+	BufferHandle vertex_buffer_;
+	int stride_;
+	BufferHandle index_buffer_;
+	int vertex_format_;
+	Light lights_[kMaxLights];
+	bool light_valid_[kMaxLights];
+	Material material_;
+	bool material_valid_;
+
+	StateCacheStats frame_stats_;		// Counters of the current frame
+	StateCacheStats last_frame_stats_;	// Counters of the last presented frame
+};
+
+#endif // end __STATE_CACHE_RENDER_DEVICE_H__
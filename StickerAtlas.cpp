@@ -0,0 +1,196 @@
+#include "StickerAtlas.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define STICKER_ATLAS_SSE2
+#include <emmintrin.h>
+#endif
+
+static const unsigned int kAtlasFileMagic   = 0x54414352;	// "RCAT"
+static const unsigned int kAtlasFileVersion = 1;
+
+// Header of the cached atlas file, followed by width x height ARGB pixels
+struct AtlasFileHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	int tile_width;
+	int tile_height;
+	int border_width;
+	unsigned int border_color;
+	int width;
+	int height;
+};
+
+StickerAtlas::StickerAtlas(void)
+	: tile_width_(0),
+	  tile_height_(0),
+	  border_width_(0),
+	  border_color_(0)
+{
+}
+
+StickerAtlas::~StickerAtlas(void)
+{
+}
+
+/*
+The tiles are placed from left to right:
+	---------------------------------
+	|  -----------  |               |
+	|  |         |  |               |
+	|  | sticker |  |     inner     |
+	|  |         |  |               |
+	|  -----------  |               |
+	---------------------------------
+*/
+void StickerAtlas::Generate(int tile_width, int tile_height, int border_width, unsigned int border_color)
+{
+	tile_width_   = tile_width;
+	tile_height_  = tile_height;
+	border_width_ = border_width;
+	border_color_ = border_color;
+
+	int width  = GetWidth();
+	int height = GetHeight();
+	int pitch  = width * sizeof(unsigned int);
+	pixels_.resize(width * height);
+
+	// Both tiles are white, then draw the border of the sticker tile
+	FillRect(&pixels_[0], pitch, 0, 0, width, height, 0xffffffff);
+
+	int x = kStickerTile * tile_width_;
+	FillRect(&pixels_[0], pitch, x, 0, tile_width_, border_width_, border_color_);								// Top
+	FillRect(&pixels_[0], pitch, x, tile_height_ - border_width_, tile_width_, border_width_, border_color_);	// Bottom
+	FillRect(&pixels_[0], pitch, x, 0, border_width_, tile_height_, border_color_);								// Left
+	FillRect(&pixels_[0], pitch, x + tile_width_ - border_width_, 0, border_width_, tile_height_, border_color_);	// Right
+}
+
+bool StickerAtlas::Load(const char* file_name, int tile_width, int tile_height, int border_width, unsigned int border_color)
+{
+	FILE* file = fopen(file_name, "rb");
+	if (file == NULL)
+		return false;
+
+	AtlasFileHeader header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& header.magic        == kAtlasFileMagic
+		&& header.version      == kAtlasFileVersion
+		&& header.tile_width   == tile_width
+		&& header.tile_height  == tile_height
+		&& header.border_width == border_width
+		&& header.border_color == border_color
+		&& header.width        == tile_width * kNumTiles
+		&& header.height       == tile_height;
+
+	if (valid)
+	{
+		std::vector<unsigned int> pixels(header.width * header.height);
+		valid = fread(&pixels[0], sizeof(unsigned int), pixels.size(), file) == pixels.size();
+
+		if (valid)
+		{
+			tile_width_   = tile_width;
+			tile_height_  = tile_height;
+			border_width_ = border_width;
+			border_color_ = border_color;
+			pixels_.swap(pixels);
+		}
+	}
+
+	fclose(file);
+	return valid;
+}
+
+bool StickerAtlas::Save(const char* file_name) const
+{
+	if (pixels_.empty())
+		return false;
+
+	FILE* file = fopen(file_name, "wb");
+	if (file == NULL)
+		return false;
+
+	AtlasFileHeader header;
+	header.magic        = kAtlasFileMagic;
+	header.version      = kAtlasFileVersion;
+	header.tile_width   = tile_width_;
+	header.tile_height  = tile_height_;
+	header.border_width = border_width_;
+	header.border_color = border_color_;
+	header.width        = GetWidth();
+	header.height       = GetHeight();
+
+	bool succeeded = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(&pixels_[0], sizeof(unsigned int), pixels_.size(), file) == pixels_.size();
+
+	fclose(file);
+	return succeeded;
+}
+
+int StickerAtlas::GetWidth() const
+{
+	return tile_width_ * kNumTiles;
+}
+
+int StickerAtlas::GetHeight() const
+{
+	return tile_height_;
+}
+
+const unsigned int* StickerAtlas::GetPixels() const
+{
+	return &pixels_[0];
+}
+
+void StickerAtlas::GetTileRect(Tile tile, float* rect) const
+{
+	GetTileRect(tile, tile_width_, tile_height_, rect);
+}
+
+void StickerAtlas::GetTileRect(Tile tile, int tile_width, int tile_height, float* rect)
+{
+	float width  = (float)(kNumTiles * tile_width);
+	float height = (float)tile_height;
+
+	rect[0] = (tile * tile_width + 0.5f) / width;
+	rect[1] = 0.5f / height;
+	rect[2] = (tile_width - 1.0f) / width;
+	rect[3] = (tile_height - 1.0f) / height;
+}
+
+// Rows are filled 4 pixels at a time with aligned SSE2 stores, the unaligned head and tail
+// of each row are filled one by one. Rows start pitch bytes apart, which may be more than the row size.
+void StickerAtlas::FillRect(void* pixels, int pitch, int x, int y, int width, int height, unsigned int color)
+{
+#ifdef STICKER_ATLAS_SSE2
+	__m128i value = _mm_set1_epi32((int)color);
+#endif
+
+	for (int i = 0; i < height; ++i)
+	{
+		unsigned int* p = (unsigned int*)((unsigned char*)pixels + (y + i) * pitch) + x;
+		int count = width;
+
+#ifdef STICKER_ATLAS_SSE2
+		while (count > 0 && ((size_t)p & 15) != 0)
+		{
+			*p++ = color;
+			--count;
+		}
+
+		for (; count >= 4; count -= 4, p += 4)
+		{
+			_mm_store_si128((__m128i*)p, value);
+		}
+#endif
+
+		while (count > 0)
+		{
+			*p++ = color;
+			--count;
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef __STICKER_ATLAS_H__
+#define __STICKER_ATLAS_H__
+
+#include <vector>
+
+// One texture holding all the face patterns of the unit cubes side by side: the sticker with
+// its border and the plain inner face. Both are white, the face colors are applied by the
+// instance colors, so one atlas serves every cube and the texture is bound once per frame.
+class StickerAtlas
+{
+public:
+	enum Tile
+	{
+		kStickerTile = 0,
+		kInnerTile   = 1,
+
+		kNumTiles    = 2
+	};
+
+	StickerAtlas(void);
+	~StickerAtlas(void);
+
+	void Generate(int tile_width, int tile_height, int border_width, unsigned int border_color);
+
+	// Load the atlas saved by Save, return false if the file is missing, broken or was generated
+	// with other parameters.
+	bool Load(const char* file_name, int tile_width, int tile_height, int border_width, unsigned int border_color);
+	bool Save(const char* file_name) const;
+
+	int GetWidth() const;
+	int GetHeight() const;
+	const unsigned int* GetPixels() const;	// ARGB, GetWidth() pixels per row
+
+	// Texture rectangle(u, v, width, height) of a tile, inset by half a texel so the neighbour tile
+	// is never sampled.
+	void GetTileRect(Tile tile, float* rect) const;
+
+	// The tile rectangle of any atlas with these tile sizes, before it is generated
+	static void GetTileRect(Tile tile, int tile_width, int tile_height, float* rect);
+
+	// Fill a rectangle of a 32-bit image with one color, pitch is the row size in bytes.
+	static void FillRect(void* pixels, int pitch, int x, int y, int width, int height, unsigned int color);
+
+private:
+	int tile_width_;
+	int tile_height_;
+	int border_width_;
+	unsigned int border_color_;
+	std::vector<unsigned int> pixels_;
+};
+
+#endif // end __STICKER_ATLAS_H__
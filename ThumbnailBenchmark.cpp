@@ -0,0 +1,129 @@
+#include "ThumbnailBenchmark.h"
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "ThumbnailRenderer.h"
+#include "VectorMath.h"
+
+static const int kNumLayers    = 3;		// Layers of the rendered cubes
+static const int kNumStates    = 4096;	// States in the batch
+static const int kTurnsPerState = 4;	// Random turns from one state to the next
+static const int kImageSize    = 64;	// Width and height of the thumbnails in pixels
+static const int kRepeats      = 5;		// The fastest batch is reported
+
+static double GetTime()
+{
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart * 1000.0 / frequency.QuadPart;
+}
+
+// Render the batch, return the fastest batch time in milliseconds, the pixels keep the last image of each state
+static double RenderBatch(const ThumbnailRenderer& renderer, const std::vector<CubeState>& states, std::vector<unsigned int>* pixels)
+{
+	int image_pixels = kImageSize * kImageSize;
+	double best_time = 0;
+
+	for (int repeat = 0; repeat < kRepeats; ++repeat)
+	{
+		double start = GetTime();
+		for (size_t i = 0; i < states.size(); ++i)
+			renderer.Render(states[i], &(*pixels)[i * image_pixels], kImageSize);
+
+		double time = GetTime() - start;
+		best_time = repeat == 0 ? time : min(best_time, time);
+	}
+
+	return best_time;
+}
+
+// The pixel at the center of each sticker of the net layout has the color of its facelet
+static int CountNetMismatches(const std::vector<CubeState>& states, const std::vector<unsigned int>& pixels, const unsigned int* face_colors)
+{
+	// Cell of each face in the 4 x 3 grid, as in ThumbnailRenderer::SetNetLayout
+	const int kFaceCell[6][2] = { {1, 1}, {3, 1}, {0, 1}, {2, 1}, {1, 0}, {1, 2} };
+
+	float cell_size = kImageSize / 4.0f;
+	float origin_y = (kImageSize - 3 * cell_size) / 2;
+	float sticker_size = cell_size / kNumLayers;
+
+	int num_mismatches = 0;
+	for (size_t i = 0; i < states.size(); ++i)
+	{
+		const unsigned int* image = &pixels[i * kImageSize * kImageSize];
+		for (int face = 0; face < 6; ++face)
+		{
+			for (int row = 0; row < kNumLayers; ++row)
+			{
+				for (int col = 0; col < kNumLayers; ++col)
+				{
+					int x = (int)(kFaceCell[face][0] * cell_size + (col + 0.5f) * sticker_size);
+					int y = (int)(origin_y + kFaceCell[face][1] * cell_size + (row + 0.5f) * sticker_size);
+					if (image[y * kImageSize + x] != face_colors[states[i].GetFacelet(face, row, col)])
+						++num_mismatches;
+				}
+			}
+		}
+	}
+
+	return num_mismatches;
+}
+
+bool RunThumbnailBenchmark(const char* file_name)
+{
+	FILE* file = fopen(file_name, "w");
+	if (file == NULL)
+		return false;
+
+	srand(1);
+
+	// A random walk of states, each a few turns from the one before
+	std::vector<CubeState> states(kNumStates, CubeState(kNumLayers));
+	for (int i = 1; i < kNumStates; ++i)
+	{
+		states[i] = states[i - 1];
+		for (int j = 0; j < kTurnsPerState; ++j)
+			states[i].RotateLayer(rand() % (3 * kNumLayers), 1 + rand() % 3);
+	}
+
+	unsigned int face_colors[6] = { 0xffffffff, 0xffffff00, 0xffff0000, 0xffffa500, 0xff00ff00, 0xff0000ff };
+	ThumbnailRenderer renderer(kNumLayers, kImageSize, kImageSize);
+	renderer.SetFaceColors(face_colors);
+
+	std::vector<unsigned int> pixels(kNumStates * kImageSize * kImageSize);
+
+	renderer.SetNetLayout();
+	int net_spans = renderer.GetNumSpans();
+	double net_time = RenderBatch(renderer, states, &pixels);
+	int num_mismatches = CountNetMismatches(states, pixels, face_colors);
+
+	// A camera in front of the top left corner, as the app starts
+	float cube_length = 10.0f;
+	float gap = 0.15f;
+	Vector3 eye(-45.0f, 45.0f, -60.0f);
+	Vector3 at(0, 0, 0);
+	Vector3 up(0, 1, 0);
+	Matrix view;
+	Matrix proj;
+	MatrixLookAtLH(&view, &eye, &at, &up);
+	MatrixPerspectiveFovLH(&proj, kPi / 4, 1.0f, 1.0f, 1000.0f);
+
+	renderer.SetCameraLayout(view, proj, cube_length, gap);
+	int camera_spans = renderer.GetNumSpans();
+	double camera_time = RenderBatch(renderer, states, &pixels);
+
+	renderer.WriteSVG(states[kNumStates - 1], "Thumbnail.svg");
+
+	fprintf(file, "Thumbnails: %d states of a %d x %d cube, %d x %d pixels\n", kNumStates, kNumLayers, kNumLayers, kImageSize, kImageSize);
+	fprintf(file, "  net layout    %5d spans %9.3f ms  %9.0f images/s\n", net_spans, net_time, net_time > 0 ? kNumStates * 1000.0 / net_time : 0);
+	fprintf(file, "  camera layout %5d spans %9.3f ms  %9.0f images/s\n", camera_spans, camera_time, camera_time > 0 ? kNumStates * 1000.0 / camera_time : 0);
+	fprintf(file, "  net sticker mismatches %d\n", num_mismatches);
+
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,10 @@
+#ifndef __THUMBNAIL_BENCHMARK_H__
+#define __THUMBNAIL_BENCHMARK_H__
+
+// Renders a batch of shuffled cube states with ThumbnailRenderer in the net and the camera layout,
+// reports the images per second of each, checks the sticker colors of the net images against the
+// states, and writes the results as text and the last state as Thumbnail.svg.
+// Return false if the file could not be written.
+bool RunThumbnailBenchmark(const char* file_name);
+
+#endif // end __THUMBNAIL_BENCHMARK_H__
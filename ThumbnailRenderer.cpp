@@ -0,0 +1,357 @@
+#include "ThumbnailRenderer.h"
+
+#include <math.h>
+#include <stdio.h>
+
+static const float kStickerBorder = 0.08f;	// Border width around each sticker, relative to the sticker size
+
+ThumbnailRenderer::ThumbnailRenderer(int num_layers, int width, int height)
+	: num_layers_(num_layers),
+	  width_(width),
+	  height_(height),
+	  border_color_(0xff121212),
+	  background_color_(0xff4f94cd)
+{
+	unsigned int colors[] =
+	{
+		0xffffffff, // White,   front face
+		0xffffff00, // Yellow,	back face
+		0xffff0000, // Red,		left face
+		0xffffa500,	// Orange,	right face
+		0xff00ff00, // Green,	top face
+		0xff0000ff, // Blue,	bottom face
+	};
+	SetFaceColors(colors);
+
+	SetNetLayout();
+}
+
+ThumbnailRenderer::~ThumbnailRenderer(void)
+{
+}
+
+/*
+Each visible face is drawn as one border quad covering the whole face, then one quad for each sticker,
+the sticker quad is the face of its unit cube shrunk by the border width. The cube is convex, so the
+visible faces never overlap and no depth sorting is needed.
+*/
+void ThumbnailRenderer::SetCameraLayout(const float* view, const float* proj, float cube_length, float gap)
+{
+	polygons_.clear();
+
+	// view_proj = view * proj
+	float m[16];
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			m[i * 4 + j] = view[i * 4 + 0] * proj[0 * 4 + j] + view[i * 4 + 1] * proj[1 * 4 + j]
+				         + view[i * 4 + 2] * proj[2 * 4 + j] + view[i * 4 + 3] * proj[3 * 4 + j];
+		}
+	}
+
+	float half_face_length = (num_layers_ * cube_length + (num_layers_ - 1) * gap) / 2;
+	float border = cube_length * kStickerBorder;
+
+	for (int face = 0; face < 6; ++face)
+	{
+		int normal[3];
+		int right[3];
+		int up[3];
+		CubeState::GetFaceAxes(face, normal, right, up);
+
+		// Project the point at (a, b) in the face plane, a along right and b along up
+		auto project = [&](float a, float b, float* x, float* y) -> bool
+		{
+			float p[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				p[i] = normal[i] * half_face_length + right[i] * a + up[i] * b;
+			}
+
+			float cx = p[0] * m[0] + p[1] * m[4] + p[2] * m[8]  + m[12];
+			float cy = p[0] * m[1] + p[1] * m[5] + p[2] * m[9]  + m[13];
+			float cw = p[0] * m[3] + p[1] * m[7] + p[2] * m[11] + m[15];
+			if (cw <= 0.0f)
+				return false;
+
+			*x = (cx / cw * 0.5f + 0.5f) * width_;
+			*y = (0.5f - cy / cw * 0.5f) * height_;
+			return true;
+		};
+
+		// Quad corners in clockwise order as seen from outside: bottom-left, top-left, top-right, bottom-right
+		Polygon border_polygon;
+		border_polygon.id = kBorder;
+		if (!project(-half_face_length, -half_face_length, &border_polygon.x[0], &border_polygon.y[0])
+			|| !project(-half_face_length,  half_face_length, &border_polygon.x[1], &border_polygon.y[1])
+			|| !project( half_face_length,  half_face_length, &border_polygon.x[2], &border_polygon.y[2])
+			|| !project( half_face_length, -half_face_length, &border_polygon.x[3], &border_polygon.y[3]))
+			continue;
+
+		// Skip the back faces, same as the counter-clockwise culling of the render devices
+		float area = (border_polygon.x[1] - border_polygon.x[0]) * (border_polygon.y[2] - border_polygon.y[0])
+			       - (border_polygon.x[2] - border_polygon.x[0]) * (border_polygon.y[1] - border_polygon.y[0]);
+		if (area <= 0.0f)
+			continue;
+
+		polygons_.push_back(border_polygon);
+
+		for (int row = 0; row < num_layers_; ++row)
+		{
+			for (int col = 0; col < num_layers_; ++col)
+			{
+				float min_a = col * (cube_length + gap) - half_face_length + border;
+				float max_a = min_a + cube_length - 2 * border;
+				float max_b = half_face_length - row * (cube_length + gap) - border;
+				float min_b = max_b - cube_length + 2 * border;
+
+				Polygon sticker;
+				sticker.id = face * num_layers_ * num_layers_ + row * num_layers_ + col;
+				project(min_a, min_b, &sticker.x[0], &sticker.y[0]);
+				project(min_a, max_b, &sticker.x[1], &sticker.y[1]);
+				project(max_a, max_b, &sticker.x[2], &sticker.y[2]);
+				project(max_a, min_b, &sticker.x[3], &sticker.y[3]);
+				polygons_.push_back(sticker);
+			}
+		}
+	}
+
+	BuildSpans();
+}
+
+void ThumbnailRenderer::SetNetLayout()
+{
+	polygons_.clear();
+
+	// Cell of each face in the 4 x 3 grid, in the order of the Face enum
+	const int kFaceCell[6][2] = { {1, 1}, {3, 1}, {0, 1}, {2, 1}, {1, 0}, {1, 2} };
+
+	float cell_size = width_ / 4.0f < height_ / 3.0f ? width_ / 4.0f : height_ / 3.0f;
+	float origin_x = (width_ - 4 * cell_size) / 2;
+	float origin_y = (height_ - 3 * cell_size) / 2;
+	float sticker_size = cell_size / num_layers_;
+	float border = sticker_size * kStickerBorder;
+
+	for (int face = 0; face < 6; ++face)
+	{
+		float cell_x = origin_x + kFaceCell[face][0] * cell_size;
+		float cell_y = origin_y + kFaceCell[face][1] * cell_size;
+
+		for (int row = -1; row < num_layers_; ++row)
+		{
+			for (int col = 0; col < num_layers_; ++col)
+			{
+				Polygon polygon;
+				float left, top, size;
+
+				// Row -1 is the border quad of the whole face
+				if (row < 0)
+				{
+					if (col > 0)
+						break;
+
+					polygon.id = kBorder;
+					left = cell_x;
+					top  = cell_y;
+					size = cell_size;
+				}
+				else
+				{
+					polygon.id = face * num_layers_ * num_layers_ + row * num_layers_ + col;
+					left = cell_x + col * sticker_size + border;
+					top  = cell_y + row * sticker_size + border;
+					size = sticker_size - 2 * border;
+				}
+
+				polygon.x[0] = left;        polygon.y[0] = top + size;
+				polygon.x[1] = left;        polygon.y[1] = top;
+				polygon.x[2] = left + size; polygon.y[2] = top;
+				polygon.x[3] = left + size; polygon.y[3] = top + size;
+				polygons_.push_back(polygon);
+			}
+		}
+	}
+
+	BuildSpans();
+}
+
+// Rasterize the polygons into an id image at pixel centers, then run-length encode each row.
+void ThumbnailRenderer::BuildSpans()
+{
+	std::vector<int> ids(width_ * height_, kBackground);
+
+	for (size_t i = 0; i < polygons_.size(); ++i)
+	{
+		const Polygon& polygon = polygons_[i];
+
+		float min_x = polygon.x[0], max_x = polygon.x[0];
+		float min_y = polygon.y[0], max_y = polygon.y[0];
+		for (int j = 1; j < 4; ++j)
+		{
+			min_x = polygon.x[j] < min_x ? polygon.x[j] : min_x;
+			max_x = polygon.x[j] > max_x ? polygon.x[j] : max_x;
+			min_y = polygon.y[j] < min_y ? polygon.y[j] : min_y;
+			max_y = polygon.y[j] > max_y ? polygon.y[j] : max_y;
+		}
+
+		int x0 = (int)floorf(min_x) < 0 ? 0 : (int)floorf(min_x);
+		int y0 = (int)floorf(min_y) < 0 ? 0 : (int)floorf(min_y);
+		int x1 = (int)ceilf(max_x) > width_ - 1 ? width_ - 1 : (int)ceilf(max_x);
+		int y1 = (int)ceilf(max_y) > height_ - 1 ? height_ - 1 : (int)ceilf(max_y);
+
+		for (int y = y0; y <= y1; ++y)
+		{
+			float py = y + 0.5f;
+			for (int x = x0; x <= x1; ++x)
+			{
+				float px = x + 0.5f;
+
+				bool inside = true;
+				for (int j = 0; j < 4 && inside; ++j)
+				{
+					int k = (j + 1) % 4;
+					float edge = (polygon.x[k] - polygon.x[j]) * (py - polygon.y[j])
+						       - (polygon.y[k] - polygon.y[j]) * (px - polygon.x[j]);
+					inside = edge >= 0.0f;
+				}
+
+				if (inside)
+					ids[y * width_ + x] = polygon.id;
+			}
+		}
+	}
+
+	spans_.clear();
+	row_spans_.resize(height_ + 1);
+
+	for (int y = 0; y < height_; ++y)
+	{
+		row_spans_[y] = (int)spans_.size();
+
+		const int* row = &ids[y * width_];
+		int start = 0;
+		for (int x = 1; x <= width_; ++x)
+		{
+			if (x == width_ || row[x] != row[start])
+			{
+				Span span;
+				span.x = start;
+				span.length = x - start;
+				span.id = row[start];
+				spans_.push_back(span);
+				start = x;
+			}
+		}
+	}
+
+	row_spans_[height_] = (int)spans_.size();
+}
+
+void ThumbnailRenderer::SetFaceColors(const unsigned int* face_colors)
+{
+	for (int i = 0; i < 6; ++i)
+	{
+		face_colors_[i] = face_colors[i];
+	}
+}
+
+void ThumbnailRenderer::SetBorderColor(unsigned int border_color)
+{
+	border_color_ = border_color;
+}
+
+void ThumbnailRenderer::SetBackgroundColor(unsigned int background_color)
+{
+	background_color_ = background_color;
+}
+
+int ThumbnailRenderer::GetWidth() const
+{
+	return width_;
+}
+
+int ThumbnailRenderer::GetHeight() const
+{
+	return height_;
+}
+
+int ThumbnailRenderer::GetNumSpans() const
+{
+	return (int)spans_.size();
+}
+
+unsigned int ThumbnailRenderer::GetColor(const CubeState& state, int id) const
+{
+	if (id == kBackground)
+		return background_color_;
+	if (id == kBorder)
+		return border_color_;
+
+	return face_colors_[state.GetFacelets()[id]];
+}
+
+void ThumbnailRenderer::Render(const CubeState& state, unsigned int* pixels, int pitch) const
+{
+	const unsigned char* facelets = state.GetFacelets();
+
+	// Color of the span ids, shifted by 2 so the background and border ids index the table too
+	unsigned int colors[2 + 6];
+	colors[2 + kBackground] = background_color_;
+	colors[2 + kBorder] = border_color_;
+
+	for (int y = 0; y < height_; ++y)
+	{
+		unsigned int* row = pixels + y * pitch;
+
+		for (int i = row_spans_[y]; i < row_spans_[y + 1]; ++i)
+		{
+			const Span& span = spans_[i];
+			unsigned int color = span.id >= 0 ? face_colors_[facelets[span.id]] : colors[2 + span.id];
+
+			unsigned int* p = row + span.x;
+			for (int j = 0; j < span.length; ++j)
+			{
+				p[j] = color;
+			}
+		}
+	}
+}
+
+std::string ThumbnailRenderer::GetSVG(const CubeState& state) const
+{
+	char buffer[256];
+	std::string svg;
+
+	sprintf(buffer, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n",
+		width_, height_, width_, height_);
+	svg += buffer;
+
+	sprintf(buffer, "<rect width=\"%d\" height=\"%d\" fill=\"#%06x\"/>\n", width_, height_, background_color_ & 0xffffff);
+	svg += buffer;
+
+	for (size_t i = 0; i < polygons_.size(); ++i)
+	{
+		const Polygon& polygon = polygons_[i];
+		sprintf(buffer, "<polygon points=\"%.2f,%.2f %.2f,%.2f %.2f,%.2f %.2f,%.2f\" fill=\"#%06x\"/>\n",
+			polygon.x[0], polygon.y[0], polygon.x[1], polygon.y[1],
+			polygon.x[2], polygon.y[2], polygon.x[3], polygon.y[3],
+			GetColor(state, polygon.id) & 0xffffff);
+		svg += buffer;
+	}
+
+	svg += "</svg>\n";
+	return svg;
+}
+
+bool ThumbnailRenderer::WriteSVG(const CubeState& state, const char* file_name) const
+{
+	FILE* file = fopen(file_name, "wb");
+	if (file == NULL)
+		return false;
+
+	std::string svg = GetSVG(state);
+	fwrite(svg.c_str(), 1, svg.size(), file);
+	fclose(file);
+	return true;
+}
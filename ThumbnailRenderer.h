@@ -0,0 +1,80 @@
+#ifndef __THUMBNAIL_RENDERER_H__
+#define __THUMBNAIL_RENDERER_H__
+
+#include <string>
+#include <vector>
+
+#include "CubeState.h"
+
+// Renders many cube states from one fixed view into small images.
+//
+// The layout(a camera or the flat net) is computed once: the screen space polygon of every
+// visible sticker is projected and rasterized into horizontal spans, each span belongs to one
+// facelet, the border or the background. Rendering a state only fills the spans with the
+// facelet colors, so there is no transform, no depth test and no per-pixel coverage test.
+class ThumbnailRenderer
+{
+public:
+	ThumbnailRenderer(int num_layers, int width, int height);
+	~ThumbnailRenderer(void);
+
+	// Lay out the cube as seen by a fixed camera, view and proj are row-major 4 x 4 matrices
+	// as passed to RenderDevice::SetTransform. The cube is built as in RubikCube, centered at
+	// the origin, with unit cubes of cube_length and gaps between the layers.
+	void SetCameraLayout(const float* view, const float* proj, float cube_length, float gap);
+
+	// Lay out the 6 faces as the unfolded cross net, see CubeState.
+	void SetNetLayout();
+
+	void SetFaceColors(const unsigned int* face_colors);	// 6 ARGB colors indexed by facelet color
+	void SetBorderColor(unsigned int border_color);
+	void SetBackgroundColor(unsigned int background_color);
+
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetNumSpans() const;
+
+	// Render a state to width x height ARGB pixels, pitch is the number of pixels per row.
+	void Render(const CubeState& state, unsigned int* pixels, int pitch) const;
+
+	// The same image as SVG polygons, resolution independent.
+	std::string GetSVG(const CubeState& state) const;
+	bool WriteSVG(const CubeState& state, const char* file_name) const;
+
+private:
+	static const int kBackground = -1;		// Span/polygon id of the background
+	static const int kBorder = -2;			// Span/polygon id of the border and the gaps between stickers
+
+	// A convex quad in screen space, clockwise on screen
+	struct Polygon
+	{
+		float x[4];
+		float y[4];
+		int id;		// Facelet index, kBorder or kBackground
+	};
+
+	struct Span
+	{
+		int x;
+		int length;
+		int id;
+	};
+
+	void BuildSpans();
+	unsigned int GetColor(const CubeState& state, int id) const;
+
+private:
+	int num_layers_;
+	int width_;
+	int height_;
+
+	unsigned int face_colors_[6];
+	unsigned int border_color_;
+	unsigned int background_color_;
+
+	std::vector<Polygon> polygons_;		// Drawn in order, later polygons cover former ones
+	std::vector<Span> spans_;			// Spans of all rows
+	std::vector<int> row_spans_;		// First span of each row, height + 1 values
+};
+
+#endif // end __THUMBNAIL_RENDERER_H__
@@ -0,0 +1,61 @@
+#ifndef __TRIPLE_BUFFER_H__
+#define __TRIPLE_BUFFER_H__
+
+#include <atomic>
+
+// Hands the latest value from one writer thread to one reader thread without locks.
+// The writer fills the back buffer and publishes it, the reader takes the latest published
+// buffer as its front buffer. Each side owns one of the 3 buffers at any time, the third one
+// is swapped between them through one atomic index, so neither side ever waits and the reader
+// never sees a buffer being written. Values published while the reader is busy are skipped.
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer(void)
+		: ready_(1),
+		  back_(0),
+		  front_(2)
+	{
+	}
+
+	// Writer side, the buffer to fill, it keeps the content from its last use
+	T& GetBack()
+	{
+		return buffers_[back_];
+	}
+
+	// Writer side, publish the back buffer and take the ready buffer as the next back buffer
+	void Publish()
+	{
+		back_ = ready_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndexMask;
+	}
+
+	// Reader side, take the latest published buffer as the front buffer, return false if
+	// nothing was published since the last call
+	bool Update()
+	{
+		if ((ready_.load(std::memory_order_relaxed) & kFresh) == 0)
+			return false;
+
+		front_ = ready_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+		return true;
+	}
+
+	// Reader side, the buffer taken by the last Update
+	const T& GetFront() const
+	{
+		return buffers_[front_];
+	}
+
+private:
+	static const int kIndexMask = 3;
+	static const int kFresh     = 4;	// Set in ready_ when the ready buffer was not read yet
+
+	T buffers_[3];
+	std::atomic<int> ready_;	// Index of the buffer between the sides, and kFresh
+	int back_;					// Owned by the writer
+	int front_;					// Owned by the reader
+};
+
+#endif // end __TRIPLE_BUFFER_H__
@@ -0,0 +1,589 @@
+#ifndef __VECTOR_MATH_H__
+#define __VECTOR_MATH_H__
+
+// Vector, matrix, quaternion and plane math of the cube engine, header only and without D3DX,
+// so the engine also builds where there is no DirectX SDK. The types have the memory layout of the
+// D3DX types and the functions the same conventions: row vectors, row-major matrices multiplied
+// as v * M, left-handed rotations, and D3DXQuaternionMultiply(q1, q2) being q1 then q2.
+// The functions take an out pointer first and return it, like D3DX.
+//
+// Matrix multiply and the array transforms have SSE and NEON paths, MATH_NO_SIMD turns them off,
+// the *Scalar functions are the reference versions of them.
+
+#include <math.h>
+#include <string.h>
+
+#if !defined(MATH_NO_SIMD) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__))
+#define MATH_SSE
+#include <xmmintrin.h>
+#elif !defined(MATH_NO_SIMD) && defined(__ARM_NEON)
+#define MATH_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#define MATH_ALIGN16 __declspec(align(16))
+#else
+#define MATH_ALIGN16 __attribute__((aligned(16)))
+#endif
+
+const float kPi = 3.141592654f;
+
+struct Vector3
+{
+	float x, y, z;
+
+	Vector3() {}
+	Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+	operator float*() { return &x; }
+	operator const float*() const { return &x; }
+
+	Vector3& operator+=(const Vector3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+	Vector3& operator-=(const Vector3& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+	Vector3& operator*=(float f) { x *= f; y *= f; z *= f; return *this; }
+	Vector3& operator/=(float f) { float inv = 1.0f / f; x *= inv; y *= inv; z *= inv; return *this; }
+
+	Vector3 operator+() const { return *this; }
+	Vector3 operator-() const { return Vector3(-x, -y, -z); }
+
+	Vector3 operator+(const Vector3& v) const { return Vector3(x + v.x, y + v.y, z + v.z); }
+	Vector3 operator-(const Vector3& v) const { return Vector3(x - v.x, y - v.y, z - v.z); }
+	Vector3 operator*(float f) const { return Vector3(x * f, y * f, z * f); }
+	Vector3 operator/(float f) const { float inv = 1.0f / f; return Vector3(x * inv, y * inv, z * inv); }
+
+	bool operator==(const Vector3& v) const { return x == v.x && y == v.y && z == v.z; }
+	bool operator!=(const Vector3& v) const { return !(*this == v); }
+};
+
+inline Vector3 operator*(float f, const Vector3& v)
+{
+	return Vector3(v.x * f, v.y * f, v.z * f);
+}
+
+struct Quaternion
+{
+	float x, y, z, w;
+
+	Quaternion() {}
+	Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+	operator float*() { return &x; }
+	operator const float*() const { return &x; }
+
+	Quaternion operator*(const Quaternion& q) const;
+	Quaternion& operator*=(const Quaternion& q);
+
+	bool operator==(const Quaternion& q) const { return x == q.x && y == q.y && z == q.z && w == q.w; }
+	bool operator!=(const Quaternion& q) const { return !(*this == q); }
+};
+
+struct Matrix
+{
+	union
+	{
+		struct
+		{
+			float _11, _12, _13, _14;
+			float _21, _22, _23, _24;
+			float _31, _32, _33, _34;
+			float _41, _42, _43, _44;
+		};
+		float m[4][4];
+	};
+
+	Matrix() {}
+	explicit Matrix(const float* f) { memcpy(m, f, sizeof(m)); }
+	Matrix(float f11, float f12, float f13, float f14,
+		   float f21, float f22, float f23, float f24,
+		   float f31, float f32, float f33, float f34,
+		   float f41, float f42, float f43, float f44)
+	{
+		_11 = f11; _12 = f12; _13 = f13; _14 = f14;
+		_21 = f21; _22 = f22; _23 = f23; _24 = f24;
+		_31 = f31; _32 = f32; _33 = f33; _34 = f34;
+		_41 = f41; _42 = f42; _43 = f43; _44 = f44;
+	}
+
+	float& operator()(int row, int column) { return m[row][column]; }
+	float operator()(int row, int column) const { return m[row][column]; }
+
+	operator float*() { return &_11; }
+	operator const float*() const { return &_11; }
+
+	Matrix operator*(const Matrix& matrix) const;
+	Matrix& operator*=(const Matrix& matrix);
+
+	bool operator==(const Matrix& matrix) const { return memcmp(m, matrix.m, sizeof(m)) == 0; }
+	bool operator!=(const Matrix& matrix) const { return !(*this == matrix); }
+};
+
+// 16 byte aligned matrix for members and locals, a plain Matrix is used for parameters and containers
+struct MATH_ALIGN16 MatrixA16 : public Matrix
+{
+	MatrixA16() {}
+	MatrixA16(const Matrix& matrix) : Matrix(matrix) {}
+	MatrixA16& operator=(const Matrix& matrix) { Matrix::operator=(matrix); return *this; }
+};
+
+// Plane a * x + b * y + c * z + d = 0
+struct Plane
+{
+	float a, b, c, d;
+
+	Plane() {}
+	Plane(float a, float b, float c, float d) : a(a), b(b), c(c), d(d) {}
+};
+
+// Vector3
+
+inline float Vec3Dot(const Vector3* v1, const Vector3* v2)
+{
+	return v1->x * v2->x + v1->y * v2->y + v1->z * v2->z;
+}
+
+inline float Vec3Length(const Vector3* v)
+{
+	return sqrtf(Vec3Dot(v, v));
+}
+
+inline Vector3* Vec3Cross(Vector3* out, const Vector3* v1, const Vector3* v2)
+{
+	Vector3 result(v1->y * v2->z - v1->z * v2->y,
+				   v1->z * v2->x - v1->x * v2->z,
+				   v1->x * v2->y - v1->y * v2->x);
+	*out = result;
+	return out;
+}
+
+// A zero vector stays zero
+inline Vector3* Vec3Normalize(Vector3* out, const Vector3* v)
+{
+	float length = Vec3Length(v);
+	if (length == 0)
+		*out = Vector3(0, 0, 0);
+	else
+		*out = *v / length;
+	return out;
+}
+
+inline Vector3* Vec3Minimize(Vector3* out, const Vector3* v1, const Vector3* v2)
+{
+	*out = Vector3(v1->x < v2->x ? v1->x : v2->x, v1->y < v2->y ? v1->y : v2->y, v1->z < v2->z ? v1->z : v2->z);
+	return out;
+}
+
+inline Vector3* Vec3Maximize(Vector3* out, const Vector3* v1, const Vector3* v2)
+{
+	*out = Vector3(v1->x > v2->x ? v1->x : v2->x, v1->y > v2->y ? v1->y : v2->y, v1->z > v2->z ? v1->z : v2->z);
+	return out;
+}
+
+// (x, y, z, 1) * m, divided by w
+inline Vector3* Vec3TransformCoord(Vector3* out, const Vector3* v, const Matrix* m)
+{
+	float x = v->x * m->_11 + v->y * m->_21 + v->z * m->_31 + m->_41;
+	float y = v->x * m->_12 + v->y * m->_22 + v->z * m->_32 + m->_42;
+	float z = v->x * m->_13 + v->y * m->_23 + v->z * m->_33 + m->_43;
+	float w = v->x * m->_14 + v->y * m->_24 + v->z * m->_34 + m->_44;
+
+	float inv_w = w != 0 ? 1.0f / w : 0.0f;
+	*out = Vector3(x * inv_w, y * inv_w, z * inv_w);
+	return out;
+}
+
+// (x, y, z, 0) * m, no translation
+inline Vector3* Vec3TransformNormal(Vector3* out, const Vector3* v, const Matrix* m)
+{
+	float x = v->x * m->_11 + v->y * m->_21 + v->z * m->_31;
+	float y = v->x * m->_12 + v->y * m->_22 + v->z * m->_32;
+	float z = v->x * m->_13 + v->y * m->_23 + v->z * m->_33;
+
+	*out = Vector3(x, y, z);
+	return out;
+}
+
+inline void Vec3TransformCoordArrayScalar(Vector3* out, const Vector3* v, int count, const Matrix* m)
+{
+	for (int i = 0; i < count; ++i)
+		Vec3TransformCoord(&out[i], &v[i], m);
+}
+
+// Vec3TransformCoord on count vectors, out may be v
+inline void Vec3TransformCoordArray(Vector3* out, const Vector3* v, int count, const Matrix* m)
+{
+#if defined(MATH_SSE)
+	__m128 row0 = _mm_loadu_ps(m->m[0]);
+	__m128 row1 = _mm_loadu_ps(m->m[1]);
+	__m128 row2 = _mm_loadu_ps(m->m[2]);
+	__m128 row3 = _mm_loadu_ps(m->m[3]);
+
+	for (int i = 0; i < count; ++i)
+	{
+		__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[i].x), row0), _mm_mul_ps(_mm_set1_ps(v[i].y), row1)),
+							  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[i].z), row2), row3));
+
+		float result[4];
+		_mm_storeu_ps(result, r);
+
+		float inv_w = result[3] != 0 ? 1.0f / result[3] : 0.0f;
+		out[i] = Vector3(result[0] * inv_w, result[1] * inv_w, result[2] * inv_w);
+	}
+#elif defined(MATH_NEON)
+	float32x4_t row0 = vld1q_f32(m->m[0]);
+	float32x4_t row1 = vld1q_f32(m->m[1]);
+	float32x4_t row2 = vld1q_f32(m->m[2]);
+	float32x4_t row3 = vld1q_f32(m->m[3]);
+
+	for (int i = 0; i < count; ++i)
+	{
+		float32x4_t r = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(row3, row0, v[i].x), row1, v[i].y), row2, v[i].z);
+
+		float result[4];
+		vst1q_f32(result, r);
+
+		float inv_w = result[3] != 0 ? 1.0f / result[3] : 0.0f;
+		out[i] = Vector3(result[0] * inv_w, result[1] * inv_w, result[2] * inv_w);
+	}
+#else
+	Vec3TransformCoordArrayScalar(out, v, count, m);
+#endif
+}
+
+// Matrix
+
+inline Matrix* MatrixIdentity(Matrix* out)
+{
+	*out = Matrix(1, 0, 0, 0,
+				  0, 1, 0, 0,
+				  0, 0, 1, 0,
+				  0, 0, 0, 1);
+	return out;
+}
+
+inline Matrix* MatrixMultiplyScalar(Matrix* out, const Matrix* m1, const Matrix* m2)
+{
+	Matrix result;
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			result.m[i][j] = m1->m[i][0] * m2->m[0][j] + m1->m[i][1] * m2->m[1][j]
+						   + m1->m[i][2] * m2->m[2][j] + m1->m[i][3] * m2->m[3][j];
+		}
+	}
+
+	*out = result;
+	return out;
+}
+
+// m1 * m2, out may be m1 or m2. Row i of the result is row i of m1 times m2, a sum of the rows of m2.
+inline Matrix* MatrixMultiply(Matrix* out, const Matrix* m1, const Matrix* m2)
+{
+#if defined(MATH_SSE)
+	__m128 row0 = _mm_loadu_ps(m2->m[0]);
+	__m128 row1 = _mm_loadu_ps(m2->m[1]);
+	__m128 row2 = _mm_loadu_ps(m2->m[2]);
+	__m128 row3 = _mm_loadu_ps(m2->m[3]);
+
+	__m128 result[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		result[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m1->m[i][0]), row0), _mm_mul_ps(_mm_set1_ps(m1->m[i][1]), row1)),
+							   _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m1->m[i][2]), row2), _mm_mul_ps(_mm_set1_ps(m1->m[i][3]), row3)));
+	}
+
+	for (int i = 0; i < 4; ++i)
+		_mm_storeu_ps(out->m[i], result[i]);
+	return out;
+#elif defined(MATH_NEON)
+	float32x4_t row0 = vld1q_f32(m2->m[0]);
+	float32x4_t row1 = vld1q_f32(m2->m[1]);
+	float32x4_t row2 = vld1q_f32(m2->m[2]);
+	float32x4_t row3 = vld1q_f32(m2->m[3]);
+
+	float32x4_t result[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		result[i] = vmulq_n_f32(row0, m1->m[i][0]);
+		result[i] = vmlaq_n_f32(result[i], row1, m1->m[i][1]);
+		result[i] = vmlaq_n_f32(result[i], row2, m1->m[i][2]);
+		result[i] = vmlaq_n_f32(result[i], row3, m1->m[i][3]);
+	}
+
+	for (int i = 0; i < 4; ++i)
+		vst1q_f32(out->m[i], result[i]);
+	return out;
+#else
+	return MatrixMultiplyScalar(out, m1, m2);
+#endif
+}
+
+inline Matrix* MatrixTranspose(Matrix* out, const Matrix* m)
+{
+	Matrix result;
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+			result.m[i][j] = m->m[j][i];
+	}
+
+	*out = result;
+	return out;
+}
+
+// General inverse by cofactors, determinant(out) may be NULL. Return NULL if m is singular, out is not changed then.
+inline Matrix* MatrixInverse(Matrix* out, float* determinant, const Matrix* m)
+{
+	const float* a = *m;
+	float inv[16];
+
+	inv[0]  =  a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+	inv[4]  = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+	inv[8]  =  a[4] * a[9]  * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+	inv[12] = -a[4] * a[9]  * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+	inv[1]  = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+	inv[5]  =  a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+	inv[9]  = -a[0] * a[9]  * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+	inv[13] =  a[0] * a[9]  * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+	inv[2]  =  a[1] * a[6]  * a[15] - a[1] * a[7]  * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7]  - a[13] * a[3] * a[6];
+	inv[6]  = -a[0] * a[6]  * a[15] + a[0] * a[7]  * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7]  + a[12] * a[3] * a[6];
+	inv[10] =  a[0] * a[5]  * a[15] - a[0] * a[7]  * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7]  - a[12] * a[3] * a[5];
+	inv[14] = -a[0] * a[5]  * a[14] + a[0] * a[6]  * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6]  + a[12] * a[2] * a[5];
+	inv[3]  = -a[1] * a[6]  * a[11] + a[1] * a[7]  * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9]  * a[2] * a[7]  + a[9]  * a[3] * a[6];
+	inv[7]  =  a[0] * a[6]  * a[11] - a[0] * a[7]  * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8]  * a[2] * a[7]  - a[8]  * a[3] * a[6];
+	inv[11] = -a[0] * a[5]  * a[11] + a[0] * a[7]  * a[9]  + a[4] * a[1] * a[11] - a[4] * a[3] * a[9]  - a[8]  * a[1] * a[7]  + a[8]  * a[3] * a[5];
+	inv[15] =  a[0] * a[5]  * a[10] - a[0] * a[6]  * a[9]  - a[4] * a[1] * a[10] + a[4] * a[2] * a[9]  + a[8]  * a[1] * a[6]  - a[8]  * a[2] * a[5];
+
+	float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+	if (determinant != NULL)
+		*determinant = det;
+	if (det == 0)
+		return NULL;
+
+	float inv_det = 1.0f / det;
+	for (int i = 0; i < 16; ++i)
+		inv[i] *= inv_det;
+
+	*out = Matrix(inv);
+	return out;
+}
+
+inline Matrix* MatrixTranslation(Matrix* out, float x, float y, float z)
+{
+	MatrixIdentity(out);
+	out->_41 = x;
+	out->_42 = y;
+	out->_43 = z;
+	return out;
+}
+
+inline Matrix* MatrixScaling(Matrix* out, float x, float y, float z)
+{
+	MatrixIdentity(out);
+	out->_11 = x;
+	out->_22 = y;
+	out->_33 = z;
+	return out;
+}
+
+inline Matrix* MatrixRotationX(Matrix* out, float angle)
+{
+	float c = cosf(angle);
+	float s = sinf(angle);
+
+	MatrixIdentity(out);
+	out->_22 =  c;
+	out->_23 =  s;
+	out->_32 = -s;
+	out->_33 =  c;
+	return out;
+}
+
+// Rotation around the axis(normalized here), clockwise when looking along the axis toward the origin
+inline Matrix* MatrixRotationAxis(Matrix* out, const Vector3* axis, float angle)
+{
+	Vector3 v;
+	Vec3Normalize(&v, axis);
+
+	float c = cosf(angle);
+	float s = sinf(angle);
+	float t = 1.0f - c;
+
+	*out = Matrix(t * v.x * v.x + c,       t * v.x * v.y + s * v.z, t * v.x * v.z - s * v.y, 0,
+				  t * v.x * v.y - s * v.z, t * v.y * v.y + c,       t * v.y * v.z + s * v.x, 0,
+				  t * v.x * v.z + s * v.y, t * v.y * v.z - s * v.x, t * v.z * v.z + c,       0,
+				  0,                       0,                       0,                       1);
+	return out;
+}
+
+inline Matrix* MatrixRotationQuaternion(Matrix* out, const Quaternion* q)
+{
+	float xx = q->x * q->x, yy = q->y * q->y, zz = q->z * q->z;
+	float xy = q->x * q->y, xz = q->x * q->z, yz = q->y * q->z;
+	float wx = q->w * q->x, wy = q->w * q->y, wz = q->w * q->z;
+
+	*out = Matrix(1 - 2 * (yy + zz), 2 * (xy + wz),     2 * (xz - wy),     0,
+				  2 * (xy - wz),     1 - 2 * (xx + zz), 2 * (yz + wx),     0,
+				  2 * (xz + wy),     2 * (yz - wx),     1 - 2 * (xx + yy), 0,
+				  0,                 0,                 0,                 1);
+	return out;
+}
+
+inline Matrix* MatrixLookAtLH(Matrix* out, const Vector3* eye, const Vector3* at, const Vector3* up)
+{
+	Vector3 z_axis = *at - *eye;
+	Vec3Normalize(&z_axis, &z_axis);
+
+	Vector3 x_axis;
+	Vec3Cross(&x_axis, up, &z_axis);
+	Vec3Normalize(&x_axis, &x_axis);
+
+	Vector3 y_axis;
+	Vec3Cross(&y_axis, &z_axis, &x_axis);
+
+	*out = Matrix(x_axis.x, y_axis.x, z_axis.x, 0,
+				  x_axis.y, y_axis.y, z_axis.y, 0,
+				  x_axis.z, y_axis.z, z_axis.z, 0,
+				  -Vec3Dot(&x_axis, eye), -Vec3Dot(&y_axis, eye), -Vec3Dot(&z_axis, eye), 1);
+	return out;
+}
+
+inline Matrix* MatrixPerspectiveFovLH(Matrix* out, float fov_y, float aspect, float near_plane, float far_plane)
+{
+	float y_scale = 1.0f / tanf(fov_y / 2);
+	float x_scale = y_scale / aspect;
+	float z_scale = far_plane / (far_plane - near_plane);
+
+	*out = Matrix(x_scale, 0,       0,                     0,
+				  0,       y_scale, 0,                     0,
+				  0,       0,       z_scale,               1,
+				  0,       0,       -near_plane * z_scale, 0);
+	return out;
+}
+
+inline Matrix Matrix::operator*(const Matrix& matrix) const
+{
+	Matrix result;
+	MatrixMultiply(&result, this, &matrix);
+	return result;
+}
+
+inline Matrix& Matrix::operator*=(const Matrix& matrix)
+{
+	MatrixMultiply(this, this, &matrix);
+	return *this;
+}
+
+// Quaternion
+
+inline Quaternion* QuaternionIdentity(Quaternion* out)
+{
+	*out = Quaternion(0, 0, 0, 1);
+	return out;
+}
+
+inline Quaternion* QuaternionNormalize(Quaternion* out, const Quaternion* q)
+{
+	float length = sqrtf(q->x * q->x + q->y * q->y + q->z * q->z + q->w * q->w);
+	if (length == 0)
+		*out = Quaternion(0, 0, 0, 0);
+	else
+		*out = Quaternion(q->x / length, q->y / length, q->z / length, q->w / length);
+	return out;
+}
+
+inline Quaternion* QuaternionInverse(Quaternion* out, const Quaternion* q)
+{
+	float norm = q->x * q->x + q->y * q->y + q->z * q->z + q->w * q->w;
+	if (norm == 0)
+		norm = 1;
+	*out = Quaternion(-q->x / norm, -q->y / norm, -q->z / norm, q->w / norm);
+	return out;
+}
+
+// The rotation q1 followed by q2, which is the product q2 * q1
+inline Quaternion* QuaternionMultiply(Quaternion* out, const Quaternion* q1, const Quaternion* q2)
+{
+	const Quaternion& a = *q2;
+	const Quaternion& b = *q1;
+
+	*out = Quaternion(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+					  a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+					  a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+					  a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+	return out;
+}
+
+// Rotation around the axis(normalized here), the same rotation as MatrixRotationAxis
+inline Quaternion* QuaternionRotationAxis(Quaternion* out, const Vector3* axis, float angle)
+{
+	Vector3 v;
+	Vec3Normalize(&v, axis);
+
+	float s = sinf(angle / 2);
+	*out = Quaternion(v.x * s, v.y * s, v.z * s, cosf(angle / 2));
+	return out;
+}
+
+// Spherical interpolation from q1(t = 0) to q2(t = 1) along the shorter arc
+inline Quaternion* QuaternionSlerp(Quaternion* out, const Quaternion* q1, const Quaternion* q2, float t)
+{
+	float cos_theta = q1->x * q2->x + q1->y * q2->y + q1->z * q2->z + q1->w * q2->w;
+	float sign = 1.0f;
+	if (cos_theta < 0)
+	{
+		cos_theta = -cos_theta;
+		sign = -1.0f;
+	}
+
+	float s1 = 1.0f - t;
+	float s2 = t;
+
+	// Nearly the same rotation, interpolate linearly
+	if (cos_theta < 0.9999f)
+	{
+		float theta = acosf(cos_theta);
+		float inv_sin = 1.0f / sinf(theta);
+		s1 = sinf((1.0f - t) * theta) * inv_sin;
+		s2 = sinf(t * theta) * inv_sin;
+	}
+	s2 *= sign;
+
+	*out = Quaternion(s1 * q1->x + s2 * q2->x,
+					  s1 * q1->y + s2 * q2->y,
+					  s1 * q1->z + s2 * q2->z,
+					  s1 * q1->w + s2 * q2->w);
+	return out;
+}
+
+inline Quaternion Quaternion::operator*(const Quaternion& q) const
+{
+	Quaternion result;
+	QuaternionMultiply(&result, this, &q);
+	return result;
+}
+
+inline Quaternion& Quaternion::operator*=(const Quaternion& q)
+{
+	QuaternionMultiply(this, this, &q);
+	return *this;
+}
+
+// Plane
+
+inline Plane* PlaneNormalize(Plane* out, const Plane* p)
+{
+	float length = sqrtf(p->a * p->a + p->b * p->b + p->c * p->c);
+	float inv_length = length != 0 ? 1.0f / length : 0.0f;
+	*out = Plane(p->a * inv_length, p->b * inv_length, p->c * inv_length, p->d * inv_length);
+	return out;
+}
+
+// Signed distance from the point to a normalized plane
+inline float PlaneDotCoord(const Plane* p, const Vector3* v)
+{
+	return p->a * v->x + p->b * v->y + p->c * v->z + p->d;
+}
+
+#endif // end __VECTOR_MATH_H__